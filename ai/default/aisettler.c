@@ -19,6 +19,7 @@
 #include <string.h>
 
 /* utility */
+#include "fcthread.h"
 #include "mem.h"
 #include "log.h"
 #include "support.h" 
@@ -28,10 +29,12 @@
 #include "city.h"
 #include "game.h"
 #include "government.h"
+#include "improvement.h"
 #include "map.h"
 #include "movement.h"
 #include "packets.h"
 #include "player.h"
+#include "research.h"
 
 /* common/aicore */
 #include "citymap.h"
@@ -141,9 +144,27 @@ static void tile_data_cache_destroy(struct tile_data_cache *ptdc);
 #define SPECHASH_IDATA_FREE tile_data_cache_destroy
 #include "spechash.h"
 
-struct ai_settler {
-  struct tile_data_cache_hash *tdc_hash;
+/* Tile outputs for a virtual city, shared by all AI players and kept
+ * between turns. An entry is valid for players with the same signature
+ * as long as the tile itself does not change. */
+struct tdc_shared {
+  char food;
+  char trade;
+  char shield;
+  bool valid;
+  unsigned int tile_sig;
+  unsigned int plr_sig;
+};
+
+static struct tdc_shared *tdc_shared = NULL;
+static int tdc_shared_size = 0;
+static int tdc_shared_users = 0;
 
+/* Number of candidate sites whose surroundings are prefetched at once
+ * in threaded city site search. */
+#define SITE_CHUNK_SIZE 32
+
+struct ai_settler {
 #ifdef FREECIV_DEBUG
   struct {
     int hit;
@@ -183,11 +204,14 @@ struct cityresult {
   int city_radius_sq;     /* current squared radius of the city */
 };
 
-static const struct tile_data_cache *tdc_plr_get(struct ai_type *ait,
-                                                 struct player *plr,
-                                                 int tindex);
-static void tdc_plr_set(struct ai_type *ait, struct player *plr, int tindex,
-                        const struct tile_data_cache *tdcache);
+static bool tdc_shareable(void);
+static unsigned int tdc_plr_sig(struct player *plr);
+static bool tdc_shared_get(struct ai_type *ait, struct player *plr,
+                           const struct tile *ptile, unsigned int plr_sig,
+                           struct tile_data_cache *ptdc);
+static void tdc_shared_alloc(void);
+static void tdc_shared_set(const struct tile *ptile, unsigned int plr_sig,
+                           const struct tile_data_cache *ptdc);
 
 static struct cityresult *cityresult_new(struct tile *ptile);
 static void cityresult_destroy(struct cityresult *result);
@@ -205,6 +229,12 @@ static void print_cityresult(struct player *pplayer,
 struct cityresult *city_desirability(struct ai_type *ait,
                                      struct player *pplayer,
                                      struct unit *punit, struct tile *ptile);
+static bool city_desirability_possible(struct player *pplayer,
+                                       struct unit *punit,
+                                       struct tile *ptile);
+static struct cityresult *city_desirability_eval(struct ai_type *ait,
+                                                 struct player *pplayer,
+                                                 struct tile *ptile);
 static struct cityresult *settler_map_iterate(struct ai_type *ait,
                                               struct pf_parameter *parameter,
                                               struct unit *punit,
@@ -283,11 +313,14 @@ static struct cityresult *cityresult_fill(struct ai_type *ait,
   struct adv_data *adv = adv_data_get(pplayer, NULL);
   struct ai_plr *ai = dai_plr_data_get(ait, pplayer, NULL);
   struct cityresult *result;
+  bool shared = tdc_shareable();
+  unsigned int plr_sig;
 
   fc_assert_ret_val(ai != NULL, NULL);
   fc_assert_ret_val(center != NULL, NULL);
 
   pplayer->government = adv->goal.govt.gov;
+  plr_sig = tdc_plr_sig(pplayer);
 
   /* Create a city result and set default values. */
   result = cityresult_new(center);
@@ -305,7 +338,6 @@ static struct cityresult *cityresult_fill(struct ai_type *ait,
 
   city_tile_iterate_index(result->city_radius_sq, result->tile, ptile,
                           cindex) {
-    int tindex = tile_index(ptile);
     int reserved = citymap_read(ptile);
     bool city_center = (result->tile == ptile); /*is_city_center()*/
     struct tile_data_cache *ptdc;
@@ -322,34 +354,37 @@ static struct cityresult *cityresult_fill(struct ai_type *ait,
       ptdc->reserved = reserved;
       /* ptdc->turn was set by tile_data_cache_new(). */
     } else {
-      const struct tile_data_cache *ptdc_hit = tdc_plr_get(ait, pplayer, tindex);
-      if (!ptdc_hit || city_center) {
-        /* We cannot read city center from cache */
-        ptdc = tile_data_cache_new();
+      ptdc = tile_data_cache_new();
 
+      /* We cannot read city center from cache */
+      if (city_center || !shared
+          || !tdc_shared_get(ait, pplayer, ptile, plr_sig, ptdc)) {
         /* Food */
         ptdc->food = city_tile_output(pcity, ptile, FALSE, O_FOOD);
         /* Shields */
         ptdc->shield = city_tile_output(pcity, ptile, FALSE, O_SHIELD);
         /* Trade */
         ptdc->trade = city_tile_output(pcity, ptile, FALSE, O_TRADE);
-        /* Weighted sum */
-        ptdc->sum = ptdc->food * adv->food_priority
-                    + ptdc->trade * adv->science_priority
-                    + ptdc->shield * adv->shield_priority;
-        /* Balance perfection */
-        ptdc->sum *= PERFECTION / 2;
-        if (ptdc->food >= 2) {
-          ptdc->sum *= 2; /* we need this to grow */
-        }
 
-        if (!city_center && virtual_city) {
+        if (!city_center && virtual_city && shared) {
           /* real cities and any city center will give us spossibly
            * skewed results */
-          tdc_plr_set(ait, pplayer, tindex, tile_data_cache_copy(ptdc));
+          tdc_shared_alloc();
+          tdc_shared_set(ptile, plr_sig, ptdc);
+#ifdef FREECIV_DEBUG
+          ai->settler->cache.save++;
+#endif /* FREECIV_DEBUG */
         }
-      } else {
-        ptdc = tile_data_cache_copy(ptdc_hit);
+      }
+
+      /* Weighted sum */
+      ptdc->sum = ptdc->food * adv->food_priority
+                  + ptdc->trade * adv->science_priority
+                  + ptdc->shield * adv->shield_priority;
+      /* Balance perfection */
+      ptdc->sum *= PERFECTION / 2;
+      if (ptdc->food >= 2) {
+        ptdc->sum *= 2; /* we need this to grow */
       }
     }
 
@@ -497,58 +532,155 @@ static void tile_data_cache_destroy(struct tile_data_cache *ptdc)
 }
 
 /*************************************************************************//**
-  Return player's tile data cache
+  Combine value into signature.
 *****************************************************************************/
-static const struct tile_data_cache *tdc_plr_get(struct ai_type *ait,
-                                                 struct player *plr,
-                                                 int tindex)
+static inline unsigned int tdc_sig_mix(unsigned int sig, unsigned int val)
 {
-  struct ai_plr *ai = dai_plr_data_get(ait, plr, NULL);
+  return sig ^ (val + 0x9e3779b9 + (sig << 6) + (sig >> 2));
+}
 
-  fc_assert_ret_val(ai != NULL, NULL);
-  fc_assert_ret_val(ai->settler != NULL, NULL);
-  fc_assert_ret_val(ai->settler->tdc_hash != NULL, NULL);
+/*************************************************************************//**
+  Signature of the tile properties tile outputs depend on.
+*****************************************************************************/
+static unsigned int tdc_tile_sig(const struct tile *ptile)
+{
+  const struct terrain *pterrain = tile_terrain(ptile);
+  const struct player *owner = tile_owner(ptile);
+  unsigned int sig = tile_index(ptile);
+  size_t i;
+
+  sig = tdc_sig_mix(sig, pterrain != NULL ? terrain_number(pterrain) + 1 : 0);
+  sig = tdc_sig_mix(sig, owner != NULL ? player_number(owner) + 1 : 0);
+  sig = tdc_sig_mix(sig, tile_resource(ptile) != NULL
+                         ? extra_number(tile_resource(ptile)) + 1 : 0);
+  for (i = 0; i < ARRAY_SIZE(ptile->extras.vec); i++) {
+    sig = tdc_sig_mix(sig, ptile->extras.vec[i]);
+  }
 
-  struct tile_data_cache *ptdc;
+  return sig;
+}
 
-  tile_data_cache_hash_lookup(ai->settler->tdc_hash, tindex, &ptdc);
+/*************************************************************************//**
+  Returns TRUE if tile outputs of new virtual cities can be kept in the
+  shared tile data cache: the effects city_tile_output() looks at must
+  not depend on other inputs than the tile and player signatures.
+*****************************************************************************/
+static bool tdc_shareable(void)
+{
+  return (effect_type_site_shareable(EFT_MINING_PCT)
+          && effect_type_site_shareable(EFT_IRRIGATION_PCT)
+          && effect_type_site_shareable(EFT_OUTPUT_ADD_TILE)
+          && effect_type_site_shareable(EFT_OUTPUT_PENALTY_TILE)
+          && effect_type_site_shareable(EFT_OUTPUT_INC_TILE)
+          && effect_type_site_shareable(EFT_OUTPUT_PER_TILE)
+          && effect_type_site_shareable(EFT_OUTPUT_TILE_PUNISH_PCT));
+}
 
-  if (!ptdc) {
+/*************************************************************************//**
+  Return signature of the player wide inputs of tile outputs: current
+  government, nation, multipliers, known techs and wonders. Players with
+  equal signatures share tile data cache entries. Must be called with the
+  goal government set as the government of the player, as
+  cityresult_fill() does.
+*****************************************************************************/
+static unsigned int tdc_plr_sig(struct player *plr)
+{
+  const struct research *presearch = research_get(plr);
+  struct government *gov = government_of_player(plr);
+  unsigned int sig;
+
+  sig = tdc_sig_mix(0, gov != NULL ? government_number(gov) + 1 : 0);
+  sig = tdc_sig_mix(sig, nation_number(nation_of_player(plr)));
+  multipliers_iterate(pmul) {
+    sig = tdc_sig_mix(sig, plr->multipliers[multiplier_index(pmul)]);
+  } multipliers_iterate_end;
+  advance_index_iterate(A_FIRST, tech) {
+    sig = tdc_sig_mix(sig, research_invention_state(presearch, tech));
+    sig = tdc_sig_mix(sig, game.info.global_advances[tech]);
+  } advance_index_iterate_end;
+  improvement_iterate(pimprove) {
+    if (is_great_wonder(pimprove)) {
+      sig = tdc_sig_mix(sig, game.info.great_wonder_owners
+                                 [improvement_index(pimprove)]);
+    }
+    if (is_wonder(pimprove)) {
+      sig = tdc_sig_mix(sig, wonder_is_built(plr, pimprove));
+    }
+  } improvement_iterate_end;
+
+  return sig;
+}
+
+/*************************************************************************//**
+  Fill tile outputs of ptdc from the shared tile data cache. Returns FALSE
+  if there is no valid entry for the tile and player signature.
+*****************************************************************************/
+static bool tdc_shared_get(struct ai_type *ait, struct player *plr,
+                           const struct tile *ptile, unsigned int plr_sig,
+                           struct tile_data_cache *ptdc)
+{
+#ifdef FREECIV_DEBUG
+  struct ai_plr *ai = dai_plr_data_get(ait, plr, NULL);
+#endif /* FREECIV_DEBUG */
+  const struct tdc_shared *pentry;
+
+  if (tdc_shared_size != MAP_INDEX_SIZE
+      || !tdc_shared[tile_index(ptile)].valid) {
 #ifdef FREECIV_DEBUG
     ai->settler->cache.miss++;
 #endif /* FREECIV_DEBUG */
-    return NULL;
-  } else if (ptdc->turn != game.info.turn) {
+    return FALSE;
+  }
+
+  pentry = &tdc_shared[tile_index(ptile)];
+  if (pentry->plr_sig != plr_sig || pentry->tile_sig != tdc_tile_sig(ptile)) {
 #ifdef FREECIV_DEBUG
     ai->settler->cache.old++;
 #endif /* FREECIV_DEBUG */
-    return NULL;
-  } else {
+    return FALSE;
+  }
+
 #ifdef FREECIV_DEBUG
-    ai->settler->cache.hit++;
+  ai->settler->cache.hit++;
 #endif /* FREECIV_DEBUG */
-    return ptdc;
-  }
+
+  ptdc->food = pentry->food;
+  ptdc->trade = pentry->trade;
+  ptdc->shield = pentry->shield;
+
+  return TRUE;
 }
 
 /*************************************************************************//**
-  Store player's tile data cache
+  Make sure the shared tile data cache matches the map size. The map may
+  be created after the AI players.
 *****************************************************************************/
-static void tdc_plr_set(struct ai_type *ait, struct player *plr, int tindex,
-                        const struct tile_data_cache *ptdc)
+static void tdc_shared_alloc(void)
 {
-  struct ai_plr *ai = dai_plr_data_get(ait, plr, NULL);
-
-  fc_assert_ret(ai != NULL);
-  fc_assert_ret(ai->settler != NULL);
-  fc_assert_ret(ai->settler->tdc_hash != NULL);
-  fc_assert_ret(ptdc != NULL);
-
-#ifdef FREECIV_DEBUG
-    ai->settler->cache.save++;
-#endif /* FREECIV_DEBUG */
+  if (tdc_shared_size != MAP_INDEX_SIZE) {
+    tdc_shared = fc_realloc(tdc_shared, MAP_INDEX_SIZE * sizeof(*tdc_shared));
+    memset(tdc_shared, 0, MAP_INDEX_SIZE * sizeof(*tdc_shared));
+    tdc_shared_size = MAP_INDEX_SIZE;
+  }
+}
 
-  tile_data_cache_hash_replace(ai->settler->tdc_hash, tindex, ptdc);
+/*************************************************************************//**
+  Store tile outputs of ptdc to the shared tile data cache. Threads may
+  store entries of different tiles concurrently, once tdc_shared_alloc()
+  has been called.
+*****************************************************************************/
+static void tdc_shared_set(const struct tile *ptile, unsigned int plr_sig,
+                           const struct tile_data_cache *ptdc)
+{
+  struct tdc_shared *pentry;
+
+  pentry = &tdc_shared[tile_index(ptile)];
+  pentry->food = ptdc->food;
+  pentry->trade = ptdc->trade;
+  pentry->shield = ptdc->shield;
+  pentry->tile_sig = tdc_tile_sig(ptile);
+  pentry->plr_sig = plr_sig;
+  pentry->valid = TRUE;
 }
 
 /*************************************************************************//**
@@ -693,54 +825,60 @@ static void print_cityresult(struct player *pplayer,
 }
 
 /*************************************************************************//**
-  Calculates the desire for founding a new city at 'ptile'. The citymap
-  ensures that we do not build cities too close to each other. Returns NULL
-  if no place was found.
+  Quick checks whether founding a new city at 'ptile' can be considered
+  at all, before the expensive evaluation of city_desirability_eval().
 *****************************************************************************/
-struct cityresult *city_desirability(struct ai_type *ait, struct player *pplayer,
-                                     struct unit *punit, struct tile *ptile)
+static bool city_desirability_possible(struct player *pplayer,
+                                       struct unit *punit,
+                                       struct tile *ptile)
 {
   struct city *pcity = tile_city(ptile);
-  struct adv_data *ai = adv_data_get(pplayer, NULL);
-  struct cityresult *cr = NULL;
-
-  fc_assert_ret_val(punit, NULL);
-  fc_assert_ret_val(pplayer, NULL);
-  fc_assert_ret_val(ai, NULL);
 
   if (!city_can_be_built_here(ptile, punit)
       || (has_handicap(pplayer, H_MAP)
           && !map_is_known(ptile, pplayer))) {
-    return NULL;
+    return FALSE;
   }
 
   /* Check if another settler has taken a spot within mindist */
   square_iterate(&(wld.map), ptile, game.info.citymindist-1, tile1) {
     if (citymap_is_reserved(tile1)) {
-      return NULL;
+      return FALSE;
     }
   } square_iterate_end;
 
   if (adv_danger_at(punit, ptile)) {
-    return NULL;
+    return FALSE;
   }
 
   if (pcity && (city_size_get(pcity) + unit_pop_value(punit)
                 > game.info.add_to_size_limit)) {
     /* Can't exceed population limit. */
-    return NULL;
+    return FALSE;
   }
 
   if (!pcity && citymap_is_reserved(ptile)) {
-    return NULL; /* reserved, go away */
+    return FALSE; /* reserved, go away */
   }
 
   /* If (x, y) is an existing city, consider immigration */
   if (pcity && city_owner(pcity) == pplayer) {
-    return NULL;
+    return FALSE;
   }
 
-  cr = cityresult_fill(ait, pplayer, ptile); /* Burn CPU, burn! */
+  return TRUE;
+}
+
+/*************************************************************************//**
+  Calculates the desire for founding a new city at 'ptile' that passed
+  city_desirability_possible(). Returns NULL if the place is not good.
+*****************************************************************************/
+static struct cityresult *city_desirability_eval(struct ai_type *ait,
+                                                 struct player *pplayer,
+                                                 struct tile *ptile)
+{
+  struct cityresult *cr = cityresult_fill(ait, pplayer, ptile); /* Burn CPU, burn! */
+
   if (!cr) {
     /* Failed to find a good spot */
     return NULL;
@@ -764,6 +902,244 @@ struct cityresult *city_desirability(struct ai_type *ait, struct player *pplayer
   return cr;
 }
 
+/*************************************************************************//**
+  Calculates the desire for founding a new city at 'ptile'. The citymap
+  ensures that we do not build cities too close to each other. Returns NULL
+  if no place was found.
+*****************************************************************************/
+struct cityresult *city_desirability(struct ai_type *ait, struct player *pplayer,
+                                     struct unit *punit, struct tile *ptile)
+{
+  struct adv_data *ai = adv_data_get(pplayer, NULL);
+
+  fc_assert_ret_val(punit, NULL);
+  fc_assert_ret_val(pplayer, NULL);
+  fc_assert_ret_val(ai, NULL);
+
+  if (!city_desirability_possible(pplayer, punit, ptile)) {
+    return NULL;
+  }
+
+  return city_desirability_eval(ait, pplayer, ptile);
+}
+
+/* Tile whose outputs are calculated by a site prefetch thread. */
+struct site_prefetch_job {
+  struct city *pcity;           /* Virtual city at one of the sites */
+  struct tile *ptile;
+};
+
+struct site_prefetch_data {
+  const struct site_prefetch_job *jobs;
+  int first, last;
+  unsigned int plr_sig;
+};
+
+/*************************************************************************//**
+  Calculate tile outputs of a range of prefetch jobs to the shared tile
+  data cache. Only reads the game state.
+*****************************************************************************/
+static void site_prefetch_run(void *arg)
+{
+  const struct site_prefetch_data *data = arg;
+  int i;
+
+  for (i = data->first; i < data->last; i++) {
+    const struct site_prefetch_job *job = &data->jobs[i];
+    struct tile_data_cache tdc;
+
+    tdc.food = city_tile_output(job->pcity, job->ptile, FALSE, O_FOOD);
+    tdc.shield = city_tile_output(job->pcity, job->ptile, FALSE, O_SHIELD);
+    tdc.trade = city_tile_output(job->pcity, job->ptile, FALSE, O_TRADE);
+    tdc_shared_set(job->ptile, data->plr_sig, &tdc);
+  }
+}
+
+/*************************************************************************//**
+  Fill the shared tile data cache for the tiles around the candidate
+  sites in 'game.server.citysite_threads' threads, so that the following
+  cityresult_fill() calls find them there. Virtual cities are created and
+  destroyed, and the government is switched, in the calling thread only;
+  the threads just calculate tile outputs.
+*****************************************************************************/
+static void settler_sites_prefetch(struct ai_type *ait,
+                                   struct player *pplayer,
+                                   struct tile **sites, int num_sites)
+{
+  struct adv_data *adv = adv_data_get(pplayer, NULL);
+  struct government *curr_govt = government_of_player(pplayer);
+  bool handicap = has_handicap(pplayer, H_MAP);
+  struct city *vcities[SITE_CHUNK_SIZE];
+  struct site_prefetch_job *jobs;
+  struct tile_hash *queued;
+  unsigned int plr_sig;
+  int num_vcities = 0, num_jobs = 0, jobs_size;
+  int nthreads, i;
+
+  fc_assert_ret(num_sites <= SITE_CHUNK_SIZE);
+
+  if (!tdc_shareable()) {
+    /* Nothing to prefetch: cityresult_fill() will not read the cache. */
+    return;
+  }
+
+  pplayer->government = adv->goal.govt.gov;
+  plr_sig = tdc_plr_sig(pplayer);
+  tdc_shared_alloc();
+
+  jobs_size = num_sites * city_map_tiles(game.info.init_city_radius_sq);
+  jobs = fc_malloc(MAX(1, jobs_size) * sizeof(*jobs));
+  queued = tile_hash_new();
+
+  for (i = 0; i < num_sites; i++) {
+    struct city *pcity;
+
+    if (tile_city(sites[i]) != NULL) {
+      /* Real cities are not cached. */
+      continue;
+    }
+
+    pcity = create_city_virtual(pplayer, sites[i], "Virtuaville");
+    vcities[num_vcities++] = pcity;
+
+    city_tile_iterate(city_map_radius_sq_get(pcity), sites[i], ptile) {
+      struct tile_data_cache tdc;
+
+      if (ptile == sites[i]
+          || citymap_read(ptile) < 0
+          || (handicap && !map_is_known(ptile, pplayer))
+          || NULL != tile_worked(ptile)
+          || num_jobs >= jobs_size) {
+        continue;
+      }
+      if (tdc_shared_get(ait, pplayer, ptile, plr_sig, &tdc)
+          || !tile_hash_insert(queued, ptile, NULL)) {
+        /* Already known or queued. */
+        continue;
+      }
+
+      jobs[num_jobs].pcity = pcity;
+      jobs[num_jobs].ptile = ptile;
+      num_jobs++;
+    } city_tile_iterate_end;
+  }
+
+  nthreads = MIN(game.server.citysite_threads, num_jobs / 8);
+  if (nthreads <= 1) {
+    struct site_prefetch_data data = { jobs, 0, num_jobs, plr_sig };
+
+    site_prefetch_run(&data);
+  } else {
+    fc_thread *threads = fc_calloc(nthreads, sizeof(*threads));
+    bool *started = fc_calloc(nthreads, sizeof(*started));
+    struct site_prefetch_data *data = fc_calloc(nthreads, sizeof(*data));
+
+    for (i = 0; i < nthreads; i++) {
+      data[i].jobs = jobs;
+      data[i].first = num_jobs * i / nthreads;
+      data[i].last = num_jobs * (i + 1) / nthreads;
+      data[i].plr_sig = plr_sig;
+    }
+    /* This thread takes the first range itself. */
+    for (i = 1; i < nthreads; i++) {
+      started[i] = (0 == fc_thread_start(&threads[i], site_prefetch_run,
+                                         &data[i]));
+    }
+    site_prefetch_run(&data[0]);
+    for (i = 1; i < nthreads; i++) {
+      if (started[i]) {
+        fc_thread_wait(&threads[i]);
+      } else {
+        site_prefetch_run(&data[i]);
+      }
+    }
+
+    free(data);
+    free(started);
+    free(threads);
+  }
+
+  tile_hash_destroy(queued);
+  free(jobs);
+  for (i = 0; i < num_vcities; i++) {
+    destroy_city_virtual(vcities[i]);
+  }
+  pplayer->government = curr_govt;
+}
+
+/*************************************************************************//**
+  Account city result 'cr' of a site reached in 'turns' turns against the
+  best result so far. Takes ownership of 'cr'. Returns TRUE if the search
+  can end.
+*****************************************************************************/
+static bool settler_site_consider(struct pf_parameter *parameter,
+                                  struct unit *punit, int boat_cost,
+                                  struct cityresult *cr, int turns,
+                                  struct cityresult **best, int *best_turn)
+{
+  /* This algorithm punishes long treks */
+  cr->result = amortize(cr->total, PERFECTION * turns);
+
+  /* Reduce want by settler cost. Easier than amortize, but still
+   * weeds out very small wants. ie we create a threshold here. */
+  /* We also penalise here for using a boat (either virtual or real)
+   * it's crude but what isn't?
+   * Settler gets used, boat can make multiple trips. */
+  cr->result -= unit_build_shield_cost_base(punit) + boat_cost / 3;
+
+  /* Find best spot */
+  if ((!*best && cr->result > 0)
+      || (*best && cr->result > (*best)->result)) {
+    /* Destroy the old 'best' value. */
+    cityresult_destroy(*best);
+    /* save the new 'best' value. */
+    *best = cr;
+    *best_turn = turns;
+
+    log_debug("settler map search (search): (%d,%d) %d",
+              TILE_XY((*best)->tile), (*best)->result);
+  } else {
+    /* Destroy the unused result. */
+    cityresult_destroy(cr);
+  }
+
+  /* Can we terminate early? We have a 'good enough' spot, and
+   * we don't block the establishment of a better city just one
+   * further step away. */
+  return (*best && (*best)->result > RESULT_IS_ENOUGH
+          && turns > parameter->move_rate /* sic -- yeah what an explanation! */
+          && *best_turn < turns /*+ game.info.min_dist_bw_cities*/);
+}
+
+/*************************************************************************//**
+  Evaluate a chunk of candidate sites, in the order they were found, after
+  prefetching their surroundings. Returns TRUE if the search can end.
+*****************************************************************************/
+static bool settler_sites_consider(struct ai_type *ait,
+                                   struct pf_parameter *parameter,
+                                   struct unit *punit, int boat_cost,
+                                   struct tile **sites, const int *turns,
+                                   int num_sites,
+                                   struct cityresult **best, int *best_turn)
+{
+  struct player *pplayer = unit_owner(punit);
+  int i;
+
+  settler_sites_prefetch(ait, pplayer, sites, num_sites);
+
+  for (i = 0; i < num_sites; i++) {
+    struct cityresult *cr = city_desirability_eval(ait, pplayer, sites[i]);
+
+    if (cr != NULL
+        && settler_site_consider(parameter, punit, boat_cost, cr, turns[i],
+                                 best, best_turn)) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
 /*************************************************************************//**
   Find nearest and best city placement in a PF iteration according to
   "parameter".  The value in "boat_cost" is both the penalty to pay for
@@ -784,6 +1160,11 @@ static struct cityresult *settler_map_iterate(struct ai_type *ait,
   int best_turn = 0; /* Which turn we found the best fit */
   struct player *pplayer = unit_owner(punit);
   struct pf_map *pfm;
+  struct tile *sites[SITE_CHUNK_SIZE];
+  int site_turns[SITE_CHUNK_SIZE];
+  int num_sites = 0;
+  bool threaded = (game.server.citysite_threads > 0);
+  bool done = FALSE;
 
   pfm = pf_map_new(parameter);
   pf_map_move_costs_iterate(pfm, ptile, move_cost, FALSE) {
@@ -805,6 +1186,27 @@ static struct cityresult *settler_map_iterate(struct ai_type *ait,
       }
     }
 
+    turns = move_cost / parameter->move_rate;
+
+    if (threaded) {
+      /* Collect sites, and evaluate them a chunk at a time. */
+      if (!city_desirability_possible(pplayer, punit, ptile)) {
+        continue;
+      }
+      sites[num_sites] = ptile;
+      site_turns[num_sites] = turns;
+      if (++num_sites == SITE_CHUNK_SIZE) {
+        done = settler_sites_consider(ait, parameter, punit, boat_cost,
+                                      sites, site_turns, num_sites,
+                                      &best, &best_turn);
+        num_sites = 0;
+        if (done) {
+          break;
+        }
+      }
+      continue;
+    }
+
     /* Calculate worth */
     cr = city_desirability(ait, pplayer, punit, ptile);
 
@@ -813,45 +1215,18 @@ static struct cityresult *settler_map_iterate(struct ai_type *ait,
       continue;
     }
 
-    /* This algorithm punishes long treks */
-    turns = move_cost / parameter->move_rate;
-    cr->result = amortize(cr->total, PERFECTION * turns);
-
-    /* Reduce want by settler cost. Easier than amortize, but still
-     * weeds out very small wants. ie we create a threshold here. */
-    /* We also penalise here for using a boat (either virtual or real)
-     * it's crude but what isn't?
-     * Settler gets used, boat can make multiple trips. */
-    cr->result -= unit_build_shield_cost_base(punit) + boat_cost / 3;
-
-    /* Find best spot */
-    if ((!best && cr->result > 0)
-        || (best && cr->result > best->result)) {
-      /* Destroy the old 'best' value. */
-      cityresult_destroy(best);
-      /* save the new 'best' value. */
-      best = cr;
-      cr = NULL;
-      best_turn = turns;
-
-      log_debug("settler map search (search): (%d,%d) %d",
-                TILE_XY(best->tile), best->result);
-    } else {
-      /* Destroy the unused result. */
-      cityresult_destroy(cr);
-      cr = NULL;
-    }
-
-    /* Can we terminate early? We have a 'good enough' spot, and
-     * we don't block the establishment of a better city just one
-     * further step away. */
-    if (best && best->result > RESULT_IS_ENOUGH
-        && turns > parameter->move_rate /* sic -- yeah what an explanation! */
-        && best_turn < turns /*+ game.info.min_dist_bw_cities*/) {
+    if (settler_site_consider(parameter, punit, boat_cost, cr, turns,
+                              &best, &best_turn)) {
+      done = TRUE;
       break;
     }
   } pf_map_move_costs_iterate_end;
 
+  if (!done && num_sites > 0) {
+    settler_sites_consider(ait, parameter, punit, boat_cost,
+                           sites, site_turns, num_sites, &best, &best_turn);
+  }
+
   pf_map_destroy(pfm);
 
   if (best) {
@@ -996,7 +1371,7 @@ void dai_auto_settler_init(struct ai_plr *ai)
   fc_assert_ret(ai->settler == NULL);
 
   ai->settler = fc_calloc(1, sizeof(*ai->settler));
-  ai->settler->tdc_hash = tile_data_cache_hash_new();
+  tdc_shared_users++;
 
 #ifdef FREECIV_DEBUG
   ai->settler->cache.hit = 0;
@@ -1192,7 +1567,6 @@ void dai_auto_settler_reset(struct ai_type *ait, struct player *pplayer)
 
   fc_assert_ret(ai != NULL);
   fc_assert_ret(ai->settler != NULL);
-  fc_assert_ret(ai->settler->tdc_hash != NULL);
 
 #ifdef FREECIV_DEBUG
   log_debug("[aisettler cache for %s] save: %d, miss: %d, old: %d, hit: %d",
@@ -1206,7 +1580,8 @@ void dai_auto_settler_reset(struct ai_type *ait, struct player *pplayer)
   ai->settler->cache.save = 0;
 #endif /* FREECIV_DEBUG */
 
-  tile_data_cache_hash_clear(ai->settler->tdc_hash);
+  /* The shared tile data cache is kept; entries are validated against
+   * the tile and the player on use. */
 
   if (caller_closes) {
     dai_data_phase_finished(ait, pplayer);
@@ -1221,10 +1596,12 @@ void dai_auto_settler_free(struct ai_plr *ai)
   fc_assert_ret(ai != NULL);
 
   if (ai->settler) {
-    if (ai->settler->tdc_hash) {
-      tile_data_cache_hash_destroy(ai->settler->tdc_hash);
-    }
     free(ai->settler);
+
+    if (--tdc_shared_users == 0) {
+      FC_FREE(tdc_shared);
+      tdc_shared_size = 0;
+    }
   }
   ai->settler = NULL;
 }
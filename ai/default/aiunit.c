@@ -1160,6 +1160,7 @@ int find_something_to_kill(struct ai_type *ait, struct player *pplayer,
   }
 
   TIMING_LOG(AIT_FSTK, TIMER_START);
+  defender_memo_open();
 
 
   /*** Part 1: Calculate targets ***/
@@ -1570,6 +1571,7 @@ int find_something_to_kill(struct ai_type *ait, struct player *pplayer,
     pf_map_destroy(ferry_map);
   }
 
+  defender_memo_close();
   TIMING_LOG(AIT_FSTK, TIMER_STOP);
 
   return best;
@@ -24,6 +24,7 @@
 
 /* common */
 #include "actions.h"
+#include "combat.h"
 #include "game.h"
 #include "government.h"
 #include "research.h"
@@ -897,6 +898,8 @@ void dai_manage_cities(struct ai_type *ait, struct player *pplayer)
 
   /* Initialize the infrastructure cache, which is used shortly. */
   initialize_infrastructure_cache(pplayer);
+  /* Cities mostly look at the same enemy stacks with alike attackers. */
+  defender_memo_open();
   city_list_iterate(pplayer->cities, pcity) {
     struct ai_city *city_data = def_ai_city_data(pcity, ait);
     struct adv_choice *choice;
@@ -938,6 +941,7 @@ void dai_manage_cities(struct ai_type *ait, struct player *pplayer)
     TIMING_LOG(AIT_CITY_SETTLERS, TIMER_STOP);
     ADV_CHOICE_ASSERT(city_data->choice);
   } city_list_iterate_end;
+  defender_memo_close();
   /* Reset auto settler state for the next run. */
   dai_auto_settler_reset(ait, pplayer);
 
@@ -3559,8 +3559,10 @@ void mapimg_client_save(const char *filename)
 {
   if (!mapimg_client_createmap(filename)) {
     char msg[512];
+    char error[MAX_LEN_MAPIMG_ERROR];
 
-    fc_snprintf(msg, sizeof(msg), "(%s)", mapimg_error());
+    fc_snprintf(msg, sizeof(msg), "(%s)",
+                mapimg_error(error, sizeof(error)));
     popup_notify_dialog("Error", "Error Creating the Map Image!", msg);
   }
 }
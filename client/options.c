@@ -6289,10 +6289,12 @@ static void font_changed_callback(struct option *poption)
 static void mapimg_changed_callback(struct option *poption)
 {
   if (!mapimg_client_define()) {
+    char error[MAX_LEN_MAPIMG_ERROR];
     bool success;
 
     log_normal("Error setting the value for %s (%s). Restoring the default "
-               "value.", option_name(poption), mapimg_error());
+               "value.", option_name(poption),
+               mapimg_error(error, sizeof(error)));
 
     /* Reset the value to the default value. */
     success = option_reset(poption);
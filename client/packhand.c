@@ -32,6 +32,7 @@
 #include "actions.h"
 #include "capstr.h"
 #include "citizens.h"
+#include "effects.h"
 #include "events.h"
 #include "extras.h"
 #include "game.h"
@@ -2091,6 +2092,8 @@ void handle_game_info(const struct packet_game_info *pinfo)
   }
 
   game.info = *pinfo;
+  /* Great wonder owners and global advances. */
+  effect_value_cache_invalidate();
 
   /* check the values! */
 #define VALIDATE(_count, _maximum, _string)                                 \
@@ -2352,6 +2355,7 @@ void handle_player_info(const struct packet_player_info *pinfo)
   for (i = 0; i < B_LAST; i++) {
     pplayer->wonders[i] = pinfo->wonders[i];
   }
+  effect_value_cache_invalidate();
 
   /* Set AI.control. */
   if (is_ai(pplayer) != BV_ISSET(pinfo->flags, PLRF_AI)) {
@@ -209,19 +209,14 @@ bool achievement_check(struct achievement *ach, struct player *pplayer)
       max_unknown = (total * (100 - ach->value)) / 100;
       required = total - max_unknown;
 
-      whole_map_iterate(&(wld.map), ptile) {
-        bool this_is_known = FALSE;
+      if (is_server()) {
+        /* Kept up to date by map_set_known() and map_clear_known(). */
+        return pplayer->server.known_tiles >= required;
+      }
 
-        if (is_server()) {
-          if (dbv_isset(&pplayer->tile_known, tile_index(ptile))) {
-            this_is_known = TRUE;
-          }
-        } else {
-          /* Client */
-          if (ptile->terrain != T_UNKNOWN) {
-            this_is_known = TRUE;
-          }
-        }
+      /* Client */
+      whole_map_iterate(&(wld.map), ptile) {
+        bool this_is_known = (ptile->terrain != T_UNKNOWN);
 
         if (this_is_known) {
           known++;
@@ -281,6 +276,10 @@ bool achievement_check(struct achievement *ach, struct player *pplayer)
   case ACHIEVEMENT_HUTS:
     return pplayer->server.huts >= ach->value;
   case ACHIEVEMENT_METROPOLIS:
+    if (is_server()) {
+      return player_largest_city_size(pplayer) >= ach->value;
+    }
+
     city_list_iterate(pplayer->cities, pcity) {
       if (city_size_get(pcity) >= ach->value) {
         return TRUE;
@@ -291,23 +290,17 @@ bool achievement_check(struct achievement *ach, struct player *pplayer)
   case ACHIEVEMENT_LITERATE:
     return get_literacy(pplayer) >= ach->value;
   case ACHIEVEMENT_LAND_AHOY:
-    {
+    if (is_server()) {
+      /* FIXME: This makes the assumption that fogged tiles belonged
+       *        to their current continent when they were last seen. */
+      return player_known_continents(pplayer) >= ach->value;
+    } else {
+      /* Client */
       bool *seen = fc_calloc(wld.map.num_continents, sizeof(bool));
       int count = 0;
 
       whole_map_iterate(&(wld.map), ptile) {
-        bool this_is_known = FALSE;
-
-        if (is_server()) {
-          if (dbv_isset(&pplayer->tile_known, tile_index(ptile))) {
-            this_is_known = TRUE;
-          }
-        } else {
-          /* Client */
-          if (ptile->terrain != T_UNKNOWN) {
-            this_is_known = TRUE;
-          }
-        }
+        bool this_is_known = (ptile->terrain != T_UNKNOWN);
 
         if (this_is_known) {
           /* FIXME: This makes the assumption that fogged tiles belonged
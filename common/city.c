@@ -1142,6 +1142,18 @@ void city_size_set(struct city *pcity, citizens size)
 {
   fc_assert_ret(pcity != NULL);
 
+  if (is_server() && pcity->owner != NULL
+      && pcity->id != IDENTITY_NUMBER_ZERO) {
+    int *largest = &pcity->owner->server.largest_city_size;
+
+    if (size < pcity->size && pcity->size >= *largest) {
+      /* Possibly the largest city shrank. */
+      *largest = -1;
+    } else if (*largest >= 0 && size > *largest) {
+      *largest = size;
+    }
+  }
+
   /* Set city size. */
   pcity->size = size;
 }
@@ -1328,6 +1340,79 @@ int city_tile_output(const struct city *pcity, const struct tile *ptile,
   return prod;
 }
 
+/**********************************************************************//**
+  Calculate the output of every real tile within the city radius, as
+  city_tile_output() would, and store it in outputs[] indexed by city
+  tile index.  outputs[] must have room for
+  city_map_tiles(city_map_radius_sq_get(pcity)) entries; entries for
+  unreal tiles are left untouched.
+
+  When all tile output effects of the ruleset depend on the worked tile
+  only through its terrain, resource and extras, tiles sharing those are
+  resolved once and the result is copied to the others.  The city center
+  is always evaluated on its own.
+**************************************************************************/
+void city_tile_outputs(const struct city *pcity, bool is_celebrating,
+                       int (*outputs)[O_LAST])
+{
+  static const enum effect_type tile_effects[] = {
+    EFT_MINING_PCT, EFT_IRRIGATION_PCT, EFT_OUTPUT_ADD_TILE,
+    EFT_OUTPUT_PENALTY_TILE, EFT_OUTPUT_INC_TILE_CELEBRATE,
+    EFT_OUTPUT_INC_TILE, EFT_OUTPUT_PER_TILE, EFT_OUTPUT_TILE_PUNISH_PCT
+  };
+  struct {
+    const struct terrain *pterrain;
+    const struct extra_type *presource;
+    bv_extras extras;
+    int city_tile_index;
+  } sigs[CITY_MAP_MAX_SIZE * CITY_MAP_MAX_SIZE];
+  int num_sigs = 0;
+  bool grouped = TRUE;
+  int radius_sq = city_map_radius_sq_get(pcity);
+  int i;
+
+  for (i = 0; i < ARRAY_SIZE(tile_effects); i++) {
+    if (!effect_type_tile_local(tile_effects[i])) {
+      grouped = FALSE;
+      break;
+    }
+  }
+
+  city_tile_iterate_index(radius_sq, pcity->tile, ptile, city_tile_index) {
+    bool shareable = grouped && !is_city_center(pcity, ptile);
+
+    if (shareable) {
+      const struct terrain *pterrain = tile_terrain(ptile);
+      const struct extra_type *presource = tile_resource(ptile);
+
+      for (i = 0; i < num_sigs; i++) {
+        if (sigs[i].pterrain == pterrain
+            && sigs[i].presource == presource
+            && BV_ARE_EQUAL(sigs[i].extras, ptile->extras)) {
+          break;
+        }
+      }
+
+      if (i < num_sigs) {
+        memcpy(outputs[city_tile_index], outputs[sigs[i].city_tile_index],
+               sizeof(outputs[city_tile_index]));
+        continue;
+      }
+
+      sigs[num_sigs].pterrain = pterrain;
+      sigs[num_sigs].presource = presource;
+      sigs[num_sigs].extras = ptile->extras;
+      sigs[num_sigs].city_tile_index = city_tile_index;
+      num_sigs++;
+    }
+
+    output_type_iterate(o) {
+      outputs[city_tile_index][o]
+        = city_tile_output(pcity, ptile, is_celebrating, o);
+    } output_type_iterate_end;
+  } city_tile_iterate_index_end;
+}
+
 /**********************************************************************//**
   Calculate the production output the given tile is capable of producing
   for the city.  The output type is given by 'otype' (generally O_FOOD,
@@ -2290,6 +2375,7 @@ static inline void city_tile_cache_update(struct city *pcity)
 {
   bool is_celebrating = base_city_celebrating(pcity);
   int radius_sq = city_map_radius_sq_get(pcity);
+  int outputs[CITY_MAP_MAX_SIZE * CITY_MAP_MAX_SIZE][O_LAST];
 
   /* initialize tile_cache if needed */
   if (pcity->tile_cache == NULL || pcity->tile_cache_radius_sq == -1
@@ -2302,11 +2388,10 @@ static inline void city_tile_cache_update(struct city *pcity)
 
   /* Any unreal tiles are skipped - these values should have been memset
    * to 0 when the city was created. */
+  city_tile_outputs(pcity, is_celebrating, outputs);
   city_tile_iterate_index(radius_sq, pcity->tile, ptile, city_tile_index) {
-    output_type_iterate(o) {
-      (pcity->tile_cache[city_tile_index]).output[o]
-        = city_tile_output(pcity, ptile, is_celebrating, o);
-    } output_type_iterate_end;
+    memcpy(pcity->tile_cache[city_tile_index].output,
+           outputs[city_tile_index], sizeof(outputs[city_tile_index]));
   } city_tile_iterate_index_end;
 }
 
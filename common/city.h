@@ -472,6 +472,7 @@ extern struct output_type output_types[];
 /* get 'struct city_list' and related functions: */
 #define SPECLIST_TAG city
 #define SPECLIST_TYPE struct city
+#define SPECLIST_NO_MUTEX
 #include "speclist.h"
 
 #define city_list_iterate(citylist, pcity) \
@@ -643,6 +644,8 @@ int city_tile_output(const struct city *pcity, const struct tile *ptile,
 		     bool is_celebrating, Output_type_id otype);
 int city_tile_output_now(const struct city *pcity, const struct tile *ptile,
 			 Output_type_id otype);
+void city_tile_outputs(const struct city *pcity, bool is_celebrating,
+                       int (*outputs)[O_LAST]);
 
 bool base_city_can_work_tile(const struct player *restriction,
                              const struct city *pcity,
@@ -19,6 +19,8 @@
 
 /* utility */
 #include "bitvector.h"
+#include "fcthread.h"
+#include "genhash.h"
 #include "rand.h"
 #include "log.h"
 
@@ -697,13 +699,151 @@ static int get_defense_rating(const struct unit *attacker,
   return rating;
 }
 
+/* The attacker state and target tile a get_defender() result depends on,
+ * as far as the attacker is concerned. */
+struct defender_memo_key {
+  int tile;
+  int from;
+  int owner;
+  int utype;
+  int veteran;
+  int hp;
+  int moves_left;
+};
+
+struct defender_memo_entry {
+  struct defender_memo_key key;     /* Must be first. */
+  struct unit *defender;
+  int defender_id;
+  int stack_size;
+};
+
+/* get_defender() results of the defender_memo_open() scope of a thread. */
+struct defender_memo {
+  int depth;
+  struct genhash *entries;
+};
+
+static fc_thread_key defender_memo_tls;
+static bool defender_memo_tls_init = FALSE;
+
 /*******************************************************************//**
-  Finds the best defender on the tile, given an attacker.  The diplomatic
-  relationship of attacker and defender is ignored; the caller should check
-  this.
+  Hash function for the defender memo.
 ***********************************************************************/
-struct unit *get_defender(const struct unit *attacker,
-			  const struct tile *ptile)
+static genhash_val_t defender_memo_key_val(const void *vkey)
+{
+  const struct defender_memo_key *pkey = vkey;
+  genhash_val_t result = pkey->tile;
+
+  result = result * 31 + pkey->from;
+  result = result * 31 + pkey->owner;
+  result = result * 31 + pkey->utype;
+  result = result * 31 + pkey->veteran;
+  result = result * 31 + pkey->hp;
+  result = result * 31 + pkey->moves_left;
+
+  return result;
+}
+
+/*******************************************************************//**
+  Comparison function for the defender memo.
+***********************************************************************/
+static bool defender_memo_key_comp(const void *vkey1, const void *vkey2)
+{
+  const struct defender_memo_key *pkey1 = vkey1;
+  const struct defender_memo_key *pkey2 = vkey2;
+
+  return (pkey1->tile == pkey2->tile
+          && pkey1->from == pkey2->from
+          && pkey1->owner == pkey2->owner
+          && pkey1->utype == pkey2->utype
+          && pkey1->veteran == pkey2->veteran
+          && pkey1->hp == pkey2->hp
+          && pkey1->moves_left == pkey2->moves_left);
+}
+
+/*******************************************************************//**
+  Prepare the defender memo. Must be called by the main thread before
+  starting any thread which calls defender_memo_open().
+***********************************************************************/
+void defender_memo_init(void)
+{
+  if (!defender_memo_tls_init) {
+    fc_thread_key_init(&defender_memo_tls);
+    defender_memo_tls_init = TRUE;
+  }
+}
+
+/*******************************************************************//**
+  Free the defender memo. No scope may be open in any thread.
+***********************************************************************/
+void defender_memo_free(void)
+{
+  if (defender_memo_tls_init) {
+    fc_assert(NULL == fc_thread_key_get(&defender_memo_tls));
+    fc_thread_key_destroy(&defender_memo_tls);
+    defender_memo_tls_init = FALSE;
+  }
+}
+
+/*******************************************************************//**
+  Start remembering the results of get_defender() in the calling thread,
+  until the matching defender_memo_close(). Scopes nest.
+
+  Repeated queries against the same stack with alike attackers then cost
+  a lookup instead of a win chance computation for every unit of the
+  stack. The caller must not move, create, destroy or otherwise change
+  units, nor change the tiles or the rules, within the scope: the memo is
+  only checked against stack size changes. Used by AI evaluations.
+***********************************************************************/
+void defender_memo_open(void)
+{
+  struct defender_memo *memo;
+
+  if (!defender_memo_tls_init) {
+    return;
+  }
+
+  memo = fc_thread_key_get(&defender_memo_tls);
+  if (NULL == memo) {
+    memo = fc_malloc(sizeof(*memo));
+    memo->depth = 0;
+    memo->entries = genhash_new_full(defender_memo_key_val,
+                                     defender_memo_key_comp,
+                                     NULL, NULL, NULL, free);
+    fc_thread_key_set(&defender_memo_tls, memo);
+  }
+  memo->depth++;
+}
+
+/*******************************************************************//**
+  End a defender_memo_open() scope. The remembered results are dropped
+  when the outermost scope is closed.
+***********************************************************************/
+void defender_memo_close(void)
+{
+  struct defender_memo *memo;
+
+  if (!defender_memo_tls_init) {
+    return;
+  }
+
+  memo = fc_thread_key_get(&defender_memo_tls);
+  fc_assert_ret(NULL != memo);
+
+  if (0 == --memo->depth) {
+    genhash_destroy(memo->entries);
+    free(memo);
+    fc_thread_key_set(&defender_memo_tls, NULL);
+  }
+}
+
+/*******************************************************************//**
+  Finds the best defender on the tile, given an attacker, without
+  looking at the defender memo.
+***********************************************************************/
+static struct unit *best_defender(const struct unit *attacker,
+                                  const struct tile *ptile)
 {
   struct unit *bestdef = NULL;
   int bestvalue = -99, best_cost = 0, rating_of_best = 0;
@@ -762,6 +902,58 @@ struct unit *get_defender(const struct unit *attacker,
   return bestdef;
 }
 
+/*******************************************************************//**
+  Finds the best defender on the tile, given an attacker.  The diplomatic
+  relationship of attacker and defender is ignored; the caller should check
+  this.
+***********************************************************************/
+struct unit *get_defender(const struct unit *attacker,
+			  const struct tile *ptile)
+{
+  struct defender_memo *memo = NULL;
+  struct defender_memo_entry *pentry;
+  struct defender_memo_key key;
+  struct unit *bestdef;
+
+  if (defender_memo_tls_init) {
+    memo = fc_thread_key_get(&defender_memo_tls);
+  }
+
+  if (NULL == memo) {
+    return best_defender(attacker, ptile);
+  }
+
+  key.tile = tile_index(ptile);
+  key.from = (NULL != unit_tile(attacker)
+              ? tile_index(unit_tile(attacker)) : -1);
+  key.owner = player_index(unit_owner(attacker));
+  key.utype = utype_index(unit_type_get(attacker));
+  key.veteran = attacker->veteran;
+  key.hp = attacker->hp;
+  key.moves_left = attacker->moves_left;
+
+  if (genhash_lookup(memo->entries, &key, (void **) &pentry)) {
+    if (pentry->stack_size == unit_list_size(ptile->units)
+        && (NULL == pentry->defender
+            || (NULL != unit_list_search(ptile->units, pentry->defender)
+                && pentry->defender->id == pentry->defender_id))) {
+      return pentry->defender;
+    }
+  } else {
+    pentry = fc_malloc(sizeof(*pentry));
+    pentry->key = key;
+    genhash_insert(memo->entries, &pentry->key, pentry);
+  }
+
+  bestdef = best_defender(attacker, ptile);
+
+  pentry->defender = bestdef;
+  pentry->defender_id = (NULL != bestdef ? bestdef->id : 0);
+  pentry->stack_size = unit_list_size(ptile->units);
+
+  return bestdef;
+}
+
 /*******************************************************************//**
   Get unit at (x, y) that wants to kill defender.
 
@@ -81,6 +81,11 @@ struct unit *get_defender(const struct unit *attacker,
 struct unit *get_attacker(const struct unit *defender,
                           const struct tile *ptile);
 
+void defender_memo_init(void);
+void defender_memo_free(void);
+void defender_memo_open(void);
+void defender_memo_close(void);
+
 struct unit *get_diplomatic_defender(const struct unit *act_unit,
                                      const struct unit *pvictim,
                                      const struct tile *tgt_tile);
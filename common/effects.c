@@ -20,6 +20,7 @@
 /* utility */
 #include "astring.h"
 #include "fcintl.h"
+#include "fcthread.h"
 #include "log.h"
 #include "mem.h"
 #include "support.h"
@@ -119,8 +120,49 @@ static struct {
     /* ...advances... */
     struct effect_list *advances[A_LAST];
   } reqs;
+
+  /* Whether effects of each type depend on the target tile only through
+   * its terrain and extras; -1 when not yet known. Reset whenever effects
+   * of the type change. See effect_type_tile_local(). */
+  signed char tile_local[EFT_COUNT];
+
+  /* Whether effects of each type, when evaluated without a city, tile or
+   * unit, depend only on inputs the effect value cache watches; -1 when
+   * not yet known. See effect_type_player_level(). */
+  signed char player_level[EFT_COUNT];
+
+  /* Whether values of effects of each type at a tile, for a new virtual
+   * city, can be shared between alike tiles and players; -1 when not yet
+   * known. See effect_type_site_shareable(). */
+  signed char site_shareable[EFT_COUNT];
 } ruleset_cache;
 
+/* A value cached by get_player_bonus(), get_world_bonus() or
+ * get_player_output_bonus(). */
+struct effect_value {
+  unsigned int epoch;                   /* 0 when empty. */
+  const struct government *government;
+  const struct nation_type *nation;
+  int value;
+};
+
+#define EFFECT_VALUES_PER_TYPE (O_LAST + 1)
+
+/**************************************************************************
+  Effect value cache. The values of player level effect types only
+  change with techs, wonders and the player set, which bump the epoch
+  (see effect_value_cache_invalidate()), and with the government and
+  nation of the player, which each value remembers. The cache is shared
+  with worker threads, hence the mutex.
+**************************************************************************/
+static struct {
+  fc_mutex mutex;
+  unsigned int epoch;
+  /* Indexed by effect type and output type + 1 (0 for none). */
+  struct effect_value world[EFT_COUNT * EFFECT_VALUES_PER_TYPE];
+  struct effect_value *players[MAX_NUM_PLAYER_SLOTS];
+} effect_values;
+
 
 /**********************************************************************//**
   Get a list of effects of this type.
@@ -184,6 +226,10 @@ struct effect *effect_new(enum effect_type type, int value,
   /* Now add the effect to the ruleset cache. */
   effect_list_append(ruleset_cache.tracker, peffect);
   effect_list_append(get_effects(type), peffect);
+  ruleset_cache.tile_local[type] = -1;
+  ruleset_cache.player_level[type] = -1;
+  ruleset_cache.site_shareable[type] = -1;
+  effect_value_cache_invalidate();
 
   return peffect;
 }
@@ -211,6 +257,10 @@ void effect_req_append(struct effect *peffect, struct requirement req)
   struct effect_list *eff_list = get_req_source_effects(&req.source);
 
   requirement_vector_append(&peffect->reqs, req);
+  ruleset_cache.tile_local[peffect->type] = -1;
+  ruleset_cache.player_level[peffect->type] = -1;
+  ruleset_cache.site_shareable[peffect->type] = -1;
+  effect_value_cache_invalidate();
 
   if (eff_list) {
     effect_list_append(eff_list, peffect);
@@ -227,6 +277,7 @@ void ruleset_cache_init(void)
   int i;
 
   initialized = TRUE;
+  fc_init_mutex(&effect_values.mutex);
 
   ruleset_cache.tracker = effect_list_new();
 
@@ -242,6 +293,17 @@ void ruleset_cache_init(void)
   for (i = 0; i < ARRAY_SIZE(ruleset_cache.reqs.advances); i++) {
     ruleset_cache.reqs.advances[i] = effect_list_new();
   }
+  for (i = 0; i < ARRAY_SIZE(ruleset_cache.tile_local); i++) {
+    ruleset_cache.tile_local[i] = -1;
+  }
+  for (i = 0; i < ARRAY_SIZE(ruleset_cache.player_level); i++) {
+    ruleset_cache.player_level[i] = -1;
+  }
+  for (i = 0; i < ARRAY_SIZE(ruleset_cache.site_shareable); i++) {
+    ruleset_cache.site_shareable[i] = -1;
+  }
+
+  effect_value_cache_invalidate();
 }
 
 /**********************************************************************//**
@@ -298,6 +360,13 @@ void ruleset_cache_free(void)
     }
   }
 
+  if (initialized) {
+    for (i = 0; i < ARRAY_SIZE(effect_values.players); i++) {
+      FC_FREE(effect_values.players[i]);
+    }
+    fc_destroy_mutex(&effect_values.mutex);
+  }
+
   initialized = FALSE;
 }
 
@@ -516,6 +585,286 @@ bool building_has_effect(const struct impr_type *pimprove,
   return FALSE;
 }
 
+/**********************************************************************//**
+  Can the requirement tell apart two tiles that have the same terrain and
+  extras, when evaluated for the same player and city?
+**************************************************************************/
+static bool req_is_tile_local(const struct requirement *preq)
+{
+  switch (preq->source.kind) {
+  case VUT_CITYTILE:
+  case VUT_MAXTILEUNITS:
+    return FALSE;
+  case VUT_TERRAIN:
+  case VUT_TERRAINCLASS:
+  case VUT_TERRFLAG:
+  case VUT_TERRAINALTER:
+  case VUT_EXTRA:
+  case VUT_EXTRAFLAG:
+  case VUT_ROADFLAG:
+  case VUT_BASEFLAG:
+    return preq->range == REQ_RANGE_LOCAL;
+  default:
+    /* Does not look at the tile, except through its neighbours. */
+    return preq->range != REQ_RANGE_CADJACENT
+           && preq->range != REQ_RANGE_ADJACENT;
+  }
+}
+
+/**********************************************************************//**
+  Returns TRUE if the value of effects of the given type at a tile, for
+  a given player and city, depends on the tile only through its terrain
+  and extras. Callers can then evaluate the effect once for all such
+  tiles.
+**************************************************************************/
+bool effect_type_tile_local(enum effect_type effect_type)
+{
+  if (ruleset_cache.tile_local[effect_type] < 0) {
+    bool local = TRUE;
+
+    effect_list_iterate(get_effects(effect_type), peffect) {
+      requirement_vector_iterate(&peffect->reqs, preq) {
+        if (!req_is_tile_local(preq)) {
+          local = FALSE;
+          break;
+        }
+      } requirement_vector_iterate_end;
+      if (!local) {
+        break;
+      }
+    } effect_list_iterate_end;
+
+    ruleset_cache.tile_local[effect_type] = local ? 1 : 0;
+  }
+
+  return ruleset_cache.tile_local[effect_type] > 0;
+}
+
+/**********************************************************************//**
+  Returns TRUE if the requirement, evaluated for a player (or for nobody)
+  without city, tile or unit, only depends on the player's techs,
+  government, wonders and nation, on the great wonders, and on the
+  output type.
+**************************************************************************/
+static bool req_is_player_level(const struct requirement *preq)
+{
+  switch (preq->source.kind) {
+  case VUT_NONE:
+  case VUT_OTYPE:
+    return TRUE;
+  case VUT_ADVANCE:
+  case VUT_TECHFLAG:
+    return preq->range == REQ_RANGE_PLAYER
+           || preq->range == REQ_RANGE_WORLD;
+  case VUT_IMPROVEMENT:
+    if (preq->range != REQ_RANGE_PLAYER
+        && preq->range != REQ_RANGE_WORLD) {
+      return FALSE;
+    }
+    /* Also evaluated: whether the building is obsolete. */
+    requirement_vector_iterate(&preq->source.value.building->obsolete_by,
+                               pobs) {
+      if (pobs->source.kind == VUT_IMPROVEMENT
+          || !req_is_player_level(pobs)) {
+        return FALSE;
+      }
+    } requirement_vector_iterate_end;
+    return TRUE;
+  case VUT_GOVERNMENT:
+  case VUT_NATION:
+  case VUT_NATIONGROUP:
+    return preq->range == REQ_RANGE_PLAYER;
+  default:
+    return FALSE;
+  }
+}
+
+/**********************************************************************//**
+  Returns TRUE if the player (or world) level values of effects of the
+  given type can be kept in the effect value cache.
+**************************************************************************/
+static bool effect_type_player_level(enum effect_type effect_type)
+{
+  if (ruleset_cache.player_level[effect_type] < 0) {
+    bool level = TRUE;
+
+    effect_list_iterate(get_effects(effect_type), peffect) {
+      if (peffect->multiplier != NULL) {
+        /* Multiplier values are not watched. */
+        level = FALSE;
+        break;
+      }
+      requirement_vector_iterate(&peffect->reqs, preq) {
+        if (!req_is_player_level(preq)) {
+          level = FALSE;
+          break;
+        }
+      } requirement_vector_iterate_end;
+      if (!level) {
+        break;
+      }
+    } effect_list_iterate_end;
+
+    ruleset_cache.player_level[effect_type] = level ? 1 : 0;
+  }
+
+  return ruleset_cache.player_level[effect_type] > 0;
+}
+
+/**********************************************************************//**
+  Returns TRUE if the requirement, evaluated for a tile and a new virtual
+  city of a player, depends on the tile only through its terrain and
+  extras, and on the player only through the inputs req_is_player_level()
+  allows. New virtual cities have no buildings, have size one and only
+  citizens of their owner's nationality.
+**************************************************************************/
+static bool req_is_site_shareable(const struct requirement *preq)
+{
+  if (req_is_player_level(preq)) {
+    return TRUE;
+  }
+
+  switch (preq->source.kind) {
+  case VUT_TERRAIN:
+  case VUT_TERRAINCLASS:
+  case VUT_TERRFLAG:
+  case VUT_TERRAINALTER:
+  case VUT_EXTRA:
+  case VUT_EXTRAFLAG:
+  case VUT_ROADFLAG:
+  case VUT_BASEFLAG:
+    return preq->range == REQ_RANGE_LOCAL;
+  case VUT_IMPROVEMENT:
+  case VUT_MINSIZE:
+  case VUT_NATIONALITY:
+    return preq->range == REQ_RANGE_CITY;
+  default:
+    return FALSE;
+  }
+}
+
+/**********************************************************************//**
+  Returns TRUE if the value of effects of the given type at a tile, for a
+  new virtual city, is the same for all tiles with the same terrain and
+  extras and all players with the same techs, government, wonders and
+  nation. Callers can then keep such values across players and turns.
+**************************************************************************/
+bool effect_type_site_shareable(enum effect_type effect_type)
+{
+  if (ruleset_cache.site_shareable[effect_type] < 0) {
+    bool shareable = TRUE;
+
+    effect_list_iterate(get_effects(effect_type), peffect) {
+      if (peffect->multiplier != NULL) {
+        shareable = FALSE;
+        break;
+      }
+      requirement_vector_iterate(&peffect->reqs, preq) {
+        if (!req_is_site_shareable(preq)) {
+          shareable = FALSE;
+          break;
+        }
+      } requirement_vector_iterate_end;
+      if (!shareable) {
+        break;
+      }
+    } effect_list_iterate_end;
+
+    ruleset_cache.site_shareable[effect_type] = shareable ? 1 : 0;
+  }
+
+  return ruleset_cache.site_shareable[effect_type] > 0;
+}
+
+/**********************************************************************//**
+  Forget all the values in the effect value cache. To be called when the
+  techs or wonders of any player, or the set of players, change.
+**************************************************************************/
+void effect_value_cache_invalidate(void)
+{
+  if (!initialized) {
+    /* Nothing cached, and no mutex yet. */
+    return;
+  }
+
+  fc_allocate_mutex(&effect_values.mutex);
+  effect_values.epoch++;
+  if (0 == effect_values.epoch) {
+    /* 0 marks empty values. */
+    effect_values.epoch++;
+  }
+  fc_release_mutex(&effect_values.mutex);
+}
+
+/**********************************************************************//**
+  Returns the effect bonus for a player (NULL for the world) and output
+  type (NULL for none), through the effect value cache when possible.
+**************************************************************************/
+static int get_player_level_bonus(const struct player *pplayer,
+                                  const struct output_type *poutput,
+                                  enum effect_type effect_type)
+{
+  struct effect_value *pvalue;
+  unsigned int epoch;
+  int slot;
+  int value;
+
+  if (0 == effect_list_size(get_effects(effect_type))) {
+    return 0;
+  }
+
+  if (!effect_type_player_level(effect_type)) {
+    return get_target_bonus_effects(NULL, pplayer, NULL, NULL, NULL, NULL,
+                                    NULL, NULL, poutput, NULL, NULL,
+                                    effect_type);
+  }
+
+  slot = effect_type * EFFECT_VALUES_PER_TYPE
+         + (poutput != NULL ? poutput->index + 1 : 0);
+
+  fc_allocate_mutex(&effect_values.mutex);
+  if (pplayer == NULL) {
+    pvalue = &effect_values.world[slot];
+  } else {
+    int idx = player_index(pplayer);
+
+    if (effect_values.players[idx] == NULL) {
+      effect_values.players[idx] =
+        fc_calloc(EFT_COUNT * EFFECT_VALUES_PER_TYPE,
+                  sizeof(*effect_values.players[idx]));
+    }
+    pvalue = &effect_values.players[idx][slot];
+  }
+
+  /* The value computed below reflects the state as of this epoch. */
+  epoch = effect_values.epoch;
+  if (pvalue->epoch == epoch
+      && (pplayer == NULL
+          || (pvalue->government == pplayer->government
+              && pvalue->nation == pplayer->nation))) {
+    value = pvalue->value;
+    fc_release_mutex(&effect_values.mutex);
+
+    return value;
+  }
+  fc_release_mutex(&effect_values.mutex);
+
+  value = get_target_bonus_effects(NULL, pplayer, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, poutput, NULL, NULL,
+                                   effect_type);
+
+  fc_allocate_mutex(&effect_values.mutex);
+  pvalue->epoch = epoch;
+  if (pplayer != NULL) {
+    pvalue->government = pplayer->government;
+    pvalue->nation = pplayer->nation;
+  }
+  pvalue->value = value;
+  fc_release_mutex(&effect_values.mutex);
+
+  return value;
+}
+
 /**********************************************************************//**
   Return TRUE iff any of the disabling requirements for this effect are
   active, which would prevent it from taking effect.
@@ -655,10 +1004,7 @@ int get_world_bonus(enum effect_type effect_type)
     return 0;
   }
 
-  return get_target_bonus_effects(NULL,
-                                  NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                  NULL, NULL, NULL,
-                                  effect_type);
+  return get_player_level_bonus(NULL, NULL, effect_type);
 }
 
 /**********************************************************************//**
@@ -671,10 +1017,7 @@ int get_player_bonus(const struct player *pplayer,
     return 0;
   }
 
-  return get_target_bonus_effects(NULL,
-                                  pplayer, NULL, NULL, NULL,
-                                  NULL, NULL, NULL, NULL, NULL,
-                                  NULL, effect_type);
+  return get_player_level_bonus(pplayer, NULL, effect_type);
 }
 
 /**********************************************************************//**
@@ -768,9 +1111,7 @@ int get_player_output_bonus(const struct player *pplayer,
   fc_assert_ret_val(pplayer != NULL, 0);
   fc_assert_ret_val(poutput != NULL, 0);
   fc_assert_ret_val(effect_type != EFT_COUNT, 0);
-  return get_target_bonus_effects(NULL, pplayer, NULL, NULL, NULL, NULL,
-                                  NULL, NULL, poutput, NULL, NULL,
-                                  effect_type);
+  return get_player_level_bonus(pplayer, poutput, effect_type);
 }
 
 /**********************************************************************//**
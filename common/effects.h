@@ -431,6 +431,9 @@ int get_target_bonus_effects(struct effect_list *plist,
 
 bool building_has_effect(const struct impr_type *pimprove,
 			 enum effect_type effect_type);
+bool effect_type_tile_local(enum effect_type effect_type);
+bool effect_type_site_shareable(enum effect_type effect_type);
+void effect_value_cache_invalidate(void);
 int get_current_construction_bonus(const struct city *pcity,
                                    enum effect_type effect_type,
                                    const enum req_problem_type prob_type);
@@ -31,8 +31,10 @@
 #include "achievements.h"
 #include "actions.h"
 #include "city.h"
+#include "combat.h"
 #include "connection.h"
 #include "disaster.h"
+#include "effects.h"
 #include "extras.h"
 #include "government.h"
 #include "idex.h"
@@ -200,6 +202,9 @@ void game_remove_city(struct world *gworld, struct city *pcity)
   if (NULL != powner) {
     /* always unlink before clearing data */
     city_list_remove(powner->cities, pcity);
+    if (is_server()) {
+      powner->server.largest_city_size = -1;
+    }
   }
 
   if (NULL == pcenter) {
@@ -394,6 +399,7 @@ static void game_defaults(bool keep_ruleset_value)
     game.server.nuclear_winter_percent = GAME_DEFAULT_NUCLEAR_WINTER_PERCENT;
     game.server.plrcolormode      = GAME_DEFAULT_PLRCOLORMODE;
     game.server.netwait           = GAME_DEFAULT_NETWAIT;
+    game.server.deltacache        = GAME_DEFAULT_DELTACACHE;
     game.server.occupychance      = GAME_DEFAULT_OCCUPYCHANCE;
     game.server.onsetbarbarian    = GAME_DEFAULT_ONSETBARBARIAN;
     game.server.additional_phase_seconds = 0;
@@ -455,6 +461,7 @@ void game_init(bool keep_ruleset_value)
   cm_init();
   researches_init();
   universal_found_functions_init();
+  defender_memo_init();
 }
 
 /**********************************************************************//**
@@ -484,6 +491,7 @@ void game_free(void)
   game_ruleset_free();
   researches_free();
   cm_free();
+  defender_memo_free();
 }
 
 /**********************************************************************//**
@@ -693,6 +701,7 @@ void initialize_globals(void)
       } city_built_iterate_end;
     } city_list_iterate_end;
   } players_iterate_end;
+  effect_value_cache_invalidate();
 }
 
 /**********************************************************************//**
@@ -163,6 +163,7 @@ struct civ_game {
       enum trait_dist_mode trait_dist;
       int min_players;
       bool natural_city_names;
+      int deltacache;
       int netwait;
       int num_phases;
       int occupychance;
@@ -175,6 +176,8 @@ struct civ_game {
       int revolution_length;
       int spaceship_travel_time;
       bool threaded_save;
+      int mapimg_threads;
+      int citysite_threads;
       int save_compress_level;
       enum fz_method save_compress_type;
       int save_nturns;
@@ -590,6 +593,10 @@ extern struct world wld;
 #define GAME_MIN_NETWAIT             0
 #define GAME_MAX_NETWAIT             20
 
+#define GAME_DEFAULT_DELTACACHE      0
+#define GAME_MIN_DELTACACHE          0
+#define GAME_MAX_DELTACACHE          1048576
+
 #define GAME_DEFAULT_PINGTIME        20
 #define GAME_MIN_PINGTIME            1
 #define GAME_MAX_PINGTIME            1800
@@ -656,6 +663,14 @@ extern struct world wld;
 
 #define GAME_DEFAULT_THREADED_SAVE   FALSE
 
+#define GAME_DEFAULT_MAPIMG_THREADS  0
+#define GAME_MIN_MAPIMG_THREADS      0
+#define GAME_MAX_MAPIMG_THREADS      16
+
+#define GAME_DEFAULT_CITYSITE_THREADS 0
+#define GAME_MIN_CITYSITE_THREADS     0
+#define GAME_MAX_CITYSITE_THREADS     16
+
 #define GAME_DEFAULT_USER_META_MESSAGE ""
 
 #define GAME_DEFAULT_SKILL_LEVEL     AI_LEVEL_EASY
@@ -316,7 +316,7 @@ class Field:
 '''%(cmp,b,i)
         else:
             return '''%s
-  if (differ) {
+  if (differ || resend) {
     different++;
     BV_SET(fields, %d);
   }
@@ -400,7 +400,7 @@ class Field:
       int count = 0;
 
       for (i = 0; i < %(array_size_u)s; i++) {
-        if (old->%(name)s[i] != real_packet->%(name)s[i]) {
+        if (resend || old->%(name)s[i] != real_packet->%(name)s[i]) {
           count++;
         }
       }
@@ -416,7 +416,7 @@ class Field:
       fc_assert(%(array_size_u)s < 255);
 
       for (i = 0; i < %(array_size_u)s; i++) {
-        if (old->%(name)s[i] != real_packet->%(name)s[i]) {
+        if (resend || old->%(name)s[i] != real_packet->%(name)s[i]) {
 #ifdef FREECIV_JSON_CONNECTION
           /* Next diff array element. */
           field_addr.sub_location->number = count - 1;
@@ -824,6 +824,9 @@ class Variant:
         self.is_info=packet.is_info
         self.cancel=packet.cancel
         self.want_force=packet.want_force
+        # Packets sent to lists of connections reuse the encoding of the
+        # previous connection when its delta state was the same.
+        self.want_memo=packet.want_lsend
 
         self.poscaps=poscaps
         self.negcaps=negcaps
@@ -1038,6 +1041,7 @@ static char *stats_%(name)s_names[] = {%(names)s};
   bool differ;
   struct genhash **hash = pc->phs.sent + %(type)s;
   int different = %(diff)s;
+  bool resend = FALSE;
 #endif /* FREECIV_DELTA_PROTOCOL */
 '''
                 body=self.get_delta_send_body()+"\n#ifndef FREECIV_DELTA_PROTOCOL"
@@ -1087,17 +1091,36 @@ static char *stats_%(name)s_names[] = {%(names)s};
 #ifdef FREECIV_DELTA_PROTOCOL
   if (NULL == *hash) {
     *hash = genhash_new_full(hash_%(name)s, cmp_%(name)s,
-                             NULL, NULL, NULL, free);
+                             NULL, NULL, NULL, delta_cache_entry_free);
   }
   BV_CLR_ALL(fields);
 
   if (!genhash_lookup(*hash, real_packet, (void **) &old)) {
-    old = fc_malloc(sizeof(*old));
+    old = delta_cache_entry_new(pc, %(type)s, *hash, sizeof(*old));
     *old = *real_packet;
     genhash_insert(*hash, old, old);
     memset(old, 0, sizeof(*old));
     different = 1;      /* Force to send. */
+    /* The other end may still know an evicted older version. */
+    resend = delta_cache_resend(pc, %(type)s);
+  } else {
+    delta_cache_entry_touch(old);
+  }
+'''
+        if self.want_memo:
+            intro=intro+'''
+#ifdef FREECIV_SEND_MEMO
+  switch (packet_send_memo_check(pc, %(type)s, %(no)d, real_packet, old,
+                                 sizeof(*old), different, resend,
+                                 &dout)) {
+  case PACKET_SEND_MEMO_DISCARD:
+<pre2>    return 0;
+  case PACKET_SEND_MEMO_REPLAY:
+    goto memo_replayed;
+  case PACKET_SEND_MEMO_MISS:
+    break;
   }
+#endif /* FREECIV_SEND_MEMO */
 '''
         body=""
         for i in range(len(self.other_fields)):
@@ -1112,10 +1135,18 @@ static char *stats_%(name)s_names[] = {%(names)s};
         else:
             s=""
 
+        if self.want_memo:
+            memo_discard='''#ifdef FREECIV_SEND_MEMO
+    packet_send_memo_store(%(type)s, NULL);
+#endif /* FREECIV_SEND_MEMO */
+'''
+        else:
+            memo_discard=""
+
         if self.is_info != "no":
             body=body+'''
   if (different == 0) {
-%(fl)s%(s)s<pre2>    return 0;
+%(fl)s%(s)s%(memo_discard)s<pre2>    return 0;
   }
 '''%self.get_dict(vars())
 
@@ -1133,6 +1164,13 @@ static char *stats_%(name)s_names[] = {%(names)s};
         for i in range(len(self.other_fields)):
             field=self.other_fields[i]
             body=body+field.get_put_wrapper(self,i,1)
+        if self.want_memo:
+            body=body+'''
+#ifdef FREECIV_SEND_MEMO
+  packet_send_memo_store(%(type)s, &dout);
+
+memo_replayed:
+#endif /* FREECIV_SEND_MEMO */'''%self.get_dict(vars())
         body=body+'''
   *old = *real_packet;
 '''
@@ -18,8 +18,9 @@
    Method: use separate hash tables for each type.
    Means code duplication for city/unit cases, but simplicity advantages.
    Don't have to manage memory at all: store pointers to unit and city
-   structs allocated elsewhere, and keys are pointers to id values inside
-   the structs.
+   structs allocated elsewhere, and keys are the id values themselves.
+   Being integer keyed, the tables store their keys inline, with open
+   addressing (see genhash.c), so a lookup does not chase pointers.
 
    Note id values should probably be unsigned int: here leave as plain int
    so can use pointers to pcity->id etc.
@@ -25,6 +25,7 @@
 
 /* common */
 #include "game.h"
+#include "effects.h"
 #include "map.h"
 #include "tech.h"
 #include "victory.h"
@@ -758,6 +759,7 @@ void wonder_built(const struct city *pcity, const struct impr_type *pimprove)
   if (is_great_wonder(pimprove)) {
     game.info.great_wonder_owners[windex] = player_number(pplayer);
   }
+  effect_value_cache_invalidate();
 }
 
 /**********************************************************************//**
@@ -782,6 +784,7 @@ void wonder_destroyed(const struct city *pcity,
                    == player_number(pplayer));
     game.info.great_wonder_owners[windex] = WONDER_DESTROYED;
   }
+  effect_value_cache_invalidate();
 }
 
 /**********************************************************************//**
@@ -191,6 +191,7 @@ void map_init(struct civ_map *imap, bool server_side)
     imap->server.have_huts = FALSE;
     imap->server.have_resources = FALSE;
     imap->server.team_placement = MAP_DEFAULT_TEAM_PLACEMENT;
+    imap->server.mapgen_threads = MAP_DEFAULT_MAPGEN_THREADS;
   }
 }
 
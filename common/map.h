@@ -666,6 +666,10 @@ moves. Includes MAP_MAX_LINEAR_SIZE because a map can be non wrapping. */
 
 #define MAP_DEFAULT_TEAM_PLACEMENT  TEAM_PLACEMENT_CLOSEST
 
+#define MAP_DEFAULT_MAPGEN_THREADS  0
+#define MAP_MIN_MAPGEN_THREADS      0
+#define MAP_MAX_MAPGEN_THREADS      16
+
 /*
  * Inline function definitions.  These are at the bottom because they may use
  * elements defined above.
@@ -103,6 +103,8 @@ struct civ_map {
       bool have_huts;
       bool have_resources;
       enum team_placement team_placement;
+      int mapgen_threads;
+      int continents_stamp; /* Changes whenever continents are renumbered */
     } server;
 
     /* Add client side when needed */
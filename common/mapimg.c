@@ -26,6 +26,7 @@
 #include "bitvector.h"
 #include "fc_cmdline.h"
 #include "fcintl.h"
+#include "fcthread.h"
 #include "log.h"
 #include "mem.h"
 #include "string_vector.h"
@@ -92,10 +93,10 @@ struct tile_shape {
 };
 
 struct img;
+struct img_planes;
 
 typedef bv_pixel (*plot_func)(const struct tile *ptile,
-                              const struct player *pplayer,
-                              bool knowledge);
+                              const struct img_planes *planes);
 typedef void (*base_coor_func)(struct img *pimg, int *base_x, int *base_y,
                                int x, int y);
 
@@ -120,20 +121,15 @@ static struct tile_shape tile_rect = {
 };
 
 static bv_pixel pixel_tile_rect(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge);
+                                const struct img_planes *planes);
 static bv_pixel pixel_city_rect(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge);
+                                const struct img_planes *planes);
 static bv_pixel pixel_unit_rect(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge);
+                                const struct img_planes *planes);
 static bv_pixel pixel_fogofwar_rect(const struct tile *ptile,
-                                    const struct player *pplayer,
-                                    bool knowledge);
+                                    const struct img_planes *planes);
 static bv_pixel pixel_border_rect(const struct tile *ptile,
-                                  const struct player *pplayer,
-                                  bool knowledge);
+                                  const struct img_planes *planes);
 static void base_coor_rect(struct img *pimg, int *base_x, int *base_y,
                            int x, int y);
 
@@ -162,20 +158,15 @@ static struct tile_shape tile_hexa = {
 };
 
 static bv_pixel pixel_tile_hexa(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge);
+                                const struct img_planes *planes);
 static bv_pixel pixel_city_hexa(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge);
+                                const struct img_planes *planes);
 static bv_pixel pixel_unit_hexa(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge);
+                                const struct img_planes *planes);
 static bv_pixel pixel_fogofwar_hexa(const struct tile *ptile,
-                                    const struct player *pplayer,
-                                    bool knowledge);
+                                    const struct img_planes *planes);
 static bv_pixel pixel_border_hexa(const struct tile *ptile,
-                                  const struct player *pplayer,
-                                  bool knowledge);
+                                  const struct img_planes *planes);
 static void base_coor_hexa(struct img *pimg, int *base_x, int *base_y,
                            int x, int y);
 
@@ -200,20 +191,15 @@ static struct tile_shape tile_isohexa = {
 };
 
 static bv_pixel pixel_tile_isohexa(const struct tile *ptile,
-                                   const struct player *pplayer,
-                                   bool knowledge);
+                                   const struct img_planes *planes);
 static bv_pixel pixel_city_isohexa(const struct tile *ptile,
-                                   const struct player *pplayer,
-                                   bool knowledge);
+                                   const struct img_planes *planes);
 static bv_pixel pixel_unit_isohexa(const struct tile *ptile,
-                                   const struct player *pplayer,
-                                   bool knowledge);
+                                   const struct img_planes *planes);
 static bv_pixel pixel_fogofwar_isohexa(const struct tile *ptile,
-                                       const struct player *pplayer,
-                                       bool knowledge);
+                                       const struct img_planes *planes);
 static bv_pixel pixel_border_isohexa(const struct tile *ptile,
-                                     const struct player *pplayer,
-                                     bool knowledge);
+                                     const struct img_planes *planes);
 static void base_coor_isohexa(struct img *pimg, int *base_x, int *base_y,
                               int x, int y);
 
@@ -312,6 +298,13 @@ static bool mapimg_define_arg(struct mapdef *pmapdef, enum mapdef_arg arg,
 static bool mapimg_def2str(struct mapdef *pmapdef, char *str, size_t str_len);
 static bool mapimg_checkplayers(struct mapdef *pmapdef, bool recheck);
 static char *mapimg_generate_name(struct mapdef *pmapdef);
+static bool mapimg_create_full(struct mapdef *pmapdef, bool force,
+                               const char *savename, const char *path,
+                               bool background);
+static bool mapimg_create_image(struct mapdef *pmapdef,
+                                const char *mapimgfile, const char *path,
+                                bool background);
+static void mapimg_bg_thread(void *arg);
 
 /* == map definition == */
 struct mapdef {
@@ -384,8 +377,59 @@ struct img {
     int y;
   } imgsize; /* image size */
   const struct rgbcolor **map;
+
+  /* Player data needed to render and save the image. It is collected when
+   * the image is created, so that no access to the game state is needed
+   * afterwards. */
+  int plrcount;        /* number of players */
+  int plronly;         /* index of the only displayed player or -1 */
+  struct {
+    bool used;
+    bool alive;
+    bool allied;       /* allied with 'plronly' */
+    bool shared_vision; /* gives shared vision to 'plronly' */
+    struct rgbcolor rgb;
+  } players[MAX_NUM_PLAYER_SLOTS];
+  struct strvec *plrdesc; /* description of the displayed players */
+};
+
+/* Snapshot of the per-tile data of one view of the map (all players or
+ * the knowledge of one player). It is created on the main thread using the
+ * mapimg_tile_*() callbacks and can then be used to render images on any
+ * thread. */
+struct img_planes {
+  const struct player *pplayer; /* NULL for the global view */
+  bool knowledge;
+  bool borders;
+  bool fogofwar;
+
+  int tiles;
+  enum known_type *known;
+  const struct terrain **terrain;
+  /* Player indices or -1. */
+  int *owner;
+  int *city;
+  int *unit;
 };
 
+/* List of tile planes. */
+#define SPECLIST_TAG img_planes
+#define SPECLIST_TYPE struct img_planes
+#include "speclist.h"
+
+#define img_planes_list_iterate(planes_list, pplanes) \
+  TYPED_LIST_ITERATE(struct img_planes, planes_list, pplanes)
+#define img_planes_list_iterate_end \
+  LIST_ITERATE_END
+
+static struct img_planes *img_planes_new(const struct player *pplayer,
+                                         bool knowledge);
+static void img_planes_destroy(struct img_planes *planes);
+static inline enum known_type img_planes_known(const struct img_planes *planes,
+                                               const struct tile *ptile);
+static inline int img_planes_owner(const struct img_planes *planes,
+                                   const struct tile *ptile);
+
 static struct img *img_new(struct mapdef *mapdef, int topo, int xsize, int ysize);
 static void img_destroy(struct img *pimg);
 static inline void img_set_pixel(struct img *pimg, const int mindex,
@@ -406,7 +450,29 @@ static bool img_save_magickwand(const struct img *pimg,
 #endif /* HAVE_MAPIMG_MAGICKWAND */
 static bool img_filename(const char *mapimgfile, enum imageformat format,
                          char *filename, size_t filename_len);
-static void img_createmap(struct img *pimg);
+static void img_createmap(struct img *pimg,
+                          const struct img_planes *planes);
+static const struct rgbcolor *img_plrcolor(const struct img *pimg,
+                                           int plr_id);
+
+/* == background creation of map images == */
+struct img_job {
+  struct mapdef def; /* copy of the map definition */
+  struct img *pimg;
+  const struct img_planes *planes;
+  char mapimgfile[MAX_LEN_PATH];
+  char path[MAX_LEN_PATH];
+  bool has_path;
+};
+
+#define SPECLIST_TAG img_job
+#define SPECLIST_TYPE struct img_job
+#include "speclist.h"
+
+static struct img_job *img_job_new(const struct mapdef *pmapdef,
+                                   const char *mapimgfile,
+                                   const char *path);
+static void img_job_destroy(struct img_job *job);
 
 /* == image toolkits == */
 typedef bool (*img_save_func)(const struct img *pimg,
@@ -458,9 +524,7 @@ static const struct toolkit *img_toolkit_get(enum imagetool tool);
   }
 
 /* == logging == */
-#define MAX_LEN_ERRORBUF 1024
-
-static char error_buffer[MAX_LEN_ERRORBUF] = "\0";
+static char error_buffer[MAX_LEN_MAPIMG_ERROR] = "\0";
 static void mapimg_log(const char *file, const char *function, int line,
                        const char *format, ...)
                        fc__attribute((__format__(__printf__, 4, 5)));
@@ -486,6 +550,16 @@ static struct {
   mapimg_tile_player_func mapimg_tile_unit;
   mapimg_plrcolor_count_func mapimg_plrcolor_count;
   mapimg_plrcolor_get_func mapimg_plrcolor_get;
+
+  fc_mutex error_mutex;
+
+  /* Map images rendered and saved in the background. */
+  struct {
+    struct img_job_list *jobs;
+    struct img_planes_list *planes;
+    fc_thread *threads;
+    int thread_count;
+  } bg;
 } mapimg = { .init = FALSE };
 
 /*
@@ -512,6 +586,11 @@ void mapimg_init(mapimg_tile_known_func mapimg_tile_known,
   }
 
   mapimg.mapdef = mapdef_list_new();
+  mapimg.bg.jobs = img_job_list_new();
+  mapimg.bg.planes = img_planes_list_new();
+  mapimg.bg.threads = NULL;
+  mapimg.bg.thread_count = 0;
+  fc_init_mutex(&mapimg.error_mutex);
 
   fc_assert_ret(mapimg_tile_known != NULL);
   mapimg.mapimg_tile_known = mapimg_tile_known;
@@ -540,6 +619,8 @@ void mapimg_reset(void)
     return;
   }
 
+  mapimg_wait();
+
   if (mapdef_list_size(mapimg.mapdef) > 0) {
     mapdef_list_iterate(mapimg.mapdef, pmapdef) {
       mapdef_list_remove(mapimg.mapdef, pmapdef);
@@ -559,8 +640,11 @@ void mapimg_free(void)
 
   mapimg_reset();
   mapdef_list_destroy(mapimg.mapdef);
+  img_job_list_destroy(mapimg.bg.jobs);
+  img_planes_list_destroy(mapimg.bg.planes);
 
   mapimg.init = FALSE;
+  fc_destroy_mutex(&mapimg.error_mutex);
 }
 
 /************************************************************************//**
@@ -746,11 +830,22 @@ char *mapimg_help(const char *cmdname)
 }
 
 /************************************************************************//**
-  Returns the last error.
+  Copies the last error to buf and returns buf. The error may be set by
+  background threads at any time, so it is not handed out directly.
 ****************************************************************************/
-const char *mapimg_error(void)
+const char *mapimg_error(char *buf, size_t bufsz)
 {
-  return error_buffer;
+  if (mapimg_initialised()) {
+    fc_allocate_mutex(&mapimg.error_mutex);
+  }
+
+  fc_strlcpy(buf, error_buffer, bufsz);
+
+  if (mapimg_initialised()) {
+    fc_release_mutex(&mapimg.error_mutex);
+  }
+
+  return buf;
 }
 
 /************************************************************************//**
@@ -1324,100 +1419,89 @@ bool mapimg_id2str(int id, char *str, size_t str_len)
 bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
                    const char *path)
 {
-  struct img *pimg;
-  char mapimgfile[MAX_LEN_PATH];
-  bool ret = TRUE;
-#ifdef FREECIV_DEBUG
-  struct timer *timer_cpu, *timer_user;
-#endif
+  /* Do not write the same files as a still running background job. */
+  mapimg_wait();
 
-  if (map_is_empty()) {
-    MAPIMG_LOG(_("map not yet created"));
+  return mapimg_create_full(pmapdef, force, savename, path, FALSE);
+}
 
-    return FALSE;
+/************************************************************************//**
+  Create the map images of all valid map definitions for the current turn
+  (see mapimg_create()). If 'threads' is larger than zero, the tile data
+  is only collected here; the images are rendered and saved by up to
+  'threads' background threads while the game continues. Use mapimg_wait()
+  to wait for them.
+****************************************************************************/
+void mapimg_create_all(int threads, const char *savename, const char *path)
+{
+  char error[MAX_LEN_MAPIMG_ERROR];
+  int i, count;
+
+  if (!mapimg_initialised()) {
+    return;
   }
 
-  mapimg_checkplayers(pmapdef, FALSE);
+  /* Finish the images of the last call. */
+  mapimg_wait();
 
-  if (pmapdef->status != MAPIMG_STATUS_OK) {
-    MAPIMG_LOG(_("map definition not checked or error"));
-    return FALSE;
-  }
+  for (i = 0; i < mapimg_count(); i++) {
+    struct mapdef *pmapdef = mapimg_isvalid(i);
 
-  /* An image should be saved if:
-   * - force is set to TRUE
-   * - it is the first turn
-   * - turns is set to a value not zero and the current turn can be devided
-   *   by this number */
-  if (!force && game.info.turn != 1
-      && !(pmapdef->turns != 0 && game.info.turn % pmapdef->turns == 0)) {
-    return TRUE;
+    if (pmapdef == NULL) {
+      log_error("%s", mapimg_error(error, sizeof(error)));
+    } else if (!mapimg_create_full(pmapdef, FALSE, savename, path,
+                                   threads > 0)) {
+      log_error("%s", mapimg_error(error, sizeof(error)));
+    }
   }
 
-#ifdef FREECIV_DEBUG
-  timer_cpu = timer_new(TIMER_CPU, TIMER_ACTIVE);
-  timer_start(timer_cpu);
-  timer_user = timer_new(TIMER_USER, TIMER_ACTIVE);
-  timer_start(timer_user);
-#endif /* FREECIV_DEBUG */
-
-  /* create map */
-  switch (pmapdef->player.show) {
-  case SHOW_PLRNAME: /* display player given by name */
-  case SHOW_PLRID:   /* display player given by id */
-  case SHOW_NONE:    /* no player one the map */
-  case SHOW_ALL:     /* show all players in one map */
-  case SHOW_PLRBV:   /* display player(s) given by bitvector */
-    generate_save_name(savename, mapimgfile, sizeof(mapimgfile),
-                       mapimg_generate_name(pmapdef));
+  count = MIN(threads, img_job_list_size(mapimg.bg.jobs));
+  if (count <= 0) {
+    return;
+  }
 
-    pimg = img_new(pmapdef, CURRENT_TOPOLOGY, wld.map.xsize, wld.map.ysize);
-    img_createmap(pimg);
-    if (!img_save(pimg, mapimgfile, path)) {
-      ret = FALSE;
+  mapimg.bg.threads = fc_malloc(count * sizeof(*mapimg.bg.threads));
+  mapimg.bg.thread_count = 0;
+  for (i = 0; i < count; i++) {
+    if (fc_thread_start(&mapimg.bg.threads[mapimg.bg.thread_count],
+                        mapimg_bg_thread, NULL) == 0) {
+      mapimg.bg.thread_count++;
     }
-    img_destroy(pimg);
-    break;
-  case SHOW_EACH:    /* one map for each player */
-  case SHOW_HUMAN:   /* one map for each human player */
-    players_iterate(pplayer) {
-      if (!pplayer->is_alive || (pmapdef->player.show == SHOW_HUMAN
-                                 && !is_human(pplayer))) {
-        /* no map image for dead players
-         * or AI players if only human players should be shown */
-        continue;
-      }
-
-      BV_CLR_ALL(pmapdef->player.checked_plrbv);
-      BV_SET(pmapdef->player.checked_plrbv, player_index(pplayer));
+  }
 
-      generate_save_name(savename, mapimgfile, sizeof(mapimgfile),
-                         mapimg_generate_name(pmapdef));
+  if (mapimg.bg.thread_count == 0) {
+    /* No thread could be started; do the work here. */
+    log_error(_("Can't start map image threads."));
+    mapimg_bg_thread(NULL);
+  }
+}
 
-      pimg = img_new(pmapdef, CURRENT_TOPOLOGY, wld.map.xsize, wld.map.ysize);
-      img_createmap(pimg);
-      if (!img_save(pimg, mapimgfile, path)) {
-        ret = FALSE;
-      }
-      img_destroy(pimg);
+/************************************************************************//**
+  Wait until all map images created in the background are saved.
+****************************************************************************/
+void mapimg_wait(void)
+{
+  int i;
 
-      if (!ret) {
-        break;
-      }
-    } players_iterate_end;
-    break;
+  if (!mapimg_initialised()) {
+    return;
   }
 
-#ifdef FREECIV_DEBUG
-  log_debug("Image generation time: %g seconds (%g apparent)",
-            timer_read_seconds(timer_cpu),
-            timer_read_seconds(timer_user));
+  for (i = 0; i < mapimg.bg.thread_count; i++) {
+    fc_thread_wait(&mapimg.bg.threads[i]);
+  }
+  mapimg.bg.thread_count = 0;
+  if (mapimg.bg.threads != NULL) {
+    free(mapimg.bg.threads);
+    mapimg.bg.threads = NULL;
+  }
 
-  timer_destroy(timer_cpu);
-  timer_destroy(timer_user);
-#endif /* FREECIV_DEBUG */
+  fc_assert(img_job_list_size(mapimg.bg.jobs) == 0);
 
-  return ret;
+  img_planes_list_iterate(mapimg.bg.planes, planes) {
+    img_planes_destroy(planes);
+  } img_planes_list_iterate_end;
+  img_planes_list_clear(mapimg.bg.planes);
 }
 
 /************************************************************************//**
@@ -1444,7 +1528,7 @@ bool mapimg_colortest(const char *savename, const char *path)
   pimg = img_new(pmapdef, 0, SIZE_X + 2,
                  SIZE_Y * (max_playercolor / SIZE_X) + 2);
 
-  pixel = pimg->pixel_tile(NULL, NULL, FALSE);
+  pixel = pimg->pixel_tile(NULL, NULL);
 
   pcolor = imgcolor_special(IMGCOLOR_OCEAN);
   for (i = 0; i < MAX(max_playercolor, max_terraincolor); i++) {
@@ -1699,6 +1783,11 @@ static void mapimg_log(const char *file, const char *function, int line,
 {
   va_list args;
 
+  /* Map images can also be created by background threads. */
+  if (mapimg_initialised()) {
+    fc_allocate_mutex(&mapimg.error_mutex);
+  }
+
   va_start(args, format);
   fc_vsnprintf(error_buffer, sizeof(error_buffer), format, args);
   va_end(args);
@@ -1706,6 +1795,10 @@ static void mapimg_log(const char *file, const char *function, int line,
 #ifdef FREECIV_DEBUG
   log_debug("In %s() [%s:%d]: %s", function, file, line, error_buffer);
 #endif
+
+  if (mapimg_initialised()) {
+    fc_release_mutex(&mapimg.error_mutex);
+  }
 }
 
 /************************************************************************//**
@@ -1785,6 +1878,222 @@ static char *mapimg_generate_name(struct mapdef *pmapdef)
   return mapstr;
 }
 
+/************************************************************************//**
+  Create the requested map image(s); see mapimg_create(). If 'background'
+  is TRUE, the images are only queued for the background threads.
+****************************************************************************/
+static bool mapimg_create_full(struct mapdef *pmapdef, bool force,
+                               const char *savename, const char *path,
+                               bool background)
+{
+  char mapimgfile[MAX_LEN_PATH];
+  bool ret = TRUE;
+#ifdef FREECIV_DEBUG
+  struct timer *timer_cpu, *timer_user;
+#endif
+
+  if (map_is_empty()) {
+    MAPIMG_LOG(_("map not yet created"));
+
+    return FALSE;
+  }
+
+  mapimg_checkplayers(pmapdef, FALSE);
+
+  if (pmapdef->status != MAPIMG_STATUS_OK) {
+    MAPIMG_LOG(_("map definition not checked or error"));
+    return FALSE;
+  }
+
+  /* An image should be saved if:
+   * - force is set to TRUE
+   * - it is the first turn
+   * - turns is set to a value not zero and the current turn can be devided
+   *   by this number */
+  if (!force && game.info.turn != 1
+      && !(pmapdef->turns != 0 && game.info.turn % pmapdef->turns == 0)) {
+    return TRUE;
+  }
+
+#ifdef FREECIV_DEBUG
+  timer_cpu = timer_new(TIMER_CPU, TIMER_ACTIVE);
+  timer_start(timer_cpu);
+  timer_user = timer_new(TIMER_USER, TIMER_ACTIVE);
+  timer_start(timer_user);
+#endif /* FREECIV_DEBUG */
+
+  /* create map */
+  switch (pmapdef->player.show) {
+  case SHOW_PLRNAME: /* display player given by name */
+  case SHOW_PLRID:   /* display player given by id */
+  case SHOW_NONE:    /* no player one the map */
+  case SHOW_ALL:     /* show all players in one map */
+  case SHOW_PLRBV:   /* display player(s) given by bitvector */
+    generate_save_name(savename, mapimgfile, sizeof(mapimgfile),
+                       mapimg_generate_name(pmapdef));
+
+    if (!mapimg_create_image(pmapdef, mapimgfile, path, background)) {
+      ret = FALSE;
+    }
+    break;
+  case SHOW_EACH:    /* one map for each player */
+  case SHOW_HUMAN:   /* one map for each human player */
+    players_iterate(pplayer) {
+      if (!pplayer->is_alive || (pmapdef->player.show == SHOW_HUMAN
+                                 && !is_human(pplayer))) {
+        /* no map image for dead players
+         * or AI players if only human players should be shown */
+        continue;
+      }
+
+      BV_CLR_ALL(pmapdef->player.checked_plrbv);
+      BV_SET(pmapdef->player.checked_plrbv, player_index(pplayer));
+
+      generate_save_name(savename, mapimgfile, sizeof(mapimgfile),
+                         mapimg_generate_name(pmapdef));
+
+      if (!mapimg_create_image(pmapdef, mapimgfile, path, background)) {
+        ret = FALSE;
+      }
+
+      if (!ret) {
+        break;
+      }
+    } players_iterate_end;
+    break;
+  }
+
+#ifdef FREECIV_DEBUG
+  log_debug("Image generation time: %g seconds (%g apparent)",
+            timer_read_seconds(timer_cpu),
+            timer_read_seconds(timer_user));
+
+  timer_destroy(timer_cpu);
+  timer_destroy(timer_user);
+#endif /* FREECIV_DEBUG */
+
+  return ret;
+}
+
+/************************************************************************//**
+  Create one map image. If 'background' is TRUE, only the tile data is
+  collected and the image is queued for the background threads. The tile
+  data is shared by all queued images with the same view of the map.
+****************************************************************************/
+static bool mapimg_create_image(struct mapdef *pmapdef,
+                                const char *mapimgfile, const char *path,
+                                bool background)
+{
+  struct img *pimg;
+  struct img_planes *planes;
+  const struct player *pplayer;
+  bool knowledge = pmapdef->layers[MAPIMG_LAYER_KNOWLEDGE];
+  bool ret = TRUE;
+
+  if (background) {
+    struct img_job *job = img_job_new(pmapdef, mapimgfile, path);
+
+    pimg = job->pimg;
+    pplayer = (pimg->plronly != -1 ? player_by_number(pimg->plronly)
+                                   : NULL);
+
+    /* Without knowledge the tile data does not depend on the player. */
+    img_planes_list_iterate(mapimg.bg.planes, pplanes) {
+      if (pplanes->knowledge == knowledge
+          && (!knowledge || pplanes->pplayer == pplayer)) {
+        job->planes = pplanes;
+        break;
+      }
+    } img_planes_list_iterate_end;
+
+    if (job->planes == NULL) {
+      planes = img_planes_new(pplayer, knowledge);
+      img_planes_list_append(mapimg.bg.planes, planes);
+      job->planes = planes;
+    }
+
+    img_job_list_append(mapimg.bg.jobs, job);
+
+    return TRUE;
+  }
+
+  pimg = img_new(pmapdef, CURRENT_TOPOLOGY, wld.map.xsize, wld.map.ysize);
+  pplayer = (pimg->plronly != -1 ? player_by_number(pimg->plronly) : NULL);
+  planes = img_planes_new(pplayer, knowledge);
+
+  img_createmap(pimg, planes);
+  if (!img_save(pimg, mapimgfile, path)) {
+    ret = FALSE;
+  }
+
+  img_planes_destroy(planes);
+  img_destroy(pimg);
+
+  return ret;
+}
+
+/************************************************************************//**
+  Main function of the background threads. Render and save queued map
+  images until none is left.
+****************************************************************************/
+static void mapimg_bg_thread(void *arg)
+{
+  struct img_job *job;
+
+  while (TRUE) {
+    img_job_list_allocate_mutex(mapimg.bg.jobs);
+    job = img_job_list_front(mapimg.bg.jobs);
+    if (job != NULL) {
+      img_job_list_pop_front(mapimg.bg.jobs);
+    }
+    img_job_list_release_mutex(mapimg.bg.jobs);
+
+    if (job == NULL) {
+      break;
+    }
+
+    img_createmap(job->pimg, job->planes);
+    if (!img_save(job->pimg, job->mapimgfile,
+                  job->has_path ? job->path : NULL)) {
+      log_error(_("Can't save map image '%s'."), job->mapimgfile);
+    }
+
+    img_job_destroy(job);
+  }
+}
+
+/************************************************************************//**
+  Create a new background job. The map definition is copied as it can
+  change before the job is done.
+****************************************************************************/
+static struct img_job *img_job_new(const struct mapdef *pmapdef,
+                                   const char *mapimgfile,
+                                   const char *path)
+{
+  struct img_job *job = fc_malloc(sizeof(*job));
+
+  job->def = *pmapdef;
+  sz_strlcpy(job->mapimgfile, mapimgfile);
+  job->has_path = (path != NULL);
+  if (path != NULL) {
+    sz_strlcpy(job->path, path);
+  }
+  job->pimg = img_new(&job->def, CURRENT_TOPOLOGY, wld.map.xsize,
+                      wld.map.ysize);
+  job->planes = NULL;
+
+  return job;
+}
+
+/************************************************************************//**
+  Destroy a background job. The tile data is not freed.
+****************************************************************************/
+static void img_job_destroy(struct img_job *job)
+{
+  img_destroy(job->pimg);
+  free(job);
+}
+
 /*
  * ==============================================
  * map definitions (internal functions)
@@ -1949,6 +2258,43 @@ static struct img *img_new(struct mapdef *mapdef, int topo, int xsize, int ysize
   /* Initialise map. */
   memset(pimg->map, 0, pimg->imgsize.x * pimg->imgsize.y);
 
+  /* Player data. */
+  memset(pimg->players, 0, sizeof(pimg->players));
+  pimg->plrcount = player_count();
+  pimg->plronly = -1;
+  pimg->plrdesc = strvec_new();
+
+  if (bvplayers_count(mapdef) == 1) {
+    /* only one player; its knowledge is used for 'known' and 'fogofwar' */
+    players_iterate(pplayer) {
+      if (BV_ISSET(mapdef->player.checked_plrbv, player_index(pplayer))) {
+        pimg->plronly = player_index(pplayer);
+        break;
+      }
+    } players_iterate_end;
+  }
+
+  players_iterate(pplayer) {
+    int plr_id = player_index(pplayer);
+
+    pimg->players[plr_id].used = TRUE;
+    pimg->players[plr_id].alive = pplayer->is_alive;
+    pimg->players[plr_id].rgb = *imgcolor_player(plr_id);
+    pimg->players[plr_id].rgb.color = NULL;
+
+    if (pimg->plronly != -1) {
+      struct player *pplr_only = player_by_number(pimg->plronly);
+
+      pimg->players[plr_id].allied = pplayers_allied(pplayer, pplr_only);
+      pimg->players[plr_id].shared_vision
+        = gives_shared_vision(pplayer, pplr_only);
+    }
+
+    if (BV_ISSET(mapdef->player.checked_plrbv, plr_id)) {
+      strvec_append(pimg->plrdesc, img_playerstr(pplayer));
+    }
+  } players_iterate_end;
+
   return pimg;
 }
 
@@ -1960,6 +2306,7 @@ static void img_destroy(struct img *pimg)
   if (pimg != NULL) {
     /* do not free pimg->def */
     free(pimg->map);
+    strvec_destroy(pimg->plrdesc);
     free(pimg);
   }
 }
@@ -2092,7 +2439,6 @@ static bool img_save_magickwand(const struct img *pimg,
                                 const char *mapimgfile)
 {
   const struct rgbcolor *pcolor = NULL;
-  struct player *pplr_now = NULL, *pplr_only = NULL;
   bool ret = TRUE;
   char imagefile[MAX_LEN_PATH];
   char str_color[32], comment[2048] = "", title[258];
@@ -2132,22 +2478,13 @@ static bool img_save_magickwand(const struct img *pimg,
 
   textoffset = 0;
   if (withplr) {
-    if (bvplayers_count(pimg->def) == 1) {
+    if (pimg->plronly != -1) {
       /* only one player */
-      for (i = 0; i < player_slot_count(); i++) {
-        if (BV_ISSET(pimg->def->player.checked_plrbv, i)) {
-          pplr_only = player_by_number(i);
-          break;
-        }
-      }
-    }
-
-    if (pplr_only) {
       magickwand_size_t plr_color_square = IMG_TEXT_HEIGHT;
 
       textoffset += IMG_TEXT_HEIGHT + IMG_BORDER_HEIGHT;
 
-      pcolor = imgcolor_player(player_index(pplr_only));
+      pcolor = img_plrcolor(pimg, pimg->plronly);
       SET_COLOR(str_color, pcolor);
 
       /* Show the color of the selected player. */
@@ -2166,8 +2503,8 @@ static bool img_save_magickwand(const struct img *pimg,
     }
 
     /* Show a line displaying the colors of alive players */
-    plrwidth = map_width / MIN(map_width, player_count());
-    plroffset = (map_width - MIN(map_width, plrwidth * player_count())) / 2;
+    plrwidth = map_width / MIN(map_width, pimg->plrcount);
+    plroffset = (map_width - MIN(map_width, plrwidth * pimg->plrcount)) / 2;
 
     imw = NewPixelRegionIterator(mw, IMG_BORDER_WIDTH,
                                  IMG_BORDER_HEIGHT + IMG_TEXT_HEIGHT
@@ -2180,18 +2517,18 @@ static bool img_save_magickwand(const struct img *pimg,
       /* x coordinate */
       for (x = plroffset; x < map_width; x++) {
         i = (x - plroffset) / plrwidth;
-        pplr_now = player_by_number(i);
 
-        if (i > player_count() || pplr_now == NULL || !pplr_now->is_alive) {
+        if (i > pimg->plrcount || i >= ARRAY_SIZE(pimg->players)
+            || !pimg->players[i].used || !pimg->players[i].alive) {
           continue;
         }
 
         if (BV_ISSET(pimg->def->player.checked_plrbv, i)) {
           /* The selected player is alive - display it. */
-          pcolor = imgcolor_player(i);
+          pcolor = img_plrcolor(pimg, i);
           SET_COLOR(str_color, pcolor);
           PixelSetColor(pmw[x], str_color);
-        } else if (pplr_only != NULL) {
+        } else if (pimg->plronly != -1) {
           /* Display the state between pplr_only and pplr_now:
            *  - if allied:
            *      - show each second pixel
@@ -2204,9 +2541,9 @@ static bool img_save_magickwand(const struct img *pimg,
            *                # # #       # # #
            *   shared      allied      shared vision
            *   vision                   + allied */
-          if ((pplayers_allied(pplr_now, pplr_only) && (x + y) % 2 == 0)
-              || (y % 2 == 0 && gives_shared_vision(pplr_now, pplr_only))) {
-            pcolor = imgcolor_player(i);
+          if ((pimg->players[i].allied && (x + y) % 2 == 0)
+              || (y % 2 == 0 && pimg->players[i].shared_vision)) {
+            pcolor = img_plrcolor(pimg, i);
             SET_COLOR(str_color, pcolor);
             PixelSetColor(pmw[x], str_color);
           }
@@ -2264,14 +2601,9 @@ static bool img_save_magickwand(const struct img *pimg,
   cat_snprintf(comment, sizeof(comment), "map definition: %s\n",
                pimg->def->maparg);
   if (BV_ISSET_ANY(pimg->def->player.checked_plrbv)) {
-    players_iterate(pplayer) {
-      if (!BV_ISSET(pimg->def->player.checked_plrbv, player_index(pplayer))) {
-        continue;
-      }
-
-      pcolor = imgcolor_player(player_index(pplayer));
-      cat_snprintf(comment, sizeof(comment), "%s\n", img_playerstr(pplayer));
-    } players_iterate_end;
+    strvec_iterate(pimg->plrdesc, desc) {
+      cat_snprintf(comment, sizeof(comment), "%s\n", desc);
+    } strvec_iterate_end;
   }
   MagickCommentImage(mw, comment);
 
@@ -2327,14 +2659,9 @@ static bool img_save_ppm(const struct img *pimg, const char *mapimgfile)
   if (pimg->def->colortest) {
     fprintf(fp, "# color test\n");
   } else if (BV_ISSET_ANY(pimg->def->player.checked_plrbv)) {
-    players_iterate(pplayer) {
-      if (!BV_ISSET(pimg->def->player.checked_plrbv, player_index(pplayer))) {
-        continue;
-      }
-
-      pcolor = imgcolor_player(player_index(pplayer));
-      fprintf(fp, "# %s\n", img_playerstr(pplayer));
-    } players_iterate_end;
+    strvec_iterate(pimg->plrdesc, desc) {
+      fprintf(fp, "# %s\n", desc);
+    } strvec_iterate_end;
   } else {
     fprintf(fp, "# no players\n");
   }
@@ -2401,49 +2728,40 @@ static const char *img_playerstr(const struct player *pplayer)
 
 /************************************************************************//**
   Create the map considering the options (terrain, player(s), cities,
-  units, borders, known, fogofwar, ...).
+  units, borders, known, fogofwar, ...). All tile data is taken from
+  'planes', so this can be called from any thread.
 ****************************************************************************/
-static void img_createmap(struct img *pimg)
+static void img_createmap(struct img *pimg, const struct img_planes *planes)
 {
   const struct rgbcolor *pcolor;
   bv_pixel pixel;
-  int player_id;
-  struct player *pplayer = NULL;
-  struct player *plr_tile = NULL, *plr_city = NULL, *plr_unit = NULL;
-  enum known_type tile_knowledge = TILE_UNKNOWN;
-  struct terrain *pterrain = NULL;
+  int player_id, tindex;
+  int plr_tile, plr_city, plr_unit;
+  enum known_type tile_knowledge;
+  const struct terrain *pterrain;
   bool plr_knowledge = pimg->def->layers[MAPIMG_LAYER_KNOWLEDGE];
+  /* only one player; use its knowledge for 'known' and 'fogofwar' */
+  bool plr_view = (pimg->plronly != -1);
 
   whole_map_iterate(&(wld.map), ptile) {
-    if (bvplayers_count(pimg->def) == 1) {
-      /* only one player; get player id for 'known' and 'fogofwar' */
-      players_iterate(aplayer) {
-        if (BV_ISSET(pimg->def->player.checked_plrbv,
-                     player_index(aplayer))) {
-          pplayer = aplayer;
-          tile_knowledge = mapimg.mapimg_tile_known(ptile, pplayer,
-                                                    plr_knowledge);
-          break;
-        }
-      } players_iterate_end;
-    }
+    tindex = tile_index(ptile);
+    tile_knowledge = plr_view ? planes->known[tindex] : TILE_UNKNOWN;
 
     /* known tiles */
-    if (plr_knowledge && pplayer != NULL && tile_knowledge == TILE_UNKNOWN) {
+    if (plr_knowledge && plr_view && tile_knowledge == TILE_UNKNOWN) {
       /* plot nothing iff tile is not known */
       continue;
     }
 
     /* terrain */
-    pterrain = mapimg.mapimg_tile_terrain(ptile, pplayer, plr_knowledge);
+    pterrain = planes->terrain[tindex];
+    pixel = pimg->pixel_tile(ptile, planes);
     if (pimg->def->layers[MAPIMG_LAYER_TERRAIN]) {
       /* full terrain */
-      pixel = pimg->pixel_tile(ptile, pplayer, plr_knowledge);
       pcolor = imgcolor_terrain(pterrain);
       img_plot_tile(pimg, ptile, pcolor, pixel);
     } else {
       /* basic terrain */
-      pixel = pimg->pixel_tile(ptile, pplayer, plr_knowledge);
       if (is_ocean(pterrain)) {
         img_plot_tile(pimg, ptile, imgcolor_special(IMGCOLOR_OCEAN), pixel);
       } else {
@@ -2452,62 +2770,159 @@ static void img_createmap(struct img *pimg)
     }
 
     /* (land) area within borders and borders */
-    plr_tile = mapimg.mapimg_tile_owner(ptile, pplayer, plr_knowledge);
-    if (game.info.borders > 0 && NULL != plr_tile) {
-      player_id = player_index(plr_tile);
+    plr_tile = planes->owner[tindex];
+    if (planes->borders && plr_tile != -1) {
+      player_id = plr_tile;
       if (pimg->def->layers[MAPIMG_LAYER_AREA] && !is_ocean(pterrain)
           && BV_ISSET(pimg->def->player.checked_plrbv, player_id)) {
         /* the tile is land and inside the players borders */
-        pixel = pimg->pixel_tile(ptile, pplayer, plr_knowledge);
-        pcolor = imgcolor_player(player_id);
+        pixel = pimg->pixel_tile(ptile, planes);
+        pcolor = img_plrcolor(pimg, player_id);
         img_plot_tile(pimg, ptile, pcolor, pixel);
       } else if (pimg->def->layers[MAPIMG_LAYER_BORDERS]
                  && (BV_ISSET(pimg->def->player.checked_plrbv, player_id)
-                     || (plr_knowledge && pplayer != NULL))) {
+                     || (plr_knowledge && plr_view))) {
         /* plot borders if player is selected or view range of the one
          * displayed player */
-        pixel = pimg->pixel_border(ptile, pplayer, plr_knowledge);
-        pcolor = imgcolor_player(player_id);
+        pixel = pimg->pixel_border(ptile, planes);
+        pcolor = img_plrcolor(pimg, player_id);
         img_plot_tile(pimg, ptile, pcolor, pixel);
       }
     }
 
     /* cities and units */
-    plr_city = mapimg.mapimg_tile_city(ptile, pplayer, plr_knowledge);
-    plr_unit = mapimg.mapimg_tile_unit(ptile, pplayer, plr_knowledge);
-    if (pimg->def->layers[MAPIMG_LAYER_CITIES] && plr_city) {
-      player_id = player_index(plr_city);
+    plr_city = planes->city[tindex];
+    plr_unit = planes->unit[tindex];
+    if (pimg->def->layers[MAPIMG_LAYER_CITIES] && plr_city != -1) {
+      player_id = plr_city;
       if (BV_ISSET(pimg->def->player.checked_plrbv, player_id)
-          || (plr_knowledge && pplayer != NULL)) {
+          || (plr_knowledge && plr_view)) {
         /* plot cities if player is selected or view range of the one
          * displayed player */
-        pixel = pimg->pixel_city(ptile, pplayer, plr_knowledge);
-        pcolor = imgcolor_player(player_id);
+        pixel = pimg->pixel_city(ptile, planes);
+        pcolor = img_plrcolor(pimg, player_id);
         img_plot_tile(pimg, ptile, pcolor, pixel);
       }
-    } else if (pimg->def->layers[MAPIMG_LAYER_UNITS] && plr_unit) {
-      player_id = player_index(plr_unit);
+    } else if (pimg->def->layers[MAPIMG_LAYER_UNITS] && plr_unit != -1) {
+      player_id = plr_unit;
       if (BV_ISSET(pimg->def->player.checked_plrbv, player_id)
-          || (plr_knowledge && pplayer != NULL)) {
+          || (plr_knowledge && plr_view)) {
         /* plot units if player is selected or view range of the one
          * displayed player */
-        pixel = pimg->pixel_unit(ptile, pplayer, plr_knowledge);
-        pcolor = imgcolor_player(player_id);
+        pixel = pimg->pixel_unit(ptile, planes);
+        pcolor = img_plrcolor(pimg, player_id);
         img_plot_tile(pimg, ptile, pcolor, pixel);
       }
     }
 
     /* fogofwar; if only 1 player is plotted */
-    if (game.info.fogofwar && pimg->def->layers[MAPIMG_LAYER_FOGOFWAR]
-        && pplayer != NULL
-        && tile_knowledge == TILE_KNOWN_UNSEEN) {
-      pixel = pimg->pixel_fogofwar(ptile, pplayer, plr_knowledge);
+    if (planes->fogofwar && pimg->def->layers[MAPIMG_LAYER_FOGOFWAR]
+        && plr_view && tile_knowledge == TILE_KNOWN_UNSEEN) {
+      pixel = pimg->pixel_fogofwar(ptile, planes);
       pcolor = NULL;
       img_plot_tile(pimg, ptile, pcolor, pixel);
     }
   } whole_map_iterate_end;
 }
 
+/************************************************************************//**
+  Return the color of a player as saved in the image.
+****************************************************************************/
+static const struct rgbcolor *img_plrcolor(const struct img *pimg,
+                                           int plr_id)
+{
+  fc_assert_ret_val(plr_id >= 0 && plr_id < ARRAY_SIZE(pimg->players),
+                    imgcolor_special(IMGCOLOR_ERROR));
+  fc_assert_ret_val(pimg->players[plr_id].used,
+                    imgcolor_special(IMGCOLOR_ERROR));
+
+  return &pimg->players[plr_id].rgb;
+}
+
+/*
+ * ==============================================
+ * tile planes (internal functions)
+ * ==============================================
+ */
+
+/************************************************************************//**
+  Collect the tile data of the whole map as seen by 'pplayer' (if
+  'knowledge' is set).
+****************************************************************************/
+static struct img_planes *img_planes_new(const struct player *pplayer,
+                                         bool knowledge)
+{
+  struct img_planes *planes = fc_malloc(sizeof(*planes));
+
+  planes->pplayer = pplayer;
+  planes->knowledge = knowledge;
+  planes->borders = (game.info.borders > 0);
+  planes->fogofwar = game.info.fogofwar;
+
+  planes->tiles = MAP_INDEX_SIZE;
+  planes->known = fc_malloc(planes->tiles * sizeof(*planes->known));
+  planes->terrain = fc_malloc(planes->tiles * sizeof(*planes->terrain));
+  planes->owner = fc_malloc(planes->tiles * sizeof(*planes->owner));
+  planes->city = fc_malloc(planes->tiles * sizeof(*planes->city));
+  planes->unit = fc_malloc(planes->tiles * sizeof(*planes->unit));
+
+  whole_map_iterate(&(wld.map), ptile) {
+    int tindex = tile_index(ptile);
+    struct player *plr;
+
+    if (pplayer != NULL) {
+      planes->known[tindex] = mapimg.mapimg_tile_known(ptile, pplayer,
+                                                       knowledge);
+    } else {
+      planes->known[tindex] = TILE_KNOWN_SEEN;
+    }
+    planes->terrain[tindex] = mapimg.mapimg_tile_terrain(ptile, pplayer,
+                                                         knowledge);
+
+    plr = mapimg.mapimg_tile_owner(ptile, pplayer, knowledge);
+    planes->owner[tindex] = (plr != NULL ? player_index(plr) : -1);
+    plr = mapimg.mapimg_tile_city(ptile, pplayer, knowledge);
+    planes->city[tindex] = (plr != NULL ? player_index(plr) : -1);
+    plr = mapimg.mapimg_tile_unit(ptile, pplayer, knowledge);
+    planes->unit[tindex] = (plr != NULL ? player_index(plr) : -1);
+  } whole_map_iterate_end;
+
+  return planes;
+}
+
+/************************************************************************//**
+  Free the tile data.
+****************************************************************************/
+static void img_planes_destroy(struct img_planes *planes)
+{
+  if (planes != NULL) {
+    free(planes->known);
+    free(planes->terrain);
+    free(planes->owner);
+    free(planes->city);
+    free(planes->unit);
+    free(planes);
+  }
+}
+
+/************************************************************************//**
+  Return the knowledge of the tile.
+****************************************************************************/
+static inline enum known_type img_planes_known(const struct img_planes *planes,
+                                               const struct tile *ptile)
+{
+  return planes->known[tile_index(ptile)];
+}
+
+/************************************************************************//**
+  Return the index of the tile owner or -1.
+****************************************************************************/
+static inline int img_planes_owner(const struct img_planes *planes,
+                                   const struct tile *ptile)
+{
+  return planes->owner[tile_index(ptile)];
+}
+
 /*
  * ==============================================
  * topology (internal functions)
@@ -2531,8 +2946,7 @@ static void img_createmap(struct img *pimg)
   30 31 32 33 34 35
 ****************************************************************************/
 static bv_pixel pixel_tile_rect(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge)
+                                const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -2550,8 +2964,7 @@ static bv_pixel pixel_tile_rect(const struct tile *ptile,
   -- -- -- -- -- --
 ****************************************************************************/
 static bv_pixel pixel_city_rect(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge)
+                                const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -2586,8 +2999,7 @@ static bv_pixel pixel_city_rect(const struct tile *ptile,
   -- -- -- -- -- --
 ****************************************************************************/
 static bv_pixel pixel_unit_rect(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge)
+                                const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -2609,8 +3021,7 @@ static bv_pixel pixel_unit_rect(const struct tile *ptile,
   -- 31 -- 33 -- 35
 ****************************************************************************/
 static bv_pixel pixel_fogofwar_rect(const struct tile *ptile,
-                                    const struct player *pplayer,
-                                    bool knowledge)
+                                    const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -2651,12 +3062,11 @@ static bv_pixel pixel_fogofwar_rect(const struct tile *ptile,
              [S]
 ****************************************************************************/
 static bv_pixel pixel_border_rect(const struct tile *ptile,
-                                  const struct player *pplayer,
-                                  bool knowledge)
+                                  const struct img_planes *planes)
 {
   bv_pixel pixel;
   struct tile *pnext;
-  struct player *owner;
+  int owner;
 
   BV_CLR_ALL(pixel);
 
@@ -2667,17 +3077,15 @@ static bv_pixel pixel_border_rect(const struct tile *ptile,
     return pixel;
   }
 
-  owner = mapimg.mapimg_tile_owner(ptile, pplayer, knowledge);
-  if (NULL == owner) {
+  owner = img_planes_owner(planes, ptile);
+  if (owner == -1) {
     /* no border */
     return pixel;
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_NORTH);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 0);
     BV_SET(pixel, 1);
     BV_SET(pixel, 2);
@@ -2687,10 +3095,8 @@ static bv_pixel pixel_border_rect(const struct tile *ptile,
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_EAST);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 5);
     BV_SET(pixel, 11);
     BV_SET(pixel, 17);
@@ -2700,10 +3106,8 @@ static bv_pixel pixel_border_rect(const struct tile *ptile,
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_SOUTH);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 30);
     BV_SET(pixel, 31);
     BV_SET(pixel, 32);
@@ -2713,10 +3117,8 @@ static bv_pixel pixel_border_rect(const struct tile *ptile,
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_WEST);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 0);
     BV_SET(pixel, 6);
     BV_SET(pixel, 12);
@@ -2749,8 +3151,7 @@ static void base_coor_rect(struct img *pimg, int *base_x, int *base_y,
         34 35
 ****************************************************************************/
 static bv_pixel pixel_tile_hexa(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge)
+                                const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -2770,8 +3171,7 @@ static bv_pixel pixel_tile_hexa(const struct tile *ptile,
         -- --
 ****************************************************************************/
 static bv_pixel pixel_city_hexa(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge)
+                                const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -2811,8 +3211,7 @@ static bv_pixel pixel_city_hexa(const struct tile *ptile,
         -- --
 ****************************************************************************/
 static bv_pixel pixel_unit_hexa(const struct tile *ptile,
-                                const struct player *pplayer,
-                                bool knowledge)
+                                const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -2836,8 +3235,7 @@ static bv_pixel pixel_unit_hexa(const struct tile *ptile,
         -- 35
 ****************************************************************************/
 static bv_pixel pixel_fogofwar_hexa(const struct tile *ptile,
-                                    const struct player *pplayer,
-                                    bool knowledge)
+                                    const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -2875,12 +3273,11 @@ static bv_pixel pixel_fogofwar_hexa(const struct tile *ptile,
    [S]       34 35       [E]
 ****************************************************************************/
 static bv_pixel pixel_border_hexa(const struct tile *ptile,
-                                  const struct player *pplayer,
-                                  bool knowledge)
+                                  const struct img_planes *planes)
 {
   bv_pixel pixel;
   struct tile *pnext;
-  struct player *owner;
+  int owner;
 
   BV_CLR_ALL(pixel);
 
@@ -2891,17 +3288,15 @@ static bv_pixel pixel_border_hexa(const struct tile *ptile,
     return pixel;
   }
 
-  owner = mapimg.mapimg_tile_owner(ptile, pplayer, knowledge);
-  if (NULL == owner) {
+  owner = img_planes_owner(planes, ptile);
+  if (owner == -1) {
     /* no border */
     return pixel;
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_WEST);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 0);
     BV_SET(pixel, 2);
     BV_SET(pixel, 6);
@@ -2910,20 +3305,16 @@ static bv_pixel pixel_border_hexa(const struct tile *ptile,
   /* not used: DIR8_NORTHWEST */
 
   pnext = mapstep(&(wld.map), ptile, DIR8_NORTH);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 1);
     BV_SET(pixel, 5);
     BV_SET(pixel, 11);
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_NORTHEAST);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 11);
     BV_SET(pixel, 17);
     BV_SET(pixel, 23);
@@ -2931,10 +3322,8 @@ static bv_pixel pixel_border_hexa(const struct tile *ptile,
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_EAST);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 29);
     BV_SET(pixel, 33);
     BV_SET(pixel, 35);
@@ -2943,20 +3332,16 @@ static bv_pixel pixel_border_hexa(const struct tile *ptile,
   /* not used. DIR8_SOUTHEAST */
 
   pnext = mapstep(&(wld.map), ptile, DIR8_SOUTH);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 24);
     BV_SET(pixel, 30);
     BV_SET(pixel, 34);
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_SOUTHWEST);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 6);
     BV_SET(pixel, 12);
     BV_SET(pixel, 18);
@@ -2988,8 +3373,7 @@ static void base_coor_hexa(struct img *pimg, int *base_x, int *base_y,
         32 33 34 35
 ****************************************************************************/
 static bv_pixel pixel_tile_isohexa(const struct tile *ptile,
-                                   const struct player *pplayer,
-                                   bool knowledge)
+                                   const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -3007,8 +3391,7 @@ static bv_pixel pixel_tile_isohexa(const struct tile *ptile,
         -- -- -- --
 ****************************************************************************/
 static bv_pixel pixel_city_isohexa(const struct tile *ptile,
-                                   const struct player *pplayer,
-                                   bool knowledge)
+                                   const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -3046,8 +3429,7 @@ static bv_pixel pixel_city_isohexa(const struct tile *ptile,
         -- -- -- --
 ****************************************************************************/
 static bv_pixel pixel_unit_isohexa(const struct tile *ptile,
-                                   const struct player *pplayer,
-                                   bool knowledge)
+                                   const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -3069,8 +3451,7 @@ static bv_pixel pixel_unit_isohexa(const struct tile *ptile,
         -- -- 34 35
 ****************************************************************************/
 static bv_pixel pixel_fogofwar_isohexa(const struct tile *ptile,
-                                       const struct player *pplayer,
-                                       bool knowledge)
+                                       const struct img_planes *planes)
 {
   bv_pixel pixel;
 
@@ -3111,12 +3492,11 @@ static bv_pixel pixel_fogofwar_isohexa(const struct tile *ptile,
                [S]
 ****************************************************************************/
 static bv_pixel pixel_border_isohexa(const struct tile *ptile,
-                                     const struct player *pplayer,
-                                     bool knowledge)
+                                     const struct img_planes *planes)
 {
   bv_pixel pixel;
   struct tile *pnext;
-  struct player *owner;
+  int owner;
 
   BV_CLR_ALL(pixel);
 
@@ -3127,17 +3507,15 @@ static bv_pixel pixel_border_isohexa(const struct tile *ptile,
     return pixel;
   }
 
-  owner = mapimg.mapimg_tile_owner(ptile, pplayer, knowledge);
-  if (NULL == owner) {
+  owner = img_planes_owner(planes, ptile);
+  if (owner == -1) {
     /* no border */
     return pixel;
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_NORTH);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 0);
     BV_SET(pixel, 1);
     BV_SET(pixel, 2);
@@ -3147,30 +3525,24 @@ static bv_pixel pixel_border_isohexa(const struct tile *ptile,
   /* not used: DIR8_NORTHEAST */
 
   pnext = mapstep(&(wld.map), ptile, DIR8_EAST);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 3);
     BV_SET(pixel, 9);
     BV_SET(pixel, 17);
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_SOUTHEAST);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 25);
     BV_SET(pixel, 31);
     BV_SET(pixel, 35);
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_SOUTH);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 32);
     BV_SET(pixel, 33);
     BV_SET(pixel, 34);
@@ -3180,20 +3552,16 @@ static bv_pixel pixel_border_isohexa(const struct tile *ptile,
   /* not used: DIR8_SOUTHWEST */
 
   pnext = mapstep(&(wld.map), ptile, DIR8_WEST);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 18);
     BV_SET(pixel, 26);
     BV_SET(pixel, 32);
   }
 
   pnext = mapstep(&(wld.map), ptile, DIR8_NORTHWEST);
-  if (!pnext || (mapimg.mapimg_tile_known(pnext, pplayer,
-                                          knowledge) != TILE_UNKNOWN
-                 && mapimg.mapimg_tile_owner(pnext, pplayer,
-                                             knowledge) != owner)) {
+  if (!pnext || (img_planes_known(planes, pnext) != TILE_UNKNOWN
+                 && img_planes_owner(planes, pnext) != owner)) {
     BV_SET(pixel, 0);
     BV_SET(pixel, 4);
     BV_SET(pixel, 10);
@@ -20,7 +20,7 @@
     mapimg_reset()      Reset the map images.
     mapimg_free()       Free all memory needed for map images.
     mapimg_count()      Return the number of map image definitions.
-    mapimg_error()      Return the last error message.
+    mapimg_error()      Copy the last error message to a buffer.
     mapimg_help()       Return a help text.
 
   * Advanced functions:
@@ -31,6 +31,9 @@
     mapimg_id2str()     Convert the map image definition to a string. Usefull
                         to save the definitions.
     mapimg_create()     ...
+    mapimg_create_all() Create the images of all map definitions for the
+                        current turn, optionally in background threads.
+    mapimg_wait()       Wait for the images created in the background.
     mapimg_colortest()  ...
 
     These functions return TRUE on success and FALSE on error. In the later
@@ -63,6 +66,7 @@ extern "C" {
 #include "tile.h"
 
 #define MAX_LEN_MAPDEF 256
+#define MAX_LEN_MAPIMG_ERROR 1024
 
 /* map image layers */
 #define SPECENUM_NAME mapimg_layer
@@ -117,7 +121,7 @@ void mapimg_reset(void);
 void mapimg_free(void);
 int mapimg_count(void);
 char *mapimg_help(const char *cmdname);
-const char *mapimg_error(void);
+const char *mapimg_error(char *buf, size_t bufsz);
 
 bool mapimg_define(const char *maparg, bool check);
 bool mapimg_delete(int id);
@@ -125,6 +129,8 @@ bool mapimg_show(int id, char *str, size_t str_len, bool detail);
 bool mapimg_id2str(int id, char *str, size_t str_len);
 bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
                    const char *path);
+void mapimg_create_all(int threads, const char *savename, const char *path);
+void mapimg_wait(void);
 bool mapimg_colortest(const char *savename, const char *path);
 
 struct mapdef *mapimg_isvalid(int id);
@@ -104,20 +104,85 @@ void connection_close(struct connection *pconn, const char *reason)
 static bool buffer_ensure_free_extra_space(struct socket_packet_buffer *buf,
                                            int extra_space)
 {
+  int needed = buf->ndata + extra_space;
+  int start = buf->data - buf->base;
+  unsigned char *base;
+
   /* room for more? */
-  if (buf->nsize - buf->ndata < extra_space) {
-    buf->nsize = buf->ndata + extra_space;
+  if (buf->nsize - start - buf->ndata >= extra_space) {
+    return TRUE;
+  }
 
-    /* added this check so we don't gobble up too much mem */
-    if (buf->nsize > MAX_LEN_BUFFER) {
-      return FALSE;
-    }
-    buf->data = (unsigned char *) fc_realloc(buf->data, buf->nsize);
+  /* added this check so we don't gobble up too much mem */
+  if (needed > MAX_LEN_BUFFER) {
+    return FALSE;
   }
 
+  if (needed <= buf->nsize
+      && (start >= buf->ndata || buf->nsize >= MAX_LEN_BUFFER)) {
+    /* Moving the pending data to the front costs less than the data
+     * consumed since it was last moved, so draining a big buffer stays
+     * linear. */
+    memmove(buf->base, buf->data, buf->ndata);
+    buf->data = buf->base;
+
+    return TRUE;
+  }
+
+  /* Grow geometrically, copying only the pending data. */
+  buf->nsize = MIN(MAX(needed, 2 * buf->nsize), MAX_LEN_BUFFER);
+  base = fc_malloc(buf->nsize);
+  memcpy(base, buf->data, buf->ndata);
+  free(buf->base);
+  buf->base = base;
+  buf->data = base;
+
   return TRUE;
 }
 
+/**********************************************************************//**
+  Remove len bytes from the front of the pending data of the buffer.
+**************************************************************************/
+void socket_packet_buffer_consume(struct socket_packet_buffer *buf, int len)
+{
+  fc_assert_ret(len >= 0 && len <= buf->ndata);
+
+  buf->ndata -= len;
+  if (0 == buf->ndata) {
+    buf->data = buf->base;
+  } else {
+    buf->data += len;
+  }
+}
+
+/**********************************************************************//**
+  Insert len bytes from src before the pending data of the buffer.
+**************************************************************************/
+void socket_packet_buffer_prepend(struct socket_packet_buffer *buf,
+                                  const void *src, int len)
+{
+  if (buf->data - buf->base < len) {
+    /* Not enough room in front; make room at the end and shift. */
+    int nsize = buf->ndata + len;
+
+    if (buf->nsize < nsize) {
+      unsigned char *base = fc_malloc(nsize);
+
+      memcpy(base + len, buf->data, buf->ndata);
+      free(buf->base);
+      buf->base = base;
+      buf->nsize = nsize;
+    } else {
+      memmove(buf->base + len, buf->data, buf->ndata);
+    }
+    buf->data = buf->base + len;
+  }
+
+  buf->data -= len;
+  buf->ndata += len;
+  memcpy(buf->data, src, len);
+}
+
 /**********************************************************************//**
   Read data from socket, and check if a packet is ready.
   Returns:
@@ -128,16 +193,17 @@ static bool buffer_ensure_free_extra_space(struct socket_packet_buffer *buf,
 **************************************************************************/
 int read_socket_data(int sock, struct socket_packet_buffer *buffer)
 {
-  int didget;
+  int didget, nfree;
 
   if (!buffer_ensure_free_extra_space(buffer, MAX_LEN_PACKET)) {
     log_error("can't grow buffer");
     return -1;
   }
 
-  log_debug("try reading %d bytes", buffer->nsize - buffer->ndata);
+  nfree = buffer->nsize - (buffer->data - buffer->base) - buffer->ndata;
+  log_debug("try reading %d bytes", nfree);
   didget = fc_readsocket(sock, (char *) (buffer->data + buffer->ndata),
-                         buffer->nsize - buffer->ndata);
+                         nfree);
 
   if (didget > 0) {
     buffer->ndata += didget;
@@ -214,8 +280,7 @@ static int write_socket_data(struct connection *pc,
   }
 
   if (start > 0) {
-    buf->ndata -= start;
-    memmove(buf->data, buf->data+start, buf->ndata);
+    socket_packet_buffer_consume(buf, start);
     pc->last_write = timer_renew(pc->last_write, TIMER_USER, TIMER_ACTIVE);
     timer_start(pc->last_write);
   }
@@ -443,7 +508,8 @@ struct socket_packet_buffer *new_socket_packet_buffer(void)
   buf->ndata = 0;
   buf->do_buffer_sends = 0;
   buf->nsize = 10*MAX_LEN_PACKET;
-  buf->data = (unsigned char *)fc_malloc(buf->nsize);
+  buf->base = (unsigned char *)fc_malloc(buf->nsize);
+  buf->data = buf->base;
 
   return buf;
 }
@@ -454,8 +520,8 @@ struct socket_packet_buffer *new_socket_packet_buffer(void)
 static void free_socket_packet_buffer(struct socket_packet_buffer *buf)
 {
   if (buf) {
-    if (buf->data) {
-      free(buf->data);
+    if (buf->base) {
+      free(buf->base);
     }
     free(buf);
   }
@@ -550,6 +616,30 @@ void free_compression_queue(struct connection *pc)
 #endif /* USE_COMPRESSION */
 }
 
+/* A packet kept in one of the 'sent' delta hashes of a connection. The
+ * packet itself is stored right after this header. */
+struct delta_entry {
+  struct delta_entry *prev;
+  struct delta_entry *next;
+  struct delta_cache *cache;
+  struct genhash *hash;         /* The hash the packet is stored in. */
+  size_t size;
+  enum packet_type type;
+};
+
+struct delta_cache {
+  struct delta_entry lru;       /* Sentinel; 'next' is the most recent. */
+  size_t bytes;
+  size_t limit;                 /* 0 means no limit. */
+  int entries;
+  int evictions;
+  /* Some packets of this type were evicted: the other end may still hold
+   * them, so new ones must be sent with all their fields. */
+  bool resend[PACKET_LAST];
+};
+
+#define DELTA_ENTRY(_packet) (((struct delta_entry *) (_packet)) - 1)
+
 /**********************************************************************//**
   Allocate and initialize packet hashs for given connection.
 **************************************************************************/
@@ -560,6 +650,9 @@ static void init_packet_hashs(struct connection *pc)
   pc->phs.sent = fc_malloc(sizeof(*pc->phs.sent) * PACKET_LAST);
   pc->phs.received = fc_malloc(sizeof(*pc->phs.received) * PACKET_LAST);
   pc->phs.handlers = packet_handlers_initial();
+  pc->phs.cache = fc_calloc(1, sizeof(*pc->phs.cache));
+  pc->phs.cache->lru.next = &pc->phs.cache->lru;
+  pc->phs.cache->lru.prev = &pc->phs.cache->lru;
 
   for (i = 0; i < PACKET_LAST; i++) {
     pc->phs.sent[i] = NULL;
@@ -584,6 +677,12 @@ static void free_packet_hashes(struct connection *pc)
     pc->phs.sent = NULL;
   }
 
+  if (pc->phs.cache) {
+    /* All entries were unlinked when the 'sent' hashes were destroyed. */
+    fc_assert(0 == pc->phs.cache->entries);
+    FC_FREE(pc->phs.cache);
+  }
+
   if (pc->phs.received) {
     for (i = 0; i < PACKET_LAST; i++) {
       if (pc->phs.received[i] != NULL) {
@@ -679,10 +778,150 @@ void conn_reset_delta_state(struct connection *pc)
       if (NULL != pc->phs.received && NULL != pc->phs.received[i]) {
         genhash_clear(pc->phs.received[i]);
       }
+      if (NULL != pc->phs.cache) {
+        /* Both ends forgot these packets. */
+        pc->phs.cache->resend[i] = FALSE;
+      }
     }
   }
 }
 
+/**********************************************************************//**
+  Evict the least recently used 'sent' packets of the connection until
+  the cache fits in its limit, leaving room for 'room' more bytes. The
+  other end still knows the evicted packets, so the next packets of the
+  same types are sent in full.
+**************************************************************************/
+static void delta_cache_shrink(struct delta_cache *cache, size_t room)
+{
+  if (0 == cache->limit) {
+    return;
+  }
+
+  while (cache->lru.prev != &cache->lru
+         && cache->bytes + room > cache->limit) {
+    struct delta_entry *entry = cache->lru.prev;
+
+    cache->resend[entry->type] = TRUE;
+    cache->evictions++;
+    /* Calls delta_cache_entry_free(). */
+    genhash_remove(entry->hash, entry + 1);
+  }
+}
+
+/**********************************************************************//**
+  Allocate a packet of 'size' bytes that is about to be inserted in the
+  'sent' delta hash 'hash' of the connection. The hash must free it with
+  delta_cache_entry_free(). Older packets are evicted if the connection
+  is over its delta cache limit.
+**************************************************************************/
+void *delta_cache_entry_new(struct connection *pc, int packet_type,
+                            struct genhash *hash, size_t size)
+{
+  struct delta_cache *cache = pc->phs.cache;
+  struct delta_entry *entry;
+
+  delta_cache_shrink(cache, sizeof(*entry) + size);
+
+  entry = fc_malloc(sizeof(*entry) + size);
+  entry->cache = cache;
+  entry->hash = hash;
+  entry->size = sizeof(*entry) + size;
+  entry->type = packet_type;
+
+  entry->prev = &cache->lru;
+  entry->next = cache->lru.next;
+  entry->next->prev = entry;
+  cache->lru.next = entry;
+
+  cache->bytes += entry->size;
+  cache->entries++;
+
+  return entry + 1;
+}
+
+/**********************************************************************//**
+  Free a packet allocated with delta_cache_entry_new().
+**************************************************************************/
+void delta_cache_entry_free(void *packet)
+{
+  struct delta_entry *entry = DELTA_ENTRY(packet);
+
+  entry->prev->next = entry->next;
+  entry->next->prev = entry->prev;
+  entry->cache->bytes -= entry->size;
+  entry->cache->entries--;
+  free(entry);
+}
+
+/**********************************************************************//**
+  Mark a packet allocated with delta_cache_entry_new() as the most
+  recently used one.
+**************************************************************************/
+void delta_cache_entry_touch(void *packet)
+{
+  struct delta_entry *entry = DELTA_ENTRY(packet);
+  struct delta_entry *head = &entry->cache->lru;
+
+  if (head->next == entry) {
+    return;
+  }
+
+  entry->prev->next = entry->next;
+  entry->next->prev = entry->prev;
+  entry->prev = head;
+  entry->next = head->next;
+  entry->next->prev = entry;
+  head->next = entry;
+}
+
+/**********************************************************************//**
+  Returns TRUE if new packets of this type must be sent with all their
+  fields, because an older one was evicted from the delta cache.
+**************************************************************************/
+bool delta_cache_resend(const struct connection *pc, int packet_type)
+{
+  return pc->phs.cache->resend[packet_type];
+}
+
+/**********************************************************************//**
+  Set the maximum number of bytes the 'sent' delta packets of the
+  connection may use. 0 means no limit.
+**************************************************************************/
+void conn_delta_cache_set_limit(struct connection *pc, size_t limit)
+{
+  if (NULL != pc->phs.cache) {
+    pc->phs.cache->limit = limit;
+    delta_cache_shrink(pc->phs.cache, 0);
+  }
+}
+
+/**********************************************************************//**
+  Returns the number of bytes used by the 'sent' delta packets of the
+  connection.
+**************************************************************************/
+size_t conn_delta_cache_bytes(const struct connection *pc)
+{
+  return NULL != pc->phs.cache ? pc->phs.cache->bytes : 0;
+}
+
+/**********************************************************************//**
+  Returns the number of 'sent' delta packets kept for the connection.
+**************************************************************************/
+int conn_delta_cache_entries(const struct connection *pc)
+{
+  return NULL != pc->phs.cache ? pc->phs.cache->entries : 0;
+}
+
+/**********************************************************************//**
+  Returns the number of packets evicted from the delta cache of the
+  connection.
+**************************************************************************/
+int conn_delta_cache_evictions(const struct connection *pc)
+{
+  return NULL != pc->phs.cache ? pc->phs.cache->evictions : 0;
+}
+
 /**********************************************************************//**
   Freeze the connection. Then the packets sent to it won't be sent
   immediatly, but later, using a compression method. See futher details in
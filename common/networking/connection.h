@@ -48,10 +48,39 @@ extern "C" {
 #include "fc_types.h"
 
 struct conn_pattern_list;
+struct delta_cache;
 struct genhash;
 struct packet_handlers;
 struct timer_list;
 
+#ifdef FREECIV_JSON_CONNECTION
+#define JSON_IN_MAX_FIELDS 128
+#define JSON_IN_MAX_DEPTH 8
+
+/* A JSON packet being received. It is read in place from the text; see
+ * dataio_json.c */
+struct json_data_in {
+  const char *text;
+  int len;
+  const char *error;            /* Why the text could not be parsed. */
+  int root;                     /* Offset of the top level value. */
+
+  /* Top level fields. nfields is -1 if there are too many of them. */
+  int nfields;
+  struct {
+    int key;                    /* Offset of the key, after the quote. */
+    int value;                  /* Offset of the value. */
+  } fields[JSON_IN_MAX_FIELDS];
+
+  /* Last array element looked up at each depth. */
+  struct {
+    int array;                  /* Offset of the array, -1 if none. */
+    int number;
+    int elem;                   /* Offset of the element. */
+  } cursor[JSON_IN_MAX_DEPTH];
+};
+#endif /* FREECIV_JSON_CONNECTION */
+
 /* Used in the network protocol. */
 #define MAX_LEN_PACKET   4096
 #define MAX_LEN_CAPSTR    512
@@ -117,12 +146,17 @@ struct connection;
 /***********************************************************
   This is a buffer where the data is first collected,
   whenever it arrives to the client/server.
+  The pending data starts at 'data', somewhere within the 'nsize'
+  bytes allocated at 'base'. Consuming data from the front only
+  advances 'data'; the pending bytes are moved back to 'base'
+  when more room is needed at the end.
 ***********************************************************/
 struct socket_packet_buffer {
   int ndata;
   int do_buffer_sends;
   int nsize;
   unsigned char *data;
+  unsigned char *base;
 };
 
 struct packet_header {
@@ -160,7 +194,7 @@ struct connection {
   struct timer *last_write;
 #ifdef FREECIV_JSON_CONNECTION
   bool json_mode;
-  json_t *json_packet;
+  struct json_data_in json_packet;
 #endif /* FREECIV_JSON_CONNECTION */
 
   double ping_time;
@@ -235,6 +269,10 @@ struct connection {
        * but the closing has been postponed. */
       bool is_closing;
 
+      /* Index of the next tile of the initial map sent to the connection,
+       * or -1 when the whole map has been sent. */
+      int map_sync;
+
       /* If we use delegation the original player (playing) is replaced. Save
        * it here to easily restore it. */
       struct {
@@ -265,6 +303,8 @@ struct connection {
     struct genhash **sent;
     struct genhash **received;
     const struct packet_handlers *handlers;
+    /* Memory accounting and LRU order of the 'sent' entries. */
+    struct delta_cache *cache;
   } phs;
 
 #ifdef USE_COMPRESSION
@@ -301,12 +341,27 @@ struct connection *conn_by_user_prefix(const char *user_name,
 struct connection *conn_by_number(int id);
 
 struct socket_packet_buffer *new_socket_packet_buffer(void);
+void socket_packet_buffer_consume(struct socket_packet_buffer *buf,
+                                  int len);
+void socket_packet_buffer_prepend(struct socket_packet_buffer *buf,
+                                  const void *src, int len);
 void connection_common_init(struct connection *pconn);
 void connection_common_close(struct connection *pconn);
 void conn_set_capability(struct connection *pconn, const char *capability);
 void free_compression_queue(struct connection *pconn);
 void conn_reset_delta_state(struct connection *pconn);
 
+void *delta_cache_entry_new(struct connection *pconn, int packet_type,
+                            struct genhash *hash, size_t size);
+void delta_cache_entry_free(void *packet);
+void delta_cache_entry_touch(void *packet);
+bool delta_cache_resend(const struct connection *pconn, int packet_type);
+
+void conn_delta_cache_set_limit(struct connection *pconn, size_t limit);
+size_t conn_delta_cache_bytes(const struct connection *pconn);
+int conn_delta_cache_entries(const struct connection *pconn);
+int conn_delta_cache_evictions(const struct connection *pconn);
+
 void conn_compression_freeze(struct connection *pconn);
 bool conn_compression_thaw(struct connection *pconn);
 bool conn_compression_frozen(const struct connection *pconn);
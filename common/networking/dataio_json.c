@@ -21,7 +21,9 @@
 
 #include <curl/curl.h>
 
+#include <errno.h>
 #include <limits.h>
+#include <locale.h>
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -60,128 +62,1453 @@
 
 #include "dataio.h"
 
-static bool dio_get_bool8_json_internal(json_t *json_packet,
+static bool dio_get_bool8_json_internal(struct json_data_in *din, int from,
                                         const struct plocation *location,
                                         bool *dest);
 
+/* What can be written to a location of a JSON packet. */
+enum json_out_kind {
+  JSON_OUT_INTEGER,
+  JSON_OUT_REAL,
+  JSON_OUT_BOOLEAN,
+  JSON_OUT_STRING,
+  JSON_OUT_ARRAY,               /* Of size nulls. */
+  JSON_OUT_OBJECT               /* Empty. */
+};
+
+struct json_out_value {
+  enum json_out_kind kind;
+  union {
+    json_int_t integer;
+    double real;
+    bool boolean;
+    const char *string;
+    int size;
+  };
+};
+
+/* Full address of a location inside a JSON packet. */
+struct json_out_path {
+  int n;
+  struct json_out_step step[JSON_OUT_MAX_DEPTH];
+};
+
+/* Limit of jansson's parser. */
+#define JSON_IN_PARSER_MAX_DEPTH 2048
+
+/**********************************************************************//**
+  Returns a CURL easy handle for name encoding and decoding
+**************************************************************************/
+static CURL *get_curl(void)
+{
+  static CURL *curl_easy_handle = NULL;
+
+  if (curl_easy_handle == NULL) {
+    curl_easy_handle = curl_easy_init();
+  } else {
+    /* Reuse the existing CURL easy handle */
+    curl_easy_reset(curl_easy_handle);
+  }
+
+  return curl_easy_handle;
+}
+
+/**********************************************************************//**
+  Decode the UTF-8 sequence at s, the way jansson does. Returns its
+  length, or 0 if it is not valid.
+**************************************************************************/
+static int utf8_decode(const unsigned char *s, int avail, int *codepoint)
+{
+  int size, i, value;
+
+  if (s[0] < 0x80) {
+    *codepoint = s[0];
+    return 1;
+  } else if (s[0] < 0xC2) {
+    /* Continuation byte, or overlong 2 byte sequence. */
+    return 0;
+  } else if (s[0] < 0xE0) {
+    size = 2;
+    value = s[0] & 0x1F;
+  } else if (s[0] < 0xF0) {
+    size = 3;
+    value = s[0] & 0x0F;
+  } else if (s[0] < 0xF5) {
+    size = 4;
+    value = s[0] & 0x07;
+  } else {
+    return 0;
+  }
+
+  if (size > avail) {
+    return 0;
+  }
+  for (i = 1; i < size; i++) {
+    if (s[i] < 0x80 || s[i] > 0xBF) {
+      return 0;
+    }
+    value = (value << 6) + (s[i] & 0x3F);
+  }
+
+  if (value > 0x10FFFF
+      || (value >= 0xD800 && value <= 0xDFFF)
+      || (size == 3 && value < 0x800)
+      || (size == 4 && value < 0x10000)) {
+    return 0;
+  }
+
+  *codepoint = value;
+  return size;
+}
+
+/**********************************************************************//**
+  Encode codepoint as UTF-8 to out. Returns the length.
+**************************************************************************/
+static int utf8_encode(int codepoint, char *out)
+{
+  if (codepoint < 0x80) {
+    out[0] = codepoint;
+    return 1;
+  } else if (codepoint < 0x800) {
+    out[0] = 0xC0 + (codepoint >> 6);
+    out[1] = 0x80 + (codepoint & 0x3F);
+    return 2;
+  } else if (codepoint < 0x10000) {
+    out[0] = 0xE0 + (codepoint >> 12);
+    out[1] = 0x80 + ((codepoint >> 6) & 0x3F);
+    out[2] = 0x80 + (codepoint & 0x3F);
+    return 3;
+  } else {
+    out[0] = 0xF0 + (codepoint >> 18);
+    out[1] = 0x80 + ((codepoint >> 12) & 0x3F);
+    out[2] = 0x80 + ((codepoint >> 6) & 0x3F);
+    out[3] = 0x80 + (codepoint & 0x3F);
+    return 4;
+  }
+}
+
+/**********************************************************************//**
+  Whether jansson would accept str as a string value.
+**************************************************************************/
+static bool json_out_string_valid(const char *str)
+{
+  const unsigned char *s = (const unsigned char *) str;
+  int avail = strlen(str);
+
+  while (avail > 0) {
+    int codepoint;
+    int size = utf8_decode(s, avail, &codepoint);
+
+    if (size == 0) {
+      return FALSE;
+    }
+    s += size;
+    avail -= size;
+  }
+
+  return TRUE;
+}
+
+/**********************************************************************//**
+  Append len bytes of JSON text.
+**************************************************************************/
+static inline void json_out_text(struct json_data_out *dout,
+                                 const char *text, size_t len)
+{
+  dio_put_memory_raw(&dout->raw, text, len);
+}
+
+/**********************************************************************//**
+  Append an integer the way json_dumps() prints it.
+**************************************************************************/
+static void json_out_integer_text(struct json_data_out *dout,
+                                  json_int_t value)
+{
+  char buf[32];
+  char *p = buf + sizeof(buf);
+  unsigned long long magnitude;
+
+  magnitude = value < 0 ? -(unsigned long long) value : value;
+  do {
+    *--p = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0);
+  if (value < 0) {
+    *--p = '-';
+  }
+
+  json_out_text(dout, p, buf + sizeof(buf) - p);
+}
+
+/**********************************************************************//**
+  Append a real the way json_dumps() prints it: 17 significant digits,
+  always a '.' or an exponent, no '+' or leading zeros in the exponent.
+**************************************************************************/
+static void json_out_real_text(struct json_data_out *dout, double value)
+{
+  char buf[64];
+  const char *point = localeconv()->decimal_point;
+  char *exp;
+  int len;
+
+  len = fc_snprintf(buf, sizeof(buf) - 2, "%.17g", value);
+
+  if (*point != '.') {
+    char *pos = strchr(buf, *point);
+
+    if (pos != NULL) {
+      *pos = '.';
+    }
+  }
+
+  if (strchr(buf, '.') == NULL && strchr(buf, 'e') == NULL) {
+    buf[len++] = '.';
+    buf[len++] = '0';
+    buf[len] = '\0';
+  }
+
+  exp = strchr(buf, 'e');
+  if (exp != NULL) {
+    char *start = exp + 1;
+    char *end = start + 1;
+
+    if (*start == '-') {
+      start++;
+    }
+    while (*end == '0') {
+      end++;
+    }
+    if (end != start) {
+      memmove(start, end, len - (end - buf) + 1);
+      len -= end - start;
+    }
+  }
+
+  json_out_text(dout, buf, len);
+}
+
+/**********************************************************************//**
+  Append a quoted string the way json_dumps() prints it with
+  JSON_ENSURE_ASCII. The string must be valid UTF-8.
+**************************************************************************/
+static void json_out_string_text(struct json_data_out *dout,
+                                 const char *str)
+{
+  const unsigned char *s = (const unsigned char *) str;
+  const unsigned char *plain = s;
+  int avail = strlen(str);
+
+  json_out_text(dout, "\"", 1);
+
+  while (avail > 0) {
+    char seq[13];
+    const char *text;
+    int codepoint;
+    int size = utf8_decode(s, avail, &codepoint);
+
+    if (codepoint != '\\' && codepoint != '"' && codepoint >= 0x20
+        && codepoint <= 0x7F) {
+      s += size;
+      avail -= size;
+      continue;
+    }
+
+    json_out_text(dout, (const char *) plain, s - plain);
+
+    switch (codepoint) {
+    case '\\':
+      text = "\\\\";
+      break;
+    case '"':
+      text = "\\\"";
+      break;
+    case '\b':
+      text = "\\b";
+      break;
+    case '\f':
+      text = "\\f";
+      break;
+    case '\n':
+      text = "\\n";
+      break;
+    case '\r':
+      text = "\\r";
+      break;
+    case '\t':
+      text = "\\t";
+      break;
+    default:
+      if (codepoint < 0x10000) {
+        fc_snprintf(seq, sizeof(seq), "\\u%04X", (unsigned) codepoint);
+      } else {
+        int first, last;
+
+        codepoint -= 0x10000;
+        first = 0xD800 | ((codepoint & 0xFFC00) >> 10);
+        last = 0xDC00 | (codepoint & 0x003FF);
+        fc_snprintf(seq, sizeof(seq), "\\u%04X\\u%04X",
+                    (unsigned) first, (unsigned) last);
+      }
+      text = seq;
+      break;
+    }
+    json_out_text(dout, text, strlen(text));
+
+    s += size;
+    avail -= size;
+    plain = s;
+  }
+
+  json_out_text(dout, (const char *) plain, s - plain);
+  json_out_text(dout, "\"", 1);
+}
+
+/**********************************************************************//**
+  Get the address of location. n is -1 if it is too deep.
+**************************************************************************/
+static void json_out_path_init(struct json_out_path *path,
+                               const struct plocation *location)
+{
+  path->n = 0;
+
+  for (; location != NULL; location = location->sub_location) {
+    if (path->n >= JSON_OUT_MAX_DEPTH) {
+      path->n = -1;
+      return;
+    }
+    path->step[path->n].elem = (location->kind == PADR_ELEMENT);
+    if (location->kind == PADR_ELEMENT) {
+      path->step[path->n].number = location->number;
+    } else {
+      path->step[path->n].name = location->name;
+    }
+    path->n++;
+  }
+}
+
+/**********************************************************************//**
+  Extend the address with a field.
+**************************************************************************/
+static void json_out_path_field(struct json_out_path *path,
+                                const char *name)
+{
+  if (path->n >= 0 && path->n < JSON_OUT_MAX_DEPTH) {
+    path->step[path->n].elem = FALSE;
+    path->step[path->n].name = name;
+    path->n++;
+  } else {
+    path->n = -1;
+  }
+}
+
+/**********************************************************************//**
+  Extend the address with an array element.
+**************************************************************************/
+static void json_out_path_elem(struct json_out_path *path, int number)
+{
+  if (path->n >= 0 && path->n < JSON_OUT_MAX_DEPTH) {
+    path->step[path->n].elem = TRUE;
+    path->step[path->n].number = number;
+    path->n++;
+  } else {
+    path->n = -1;
+  }
+}
+
+/**********************************************************************//**
+  Whether two steps address the same location.
+**************************************************************************/
+static inline bool json_out_step_equal(const struct json_out_step *a,
+                                       const struct json_out_step *b)
+{
+  if (a->elem != b->elem) {
+    return FALSE;
+  }
+  if (a->elem) {
+    return a->number == b->number;
+  }
+  return a->name == b->name || 0 == strcmp(a->name, b->name);
+}
+
+/**********************************************************************//**
+  Whether the open object at the given level already has key.
+**************************************************************************/
+static bool json_out_has_key(const struct json_data_out *dout, int level,
+                             const char *key)
+{
+  int end = (level + 1 < dout->depth
+             ? dout->level[level + 1].first_key : dout->nkeys);
+  int i;
+
+  for (i = dout->level[level].first_key; i < end; i++) {
+    if (dout->keys[i] == key || 0 == strcmp(dout->keys[i], key)) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**********************************************************************//**
+  Close the text of the open containers until depth of them are left.
+  Array elements not written are null.
+**************************************************************************/
+static void json_out_close(struct json_data_out *dout, int depth)
+{
+  while (dout->depth > depth) {
+    struct json_out_level *level = &dout->level[dout->depth - 1];
+
+    if (level->array) {
+      for (; level->next < level->size; level->next++) {
+        if (level->next > 0) {
+          json_out_text(dout, ",null", 5);
+        } else {
+          json_out_text(dout, "null", 4);
+        }
+      }
+      json_out_text(dout, "]", 1);
+    } else {
+      json_out_text(dout, "}", 1);
+      dout->nkeys = level->first_key;
+    }
+    dout->depth--;
+  }
+}
+
+/**********************************************************************//**
+  Create the jansson value of value.
+**************************************************************************/
+static json_t *json_dom_value(const struct json_out_value *value)
+{
+  switch (value->kind) {
+  case JSON_OUT_INTEGER:
+    return json_integer(value->integer);
+  case JSON_OUT_REAL:
+    return json_real(value->real);
+  case JSON_OUT_BOOLEAN:
+    return json_boolean(value->boolean);
+  case JSON_OUT_STRING:
+    return json_string(value->string);
+  case JSON_OUT_ARRAY:
+    {
+      json_t *farray = json_array();
+      int i;
+
+      /* Jansson's json_array_set_new() refuses to create array elements
+       * so they must be created with the array. */
+      for (i = 0; i < value->size; i++) {
+        json_array_append_new(farray, json_null());
+      }
+
+      return farray;
+    }
+  case JSON_OUT_OBJECT:
+    return json_object();
+  }
+
+  return NULL;
+}
+
+/**********************************************************************//**
+  Write data to the location at path, starting from its step i inside
+  item. Like jansson does, locations that do not exist are ignored.
+**************************************************************************/
+static void json_dom_write(json_t *item, const struct json_out_path *path,
+                           int i, json_t *data)
+{
+  const struct json_out_step *step = &path->step[i];
+
+  if (i + 1 < path->n) {
+    json_dom_write(step->elem
+                   ? json_array_get(item, step->number)
+                   : json_object_get(item, step->name),
+                   path, i + 1, data);
+  } else if (step->elem) {
+    json_array_set_new(item, step->number, data);
+  } else {
+    json_object_set_new(item, step->name, data);
+  }
+}
+
+/**********************************************************************//**
+  Load the text written so far to the jansson DOM. The rest of the
+  packet is written there.
+**************************************************************************/
+static void json_out_to_dom(struct json_data_out *dout)
+{
+  json_error_t error;
+
+  json_out_close(dout, 0);
+  dout->dom = json_loadb((const char *) dout->raw.dest + dout->start,
+                         dout->raw.used - dout->start, 0, &error);
+  dout->raw.used = dout->start;
+  dout->raw.current = dout->start;
+
+  if (dout->dom == NULL) {
+    log_error("ERROR: Unable to reload packet: %s", error.text);
+    dout->dom = json_object();
+  }
+}
+
+/**********************************************************************//**
+  Write value to the location at path.
+
+  Locations after the ones written so far in document order are written
+  as text. The containers that cannot be written to any more are closed
+  on the way. Locations that do not exist are ignored, as jansson does.
+  Anything else moves the packet to the jansson DOM.
+**************************************************************************/
+static void json_out_write(struct json_data_out *dout,
+                           const struct json_out_path *path,
+                           const struct json_out_value *value)
+{
+  const struct json_out_step *step;
+  struct json_out_level *parent;
+  int m;
+
+  if (path->n <= 0) {
+    log_error("ERROR: Packet location too deep.");
+    return;
+  }
+
+  /* Values jansson refuses to create are not written. */
+  if ((value->kind == JSON_OUT_STRING
+       && (value->string == NULL || !json_out_string_valid(value->string)))
+      || (value->kind == JSON_OUT_REAL && !isfinite(value->real))) {
+    return;
+  }
+
+  if (dout->dom != NULL) {
+    json_dom_write(dout->dom, path, 0, json_dom_value(value));
+    return;
+  }
+
+  /* Find the innermost open container on the path. */
+  m = 0;
+  while (m + 1 < dout->depth && m + 1 < path->n
+         && json_out_step_equal(&dout->level[m + 1].step, &path->step[m])) {
+    m++;
+  }
+  parent = &dout->level[m];
+  step = &path->step[m];
+
+  if (step->elem != parent->array) {
+    return;
+  }
+  if (parent->array) {
+    if (step->number < 0 || step->number >= parent->size) {
+      return;
+    }
+    if (step->number < parent->next) {
+      /* Written already. */
+      json_out_to_dom(dout);
+      json_out_write(dout, path, value);
+      return;
+    }
+    if (m + 1 < path->n) {
+      /* Inside a null element. */
+      return;
+    }
+  } else {
+    if (json_out_has_key(dout, m, step->name)) {
+      json_out_to_dom(dout);
+      json_out_write(dout, path, value);
+      return;
+    }
+    if (m + 1 < path->n) {
+      /* Inside a missing field. */
+      return;
+    }
+  }
+
+  json_out_close(dout, m + 1);
+
+  if ((!parent->array && dout->nkeys >= JSON_OUT_MAX_KEYS)
+      || ((value->kind == JSON_OUT_ARRAY || value->kind == JSON_OUT_OBJECT)
+          && dout->depth >= JSON_OUT_MAX_DEPTH)) {
+    json_out_to_dom(dout);
+    json_out_write(dout, path, value);
+    return;
+  }
+
+  if (parent->array) {
+    for (; parent->next < step->number; parent->next++) {
+      if (parent->next > 0) {
+        json_out_text(dout, ",null", 5);
+      } else {
+        json_out_text(dout, "null", 4);
+      }
+    }
+    if (parent->next > 0) {
+      json_out_text(dout, ",", 1);
+    }
+    parent->next++;
+  } else {
+    if (dout->nkeys > parent->first_key) {
+      json_out_text(dout, ",", 1);
+    }
+    json_out_string_text(dout, step->name);
+    json_out_text(dout, ":", 1);
+    dout->keys[dout->nkeys++] = step->name;
+  }
+
+  switch (value->kind) {
+  case JSON_OUT_INTEGER:
+    json_out_integer_text(dout, value->integer);
+    break;
+  case JSON_OUT_REAL:
+    json_out_real_text(dout, value->real);
+    break;
+  case JSON_OUT_BOOLEAN:
+    if (value->boolean) {
+      json_out_text(dout, "true", 4);
+    } else {
+      json_out_text(dout, "false", 5);
+    }
+    break;
+  case JSON_OUT_STRING:
+    json_out_string_text(dout, value->string);
+    break;
+  case JSON_OUT_ARRAY:
+  case JSON_OUT_OBJECT:
+    {
+      struct json_out_level *level = &dout->level[dout->depth++];
+
+      level->step = *step;
+      level->array = (value->kind == JSON_OUT_ARRAY);
+      level->size = value->size;
+      level->next = 0;
+      level->first_key = dout->nkeys;
+      json_out_text(dout, level->array ? "[" : "{", 1);
+    }
+    break;
+  }
+}
+
+/**********************************************************************//**
+  Write an integer to location.
+**************************************************************************/
+static void json_out_integer(struct json_data_out *dout,
+                             const struct plocation *location,
+                             json_int_t integer)
+{
+  struct json_out_path path;
+  struct json_out_value value = { .kind = JSON_OUT_INTEGER,
+                                  .integer = integer };
+
+  json_out_path_init(&path, location);
+  json_out_write(dout, &path, &value);
+}
+
+/**********************************************************************//**
+  Write a real to location.
+**************************************************************************/
+static void json_out_real(struct json_data_out *dout,
+                          const struct plocation *location, double real)
+{
+  struct json_out_path path;
+  struct json_out_value value = { .kind = JSON_OUT_REAL, .real = real };
+
+  json_out_path_init(&path, location);
+  json_out_write(dout, &path, &value);
+}
+
+/**********************************************************************//**
+  Write a boolean to location.
+**************************************************************************/
+static void json_out_boolean(struct json_data_out *dout,
+                             const struct plocation *location,
+                             bool boolean)
+{
+  struct json_out_path path;
+  struct json_out_value value = { .kind = JSON_OUT_BOOLEAN,
+                                  .boolean = boolean };
+
+  json_out_path_init(&path, location);
+  json_out_write(dout, &path, &value);
+}
+
+/**********************************************************************//**
+  Write a string to location.
+**************************************************************************/
+static void json_out_string(struct json_data_out *dout,
+                            const struct plocation *location,
+                            const char *string)
+{
+  struct json_out_path path;
+  struct json_out_value value = { .kind = JSON_OUT_STRING,
+                                  .string = string };
+
+  json_out_path_init(&path, location);
+  json_out_write(dout, &path, &value);
+}
+
+/**********************************************************************//**
+  Write an integer to the field name of the object at path.
+**************************************************************************/
+static void json_out_member_integer(struct json_data_out *dout,
+                                    struct json_out_path *path,
+                                    const char *name, json_int_t integer)
+{
+  struct json_out_value value = { .kind = JSON_OUT_INTEGER,
+                                  .integer = integer };
+
+  json_out_path_field(path, name);
+  json_out_write(dout, path, &value);
+  path->n--;
+}
+
+/**********************************************************************//**
+  Write a boolean to the field name of the object at path.
+**************************************************************************/
+static void json_out_member_boolean(struct json_data_out *dout,
+                                    struct json_out_path *path,
+                                    const char *name, bool boolean)
+{
+  struct json_out_value value = { .kind = JSON_OUT_BOOLEAN,
+                                  .boolean = boolean };
+
+  json_out_path_field(path, name);
+  json_out_write(dout, path, &value);
+  path->n--;
+}
+
+/**********************************************************************//**
+  Start writing a packet as JSON after what is already in dout->raw.
+**************************************************************************/
+void dio_output_json_start(struct json_data_out *dout)
+{
+  dout->json = TRUE;
+  dout->dom = NULL;
+  dout->start = dout->raw.used;
+  dout->depth = 1;
+  dout->level[0].array = FALSE;
+  dout->level[0].first_key = 0;
+  dout->nkeys = 0;
+
+  json_out_text(dout, "{", 1);
+}
+
+/**********************************************************************//**
+  Finish the JSON text of the packet. It is terminated by a '\0', like
+  strings are.
+**************************************************************************/
+void dio_output_json_finish(struct json_data_out *dout)
+{
+  if (dout->dom != NULL) {
+    char *json_buffer = json_dumps(dout->dom,
+                                   JSON_COMPACT | JSON_ENSURE_ASCII);
+
+    if (json_buffer != NULL) {
+      dio_put_string_raw(&dout->raw, json_buffer);
+      free(json_buffer);
+    }
+    json_decref(dout->dom);
+    dout->dom = NULL;
+  } else {
+    json_out_close(dout, 0);
+    dio_put_uint8_raw(&dout->raw, 0);
+  }
+}
+
+/**********************************************************************//**
+  Record why the text could not be parsed.
+**************************************************************************/
+static bool json_in_error(struct json_data_in *din, const char *error)
+{
+  din->error = error;
+
+  return FALSE;
+}
+
+/**********************************************************************//**
+  Skip white space.
+**************************************************************************/
+static inline void json_in_space(const struct json_data_in *din, int *pos)
+{
+  while (*pos < din->len
+         && (din->text[*pos] == ' ' || din->text[*pos] == '\t'
+             || din->text[*pos] == '\n' || din->text[*pos] == '\r')) {
+    (*pos)++;
+  }
+}
+
+/**********************************************************************//**
+  Read the 4 hex digits at s. Returns -1 if they are not.
+**************************************************************************/
+static int json_in_hex4(const char *s)
+{
+  int value = 0;
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    int c = s[i];
+
+    value <<= 4;
+    if (c >= '0' && c <= '9') {
+      value += c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      value += c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      value += c - 'A' + 10;
+    } else {
+      return -1;
+    }
+  }
+
+  return value;
+}
+
+/**********************************************************************//**
+  Check the string starting at the quote at *pos, and move past it.
+**************************************************************************/
+static bool json_in_check_string(struct json_data_in *din, int *pos)
+{
+  int p = *pos + 1;
+
+  while (p < din->len && din->text[p] != '"') {
+    unsigned char c = din->text[p];
+
+    if (c < 0x20) {
+      return json_in_error(din, "control character in string");
+    } else if (c == '\\') {
+      p++;
+      if (p >= din->len) {
+        break;
+      }
+      if (din->text[p] == 'u') {
+        int value;
+
+        if (p + 4 >= din->len
+            || (value = json_in_hex4(din->text + p + 1)) < 0) {
+          return json_in_error(din, "invalid escape");
+        }
+        p += 5;
+        if (value == 0) {
+          return json_in_error(din, "\\u0000 is not allowed");
+        }
+        if (value >= 0xD800 && value <= 0xDBFF) {
+          int value2;
+
+          if (p + 5 >= din->len || din->text[p] != '\\'
+              || din->text[p + 1] != 'u'
+              || (value2 = json_in_hex4(din->text + p + 2)) < 0
+              || value2 < 0xDC00 || value2 > 0xDFFF) {
+            return json_in_error(din, "invalid Unicode");
+          }
+          p += 6;
+        } else if (value >= 0xDC00 && value <= 0xDFFF) {
+          return json_in_error(din, "invalid Unicode");
+        }
+      } else if (NULL != strchr("\"\\/bfnrt", din->text[p])
+                 && din->text[p] != '\0') {
+        p++;
+      } else {
+        return json_in_error(din, "invalid escape");
+      }
+    } else if (c >= 0x80) {
+      int codepoint;
+      int size = utf8_decode((const unsigned char *) din->text + p,
+                             din->len - p, &codepoint);
+
+      if (size == 0) {
+        return json_in_error(din, "unable to decode byte");
+      }
+      p += size;
+    } else {
+      p++;
+    }
+  }
+
+  if (p >= din->len) {
+    return json_in_error(din, "premature end of input");
+  }
+
+  *pos = p + 1;
+
+  return TRUE;
+}
+
 /**********************************************************************//**
-  Returns a CURL easy handle for name encoding and decoding
+  Convert the real number text at s, which uses '.' whatever the locale.
 **************************************************************************/
-static CURL *get_curl(void)
+static double json_in_strtod(const char *s)
 {
-  static CURL *curl_easy_handle = NULL;
+  const char *point = localeconv()->decimal_point;
+  char buf[128];
+  int len = 0;
 
-  if (curl_easy_handle == NULL) {
-    curl_easy_handle = curl_easy_init();
+  while (len < sizeof(buf) - 1 && NULL == strchr(",]} \t\n\r", s[len])) {
+    buf[len] = (s[len] == '.' ? *point : s[len]);
+    len++;
+  }
+  buf[len] = '\0';
+
+  return strtod(buf, NULL);
+}
+
+/**********************************************************************//**
+  Check the number at *pos, and move past it.
+**************************************************************************/
+static bool json_in_check_number(struct json_data_in *din, int *pos)
+{
+  const char *text = din->text;
+  int start = *pos;
+  int p = start;
+  bool real = FALSE;
+
+  if (p < din->len && text[p] == '-') {
+    p++;
+  }
+  if (p < din->len && text[p] == '0') {
+    p++;
+    if (p < din->len && fc_isdigit(text[p])) {
+      return json_in_error(din, "invalid token");
+    }
+  } else if (p < din->len && fc_isdigit(text[p])) {
+    while (p < din->len && fc_isdigit(text[p])) {
+      p++;
+    }
   } else {
-    /* Reuse the existing CURL easy handle */
-    curl_easy_reset(curl_easy_handle);
+    return json_in_error(din, "invalid token");
   }
 
-  return curl_easy_handle;
+  if (p < din->len && text[p] == '.') {
+    real = TRUE;
+    p++;
+    if (p >= din->len || !fc_isdigit(text[p])) {
+      return json_in_error(din, "invalid token");
+    }
+    while (p < din->len && fc_isdigit(text[p])) {
+      p++;
+    }
+  }
+  if (p < din->len && (text[p] == 'e' || text[p] == 'E')) {
+    real = TRUE;
+    p++;
+    if (p < din->len && (text[p] == '+' || text[p] == '-')) {
+      p++;
+    }
+    if (p >= din->len || !fc_isdigit(text[p])) {
+      return json_in_error(din, "invalid token");
+    }
+    while (p < din->len && fc_isdigit(text[p])) {
+      p++;
+    }
+  }
+
+  /* A structural character follows the number in valid text, so it can
+   * be converted in place. */
+  if (p >= din->len) {
+    return json_in_error(din, "premature end of input");
+  }
+
+  if (real) {
+    double value;
+
+    errno = 0;
+    value = json_in_strtod(text + start);
+
+    if ((value == HUGE_VAL || value == -HUGE_VAL) && errno == ERANGE) {
+      return json_in_error(din, "real number overflow");
+    }
+  } else {
+    errno = 0;
+    strtoll(text + start, NULL, 10);
+    if (errno == ERANGE) {
+      return json_in_error(din, "too big integer");
+    }
+  }
+
+  *pos = p;
+
+  return TRUE;
 }
 
-static void plocation_write_data(json_t *item,
-                                 const struct plocation *location,
-                                 json_t *data);
+static bool json_in_check_value(struct json_data_in *din, int *pos,
+                                int depth);
 
 /**********************************************************************//**
-  Helper for plocation_write_data(). Use it in stead of this.
+  Check the object or array starting at *pos, and move past it. The
+  fields of the top level object are indexed.
 **************************************************************************/
-static void plocation_write_field(json_t *item,
-                                  const struct plocation *location,
-                                  json_t *data)
+static bool json_in_check_container(struct json_data_in *din, int *pos,
+                                    int depth)
 {
-  if (location->sub_location == NULL) {
-    json_object_set_new(item, location->name, data);
-  } else {
-    plocation_write_data(json_object_get(item, location->name),
-                         location->sub_location, data);
+  bool object = (din->text[*pos] == '{');
+  char close = object ? '}' : ']';
+
+  if (depth >= JSON_IN_PARSER_MAX_DEPTH) {
+    return json_in_error(din, "maximum parsing depth reached");
+  }
+
+  (*pos)++;
+  json_in_space(din, pos);
+  if (*pos < din->len && din->text[*pos] == close) {
+    (*pos)++;
+    return TRUE;
+  }
+
+  for (;;) {
+    int key = -1;
+
+    if (object) {
+      if (*pos >= din->len || din->text[*pos] != '"') {
+        return json_in_error(din, "string or '}' expected");
+      }
+      key = *pos + 1;
+      if (!json_in_check_string(din, pos)) {
+        return FALSE;
+      }
+      json_in_space(din, pos);
+      if (*pos >= din->len || din->text[*pos] != ':') {
+        return json_in_error(din, "':' expected");
+      }
+      (*pos)++;
+      json_in_space(din, pos);
+    }
+
+    if (depth == 0 && object && din->nfields >= 0) {
+      if (din->nfields < JSON_IN_MAX_FIELDS) {
+        din->fields[din->nfields].key = key;
+        din->fields[din->nfields].value = *pos;
+        din->nfields++;
+      } else {
+        din->nfields = -1;
+      }
+    }
+
+    if (!json_in_check_value(din, pos, depth + 1)) {
+      return FALSE;
+    }
+
+    json_in_space(din, pos);
+    if (*pos < din->len && din->text[*pos] == ',') {
+      (*pos)++;
+      json_in_space(din, pos);
+    } else if (*pos < din->len && din->text[*pos] == close) {
+      (*pos)++;
+      return TRUE;
+    } else {
+      return json_in_error(din, object ? "'}' expected" : "']' expected");
+    }
   }
 }
 
 /**********************************************************************//**
-  Helper for plocation_write_data(). Use it in stead of this.
+  Check the value starting at *pos, and move past it.
 **************************************************************************/
-static void plocation_write_elem(json_t *item,
-                                 const struct plocation *location,
-                                 json_t *data)
+static bool json_in_check_value(struct json_data_in *din, int *pos,
+                                int depth)
 {
-  if (location->sub_location == NULL) {
-    json_array_set_new(item, location->number, data);
-  } else {
-    plocation_write_data(json_array_get(item, location->number),
-                         location->sub_location, data);
+  const char *literal;
+  int len;
+
+  json_in_space(din, pos);
+  if (*pos >= din->len) {
+    return json_in_error(din, "premature end of input");
   }
+
+  switch (din->text[*pos]) {
+  case '{':
+  case '[':
+    return json_in_check_container(din, pos, depth);
+  case '"':
+    return json_in_check_string(din, pos);
+  case 't':
+    literal = "true";
+    break;
+  case 'f':
+    literal = "false";
+    break;
+  case 'n':
+    literal = "null";
+    break;
+  default:
+    return json_in_check_number(din, pos);
+  }
+
+  len = strlen(literal);
+  if (*pos + len > din->len
+      || 0 != strncmp(din->text + *pos, literal, len)
+      || (*pos + len < din->len && fc_isalpha(din->text[*pos + len]))) {
+    return json_in_error(din, "invalid token");
+  }
+  *pos += len;
+
+  return TRUE;
 }
 
 /**********************************************************************//**
-  Write the specified JSON data to the given location in the provided
-  JSON item.
+  Prepare reading the JSON packet in text. It is checked like jansson
+  would when loading it, and the fields of the top level are indexed.
+  The text must stay unchanged while the packet is read.
 **************************************************************************/
-static void plocation_write_data(json_t *item,
-                                 const struct plocation *location,
-                                 json_t *data)
+bool dio_input_json_init(struct json_data_in *din, const char *text,
+                         int len)
 {
-  switch (location->kind) {
-  case PADR_FIELD:
-    plocation_write_field(item, location, data);
-    return;
-  case PADR_ELEMENT:
-    plocation_write_elem(item, location, data);
-    return;
+  int pos = 0;
+  int i;
+
+  din->text = text;
+  din->len = len;
+  din->error = NULL;
+  din->nfields = 0;
+  for (i = 0; i < JSON_IN_MAX_DEPTH; i++) {
+    din->cursor[i].array = -1;
+  }
+
+  json_in_space(din, &pos);
+  din->root = pos;
+  if (pos >= len || (text[pos] != '{' && text[pos] != '[')) {
+    return json_in_error(din, "'[' or '{' expected");
+  }
+  if (!json_in_check_container(din, &pos, 0)) {
+    return FALSE;
+  }
+  json_in_space(din, &pos);
+  if (pos != len) {
+    return json_in_error(din, "end of file expected");
+  }
+
+  return TRUE;
+}
+
+/**********************************************************************//**
+  Decode the escape sequence at *s, which is after the backslash, to out.
+  Returns the length of the decoded bytes. The text is valid.
+**************************************************************************/
+static int json_in_unescape(const char **s, char *out)
+{
+  char c = *(*s)++;
+  int value;
+
+  switch (c) {
+  case 'b':
+    *out = '\b';
+    return 1;
+  case 'f':
+    *out = '\f';
+    return 1;
+  case 'n':
+    *out = '\n';
+    return 1;
+  case 'r':
+    *out = '\r';
+    return 1;
+  case 't':
+    *out = '\t';
+    return 1;
+  case 'u':
+    value = json_in_hex4(*s);
+    *s += 4;
+    if (value >= 0xD800 && value <= 0xDBFF) {
+      int value2 = json_in_hex4(*s + 2);
+
+      *s += 6;
+      value = (((value - 0xD800) << 10) | (value2 - 0xDC00)) + 0x10000;
+    }
+    return utf8_encode(value, out);
   default:
-    log_error("Unknown packet part location kind.");
-    return;
+    *out = c;
+    return 1;
   }
 }
 
-static json_t *plocation_read_data(json_t *item,
-                                   const struct plocation *location);
+/**********************************************************************//**
+  Whether the key starting at the offset key is name.
+**************************************************************************/
+static bool json_in_key_equal(const struct json_data_in *din, int key,
+                              const char *name)
+{
+  const char *s = din->text + key;
+
+  while (*s != '"') {
+    if (*s == '\\') {
+      char decoded[4];
+      int len;
+
+      s++;
+      len = json_in_unescape(&s, decoded);
+      if (0 != strncmp(decoded, name, len)) {
+        return FALSE;
+      }
+      name += len;
+    } else {
+      if (*s != *name) {
+        return FALSE;
+      }
+      s++;
+      name++;
+    }
+  }
+
+  return *name == '\0';
+}
 
 /**********************************************************************//**
-  Helper for plocation_read_data(). Use it in stead of this.
+  Return the offset after the value at pos. The text is valid.
 **************************************************************************/
-static json_t *plocation_read_field(json_t *item,
-                                    const struct plocation *location)
+static int json_in_skip(const struct json_data_in *din, int pos)
 {
-  if (location->sub_location == NULL) {
-    return json_object_get(item, location->name);
-  } else {
-    return plocation_read_data(json_object_get(item, location->name),
-                               location->sub_location);
+  const char *text = din->text;
+  int depth = 0;
+
+  do {
+    switch (text[pos]) {
+    case '"':
+      for (pos++; text[pos] != '"'; pos++) {
+        if (text[pos] == '\\') {
+          pos++;
+        }
+      }
+      pos++;
+      break;
+    case '{':
+    case '[':
+      depth++;
+      pos++;
+      break;
+    case '}':
+    case ']':
+      depth--;
+      pos++;
+      break;
+    default:
+      if (depth == 0) {
+        while (pos < din->len && NULL == strchr(",]} \t\n\r", text[pos])) {
+          pos++;
+        }
+      } else {
+        pos++;
+      }
+      break;
+    }
+  } while (depth > 0);
+
+  return pos;
+}
+
+/**********************************************************************//**
+  Return the offset of the value of the field name of the object at pos,
+  or -1. As with jansson, the last one counts if there are several.
+**************************************************************************/
+static int json_in_member(const struct json_data_in *din, int pos,
+                          const char *name)
+{
+  int found = -1;
+
+  if (pos == din->root && din->nfields >= 0) {
+    int i;
+
+    for (i = din->nfields - 1; i >= 0; i--) {
+      if (json_in_key_equal(din, din->fields[i].key, name)) {
+        return din->fields[i].value;
+      }
+    }
+
+    return -1;
+  }
+
+  pos++;
+  json_in_space(din, &pos);
+  while (din->text[pos] == '"') {
+    bool match = json_in_key_equal(din, pos + 1, name);
+
+    pos = json_in_skip(din, pos);
+    json_in_space(din, &pos);
+    pos++;                      /* ':' */
+    json_in_space(din, &pos);
+    if (match) {
+      found = pos;
+    }
+    pos = json_in_skip(din, pos);
+    json_in_space(din, &pos);
+    if (din->text[pos] != ',') {
+      break;
+    }
+    pos++;
+    json_in_space(din, &pos);
   }
+
+  return found;
 }
 
 /**********************************************************************//**
-  Helper for plocation_read_data(). Use it in stead of this.
+  Return the offset of the element number of the array at pos, or -1.
+  Looking up elements in order continues from the previous one.
 **************************************************************************/
-static json_t *plocation_read_elem(json_t *item,
-                                   const struct plocation *location)
+static int json_in_element(struct json_data_in *din, int pos, int number,
+                           int depth)
 {
-  if (location->sub_location == NULL) {
-    return json_array_get(item, location->number);
+  int elem, i;
+
+  if (number < 0) {
+    return -1;
+  }
+
+  if (depth < JSON_IN_MAX_DEPTH && din->cursor[depth].array == pos
+      && din->cursor[depth].number <= number) {
+    i = din->cursor[depth].number;
+    elem = din->cursor[depth].elem;
   } else {
-    return plocation_read_data(json_array_get(item, location->number),
-                               location->sub_location);
+    elem = pos + 1;
+    json_in_space(din, &elem);
+    if (din->text[elem] == ']') {
+      return -1;
+    }
+    i = 0;
+  }
+
+  for (; i < number; i++) {
+    elem = json_in_skip(din, elem);
+    json_in_space(din, &elem);
+    if (din->text[elem] != ',') {
+      return -1;
+    }
+    elem++;
+    json_in_space(din, &elem);
+  }
+
+  if (depth < JSON_IN_MAX_DEPTH) {
+    din->cursor[depth].array = pos;
+    din->cursor[depth].number = number;
+    din->cursor[depth].elem = elem;
   }
+
+  return elem;
 }
 
 /**********************************************************************//**
-  Read JSON data from the given location in the provided JSON item.
+  Return the offset of the value at location inside the value at pos,
+  or -1 if there is none.
 **************************************************************************/
-static json_t *plocation_read_data(json_t *item,
-                                   const struct plocation *location)
+static int json_in_find(struct json_data_in *din, int pos,
+                        const struct plocation *location)
 {
-  switch (location->kind) {
-  case PADR_FIELD:
-    return plocation_read_field(item, location);
-  case PADR_ELEMENT:
-    return plocation_read_elem(item, location);
-  default:
-    log_error("Unknown packet part location kind.");
+  int depth;
+
+  for (depth = 0; location != NULL && pos >= 0;
+       location = location->sub_location, depth++) {
+    if (location->kind == PADR_FIELD) {
+      pos = (din->text[pos] == '{'
+             ? json_in_member(din, pos, location->name) : -1);
+    } else {
+      pos = (din->text[pos] == '['
+             ? json_in_element(din, pos, location->number, depth) : -1);
+    }
+  }
+
+  return pos;
+}
+
+/**********************************************************************//**
+  Whether the number at pos is a real, as opposed to an integer.
+**************************************************************************/
+static bool json_in_is_real(const struct json_data_in *din, int pos)
+{
+  const char *s = din->text + pos;
+
+  if (*s == '-') {
+    s++;
+  }
+  while (fc_isdigit(*s)) {
+    s++;
+  }
+
+  return *s == '.' || *s == 'e' || *s == 'E';
+}
+
+/**********************************************************************//**
+  Value of the integer at pos, like json_integer_value(): 0 if it is not
+  an integer.
+**************************************************************************/
+static json_int_t json_in_integer(const struct json_data_in *din, int pos)
+{
+  const char *s = din->text + pos;
+
+  if ((*s != '-' && !fc_isdigit(*s)) || json_in_is_real(din, pos)) {
+    return 0;
+  }
+
+  return strtoll(s, NULL, 10);
+}
+
+/**********************************************************************//**
+  Value of the real at pos, like json_real_value(): 0 if it is not a
+  real.
+**************************************************************************/
+static double json_in_real(const struct json_data_in *din, int pos)
+{
+  const char *s = din->text + pos;
+
+  if ((*s != '-' && !fc_isdigit(*s)) || !json_in_is_real(din, pos)) {
+    return 0.0;
+  }
+
+  return json_in_strtod(s);
+}
+
+/**********************************************************************//**
+  Number of elements of the array at pos, or -1 if it is not an array.
+**************************************************************************/
+static int json_in_array_size(const struct json_data_in *din, int pos)
+{
+  int size = 0;
+
+  if (din->text[pos] != '[') {
+    return -1;
+  }
+
+  pos++;
+  json_in_space(din, &pos);
+  while (din->text[pos] != ']') {
+    size++;
+    pos = json_in_skip(din, pos);
+    json_in_space(din, &pos);
+    if (din->text[pos] == ',') {
+      pos++;
+      json_in_space(din, &pos);
+    }
+  }
+
+  return size;
+}
+
+/**********************************************************************//**
+  Decode the string at pos. Returns a pointer to buf, or to allocated
+  memory when it does not fit there, or NULL if it is not a string.
+**************************************************************************/
+static char *json_in_string(const struct json_data_in *din, int pos,
+                            char *buf, size_t buf_size)
+{
+  const char *s = din->text + pos;
+  char *out, *result;
+  int end;
+
+  if (*s != '"') {
     return NULL;
   }
+
+  end = json_in_skip(din, pos);
+  if (end - pos > buf_size) {
+    result = fc_malloc(end - pos);
+  } else {
+    result = buf;
+  }
+
+  out = result;
+  for (s++; *s != '"';) {
+    if (*s == '\\') {
+      s++;
+      out += json_in_unescape(&s, out);
+    } else {
+      *out++ = *s++;
+    }
+  }
+  *out = '\0';
+
+  return result;
 }
 
 /**********************************************************************//**
@@ -192,7 +1519,7 @@ void dio_put_uint8_json(struct json_data_out *dout,
                         int value)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, json_integer(value));
+    json_out_integer(dout, location, value);
   } else {
     dio_put_uint8_raw(&dout->raw, value);
   }
@@ -206,7 +1533,7 @@ void dio_put_sint8_json(struct json_data_out *dout,
                         int value)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, json_integer(value));
+    json_out_integer(dout, location, value);
   } else {
     dio_put_sint8_raw(&dout->raw, value);
   }
@@ -219,7 +1546,7 @@ void dio_put_uint16_json(struct json_data_out *dout,
                          const struct plocation *location, int value)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, json_integer(value));
+    json_out_integer(dout, location, value);
   } else {
     dio_put_uint16_raw(&dout->raw, value);
   }
@@ -232,7 +1559,7 @@ void dio_put_sint16_json(struct json_data_out *dout,
                          const struct plocation *location, int value)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, json_integer(value));
+    json_out_integer(dout, location, value);
   } else {
     dio_put_sint16_raw(&dout->raw, value);
   }
@@ -246,30 +1573,48 @@ void dio_put_cm_parameter_json(struct json_data_out *dout,
                                const struct cm_parameter *param)
 {
   if (dout->json) {
-    json_t *obj = json_object();
-    json_t *min_surplus = json_array();
-    json_t *factor = json_array();
+    struct json_out_path path;
+    struct json_out_value obj = { .kind = JSON_OUT_OBJECT };
+    struct json_out_value array = { .kind = JSON_OUT_ARRAY,
+                                    .size = O_LAST };
     int i;
 
+    json_out_path_init(&path, location);
+    json_out_write(dout, &path, &obj);
+
+    json_out_path_field(&path, "minimal_surplus");
+    json_out_write(dout, &path, &array);
+    for (i = 0; i < O_LAST; i++) {
+      struct json_out_value value = { .kind = JSON_OUT_INTEGER,
+                                      .integer = param->minimal_surplus[i] };
+
+      json_out_path_elem(&path, i);
+      json_out_write(dout, &path, &value);
+      path.n--;
+    }
+    path.n--;
+
+    json_out_path_field(&path, "factor");
+    json_out_write(dout, &path, &array);
     for (i = 0; i < O_LAST; i++) {
-      json_array_append_new(min_surplus,
-                            json_integer(param->minimal_surplus[i]));
-      json_array_append_new(factor,
-                            json_integer(param->factor[i]));
-    }
-
-    json_object_set_new(obj, "minimal_surplus", min_surplus);
-    json_object_set_new(obj, "factor", factor);
-    json_object_set_new(obj, "max_growth", json_boolean(param->max_growth));
-    json_object_set_new(obj, "require_happy",
-                        json_boolean(param->require_happy));
-    json_object_set_new(obj, "allow_disorder",
-                        json_boolean(param->allow_disorder));
-    json_object_set_new(obj, "allow_specialists",
-                        json_boolean(param->allow_specialists));
-    json_object_set_new(obj, "happy_factor",
-                        json_integer(param->happy_factor));
-    plocation_write_data(dout->json, location, obj);
+      struct json_out_value value = { .kind = JSON_OUT_INTEGER,
+                                      .integer = param->factor[i] };
+
+      json_out_path_elem(&path, i);
+      json_out_write(dout, &path, &value);
+      path.n--;
+    }
+    path.n--;
+
+    json_out_member_boolean(dout, &path, "max_growth", param->max_growth);
+    json_out_member_boolean(dout, &path, "require_happy",
+                            param->require_happy);
+    json_out_member_boolean(dout, &path, "allow_disorder",
+                            param->allow_disorder);
+    json_out_member_boolean(dout, &path, "allow_specialists",
+                            param->allow_specialists);
+    json_out_member_integer(dout, &path, "happy_factor",
+                            param->happy_factor);
   } else {
     dio_put_cm_parameter_raw(&dout->raw, param);
   }
@@ -283,14 +1628,17 @@ void dio_put_unit_order_json(struct json_data_out *dout,
                              const struct unit_order *order)
 {
   if (dout->json) {
-    json_t *obj = json_object();
-    json_object_set_new(obj, "order", json_integer(order->order));
-    json_object_set_new(obj, "activity", json_integer(order->activity));
-    json_object_set_new(obj, "target", json_integer(order->target));
-    json_object_set_new(obj, "sub_target", json_integer(order->sub_target));
-    json_object_set_new(obj, "action", json_integer(order->action));
-    json_object_set_new(obj, "dir", json_integer(order->dir));
-    plocation_write_data(dout->json, location, obj);
+    struct json_out_path path;
+    struct json_out_value obj = { .kind = JSON_OUT_OBJECT };
+
+    json_out_path_init(&path, location);
+    json_out_write(dout, &path, &obj);
+    json_out_member_integer(dout, &path, "order", order->order);
+    json_out_member_integer(dout, &path, "activity", order->activity);
+    json_out_member_integer(dout, &path, "target", order->target);
+    json_out_member_integer(dout, &path, "sub_target", order->sub_target);
+    json_out_member_integer(dout, &path, "action", order->action);
+    json_out_member_integer(dout, &path, "dir", order->dir);
   } else {
     dio_put_unit_order_raw(&dout->raw, order);
   }
@@ -304,28 +1652,26 @@ void dio_put_worklist_json(struct json_data_out *dout,
                            const struct worklist *pwl)
 {
   if (dout->json) {
+    struct json_out_path path;
+    struct json_out_value obj = { .kind = JSON_OUT_OBJECT };
     int i;
     const int size = worklist_length(pwl);
 
     /* Must create the array before instertion. */
     dio_put_farray_json(dout, location, size);
 
-    location->sub_location = plocation_elem_new(0);
+    json_out_path_init(&path, location);
 
     for (i = 0; i < size; i++) {
       const struct universal *pcp = &(pwl->entries[i]);
-      json_t *universal = json_object();
-
-      location->sub_location->number = i;
-
-      json_object_set_new(universal, "kind", json_integer(pcp->kind));
-      json_object_set_new(universal, "value",
-                          json_integer(universal_number(pcp)));
 
-      plocation_write_data(dout->json, location, universal);
+      json_out_path_elem(&path, i);
+      json_out_write(dout, &path, &obj);
+      json_out_member_integer(dout, &path, "kind", pcp->kind);
+      json_out_member_integer(dout, &path, "value",
+                              universal_number(pcp));
+      path.n--;
     }
-
-    FC_FREE(location->sub_location);
   } else {
     dio_put_worklist_raw(&dout->raw, pwl);
   }
@@ -334,22 +1680,17 @@ void dio_put_worklist_json(struct json_data_out *dout,
 /**********************************************************************//**
   Receive uint8 value to dest with json.
 **************************************************************************/
-static bool dio_get_uint8_json_internal(json_t *json_packet,
+static bool dio_get_uint8_json_internal(struct json_data_in *din, int from,
                                         const struct plocation *location,
                                         int *dest)
 {
-  json_t *pint = plocation_read_data(json_packet, location);
+  int pos = json_in_find(din, from, location);
 
-  if (!pint) {
+  if (pos < 0) {
     log_error("ERROR: Unable to get uint8 from location: %s", plocation_name(location));
     return FALSE;
   }
-  *dest = json_integer_value(pint);
-
-  if (!dest) {
-    log_error("ERROR: Unable to get unit8 from location: %s", plocation_name(location));
-    return FALSE;
-  }
+  *dest = json_in_integer(din, pos);
 
   return TRUE;
 }
@@ -361,7 +1702,9 @@ bool dio_get_uint8_json(struct connection *pc, struct data_in *din,
                         const struct plocation *location, int *dest)
 {
   if (pc->json_mode) {
-    return dio_get_uint8_json_internal(pc->json_packet, location, dest);
+    return dio_get_uint8_json_internal(&pc->json_packet,
+                                       pc->json_packet.root,
+                                       location, dest);
   } else {
     return dio_get_uint8_raw(din, dest);
   }
@@ -374,18 +1717,14 @@ bool dio_get_uint16_json(struct connection *pc, struct data_in *din,
                          const struct plocation *location, int *dest)
 {
   if (pc->json_mode) {
-    json_t *pint = plocation_read_data(pc->json_packet, location);
+    int pos = json_in_find(&pc->json_packet, pc->json_packet.root,
+                           location);
 
-    if (!pint) {
+    if (pos < 0) {
       log_error("ERROR: Unable to get uint16 from location: %s", plocation_name(location));
       return FALSE;
-    } 
-    *dest = json_integer_value(pint);
-
-    if (!dest) {
-      log_error("ERROR: Unable to get unit16 from location: %s", plocation_name(location));
-      return FALSE;
     }
+    *dest = json_in_integer(&pc->json_packet, pos);
   } else {
     return dio_get_uint16_raw(din, dest);
   }
@@ -396,22 +1735,17 @@ bool dio_get_uint16_json(struct connection *pc, struct data_in *din,
 /**********************************************************************//**
   Receive uint32 value to dest with json.
 **************************************************************************/
-static bool dio_get_uint32_json_internal(json_t *json_packet,
+static bool dio_get_uint32_json_internal(struct json_data_in *din, int from,
                                          const struct plocation *location,
                                          int *dest)
 {
-  json_t *pint = plocation_read_data(json_packet, location);
+  int pos = json_in_find(din, from, location);
 
-  if (!pint) {
+  if (pos < 0) {
     log_error("ERROR: Unable to get uint32 from location: %s", plocation_name(location));
     return FALSE;
   }
-  *dest = json_integer_value(pint);
-
-  if (!dest) {
-    log_error("ERROR: Unable to get unit32 from location: %s", plocation_name(location));
-    return FALSE;
-  }
+  *dest = json_in_integer(din, pos);
 
   return TRUE;
 }
@@ -423,7 +1757,9 @@ bool dio_get_uint32_json(struct connection *pc, struct data_in *din,
                          const struct plocation *location, int *dest)
 {
   if (pc->json_mode) {
-    return dio_get_uint32_json_internal(pc->json_packet, location, dest);
+    return dio_get_uint32_json_internal(&pc->json_packet,
+                                        pc->json_packet.root,
+                                        location, dest);
   } else {
     return dio_get_uint32_raw(din, dest);
   }
@@ -436,7 +1772,9 @@ bool dio_get_sint32_json(struct connection *pc, struct data_in *din,
                          const struct plocation *location, int *dest)
 {
   if (pc->json_mode) {
-    return dio_get_uint32_json_internal(pc->json_packet, location, dest);
+    return dio_get_uint32_json_internal(&pc->json_packet,
+                                        pc->json_packet.root,
+                                        location, dest);
   } else {
     return dio_get_sint32_raw(din, dest);
   }
@@ -606,19 +1944,17 @@ bool dio_get_worklist_json(struct connection *pc, struct data_in *din,
 {
   if (pc->json_mode) {
     int i, length;
-
-    const json_t *wlist = plocation_read_data(pc->json_packet, location);
+    int pos = json_in_find(&pc->json_packet, pc->json_packet.root,
+                           location);
 
     worklist_init(pwl);
 
-    if (!json_is_array(wlist)) {
+    length = (pos < 0 ? -1 : json_in_array_size(&pc->json_packet, pos));
+    if (length < 0) {
       log_packet("Not a worklist");
       return FALSE;
     }
 
-    /* Safe. Checked that it was an array above. */
-    length = json_array_size(wlist);
-
     /* A worklist is an array... */
     location->sub_location = plocation_elem_new(0);
 
@@ -633,7 +1969,9 @@ bool dio_get_worklist_json(struct connection *pc, struct data_in *din,
       location->sub_location->number = i;
 
       location->sub_location->sub_location->name = "kind";
-      if (!dio_get_uint8_json_internal(pc->json_packet, location, &kind)) {
+      if (!dio_get_uint8_json_internal(&pc->json_packet,
+                                       pc->json_packet.root,
+                                       location, &kind)) {
         log_packet("Corrupt worklist element kind");
         FC_FREE(location->sub_location->sub_location);
         FC_FREE(location->sub_location);
@@ -641,7 +1979,9 @@ bool dio_get_worklist_json(struct connection *pc, struct data_in *din,
       }
 
       location->sub_location->sub_location->name = "value";
-      if (!dio_get_uint8_json_internal(pc->json_packet, location, &value)) {
+      if (!dio_get_uint8_json_internal(&pc->json_packet,
+                                       pc->json_packet.root,
+                                       location, &value)) {
         log_packet("Corrupt worklist element value");
         FC_FREE(location->sub_location->sub_location);
         FC_FREE(location->sub_location);
@@ -713,51 +2053,58 @@ bool dio_get_requirement_json(struct connection *pc, struct data_in *din,
     struct plocation *req_field;
 
     /* Find the requirement object. */
-    json_t *requirement = plocation_read_data(pc->json_packet, location);
+    int requirement = json_in_find(&pc->json_packet, pc->json_packet.root,
+                                   location);
 
-    if (!requirement) {
+    if (requirement < 0) {
       log_error("ERROR: Unable to get requirement from location: %s", plocation_name(location));
       return FALSE;
     }
 
     /* Find the requirement object fields and translate their values. */
     req_field = plocation_field_new("kind");
-    if (!dio_get_uint8_json_internal(requirement, req_field, &kind)) {
+    if (!dio_get_uint8_json_internal(&pc->json_packet, requirement,
+                                     req_field, &kind)) {
       log_error("ERROR: Unable to get part of requirement from location: %s",
                 plocation_name(location));
       return FALSE;
     }
 
     req_field->name = "value";
-    if (!dio_get_uint32_json_internal(requirement, req_field, &value)) {
+    if (!dio_get_uint32_json_internal(&pc->json_packet, requirement,
+                                     req_field, &value)) {
       log_error("ERROR: Unable to get part of requirement from location: %s",
                 plocation_name(location));
       return FALSE;
     }
 
     req_field->name = "range";
-    if (!dio_get_uint8_json_internal(requirement, req_field, &range)) {
+    if (!dio_get_uint8_json_internal(&pc->json_packet, requirement,
+                                     req_field, &range)) {
       log_error("ERROR: Unable to get part of requirement from location: %s",
                 plocation_name(location));
       return FALSE;
     }
 
     req_field->name = "survives";
-    if (!dio_get_bool8_json_internal(requirement, req_field, &survives)) {
+    if (!dio_get_bool8_json_internal(&pc->json_packet, requirement,
+                                     req_field, &survives)) {
       log_error("ERROR: Unable to get part of requirement from location: %s",
                 plocation_name(location));
       return FALSE;
     }
 
     req_field->name = "present";
-    if (!dio_get_bool8_json_internal(requirement, req_field, &present)) {
+    if (!dio_get_bool8_json_internal(&pc->json_packet, requirement,
+                                     req_field, &present)) {
       log_error("ERROR: Unable to get part of requirement from location: %s",
                 plocation_name(location));
       return FALSE;
     }
 
     req_field->name = "quiet";
-    if (!dio_get_bool8_json_internal(requirement, req_field, &quiet)) {
+    if (!dio_get_bool8_json_internal(&pc->json_packet, requirement,
+                                     req_field, &quiet)) {
       log_error("ERROR: Unable to get part of requirement from location: %s",
                 plocation_name(location));
       return FALSE;
@@ -785,9 +2132,10 @@ bool dio_get_action_probability_json(struct connection *pc, struct data_in *din,
     struct plocation *ap_field;
 
     /* Find the action probability object. */
-    json_t *action_probability = plocation_read_data(pc->json_packet, location);
+    int action_probability = json_in_find(&pc->json_packet,
+                                          pc->json_packet.root, location);
 
-    if (!action_probability) {
+    if (action_probability < 0) {
       log_error("ERROR: Unable to get action probability from location: %s",
                 plocation_name(location));
       return FALSE;
@@ -796,7 +2144,8 @@ bool dio_get_action_probability_json(struct connection *pc, struct data_in *din,
     /* Find the action probability object fields and translate their
      * values. */
     ap_field = plocation_field_new("min");
-    if (!dio_get_uint8_json_internal(action_probability, ap_field, &prob->min)) {
+    if (!dio_get_uint8_json_internal(&pc->json_packet, action_probability,
+                                     ap_field, &prob->min)) {
       log_error("ERROR: Unable to get part of action probability "
                 "from location: %s",
                 plocation_name(location));
@@ -804,7 +2153,8 @@ bool dio_get_action_probability_json(struct connection *pc, struct data_in *din,
     }
 
     ap_field->name = "max";
-    if (!dio_get_uint8_json_internal(action_probability, ap_field, &prob->max)) {
+    if (!dio_get_uint8_json_internal(&pc->json_packet, action_probability,
+                                     ap_field, &prob->max)) {
       log_error("ERROR: Unable to get part of action probability "
                 "from location: %s",
                 plocation_name(location));
@@ -826,16 +2176,11 @@ void dio_put_farray_json(struct json_data_out *dout,
                          const struct plocation *location, int size)
 {
   if (dout->json) {
-    int i;
-    json_t *farray = json_array();
-
-    /* Jansson's json_array_set_new() refuses to create array elements so
-     * they must be created with the array. */
-    for (i = 0; i < size; i++) {
-      json_array_append_new(farray, json_null());
-    }
+    struct json_out_path path;
+    struct json_out_value farray = { .kind = JSON_OUT_ARRAY, .size = size };
 
-    plocation_write_data(dout->json, location, farray);
+    json_out_path_init(&path, location);
+    json_out_write(dout, &path, &farray);
   } else {
     /* No caller needs this */
   }
@@ -848,7 +2193,7 @@ void dio_put_uint32_json(struct json_data_out *dout,
                          const struct plocation *location, int value)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, json_integer(value));
+    json_out_integer(dout, location, value);
   } else {
     dio_put_uint32_raw(&dout->raw, value);
   }
@@ -861,7 +2206,7 @@ void dio_put_sint32_json(struct json_data_out *dout,
                          const struct plocation *location, int value)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, json_integer(value));
+    json_out_integer(dout, location, value);
   } else {
     dio_put_sint32_raw(&dout->raw, value);
   }
@@ -874,7 +2219,7 @@ void dio_put_bool8_json(struct json_data_out *dout,
                         const struct plocation *location, bool value)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, value ? json_true() : json_false());
+    json_out_boolean(dout, location, value);
   } else {
     dio_put_bool8_raw(&dout->raw, value);
   }
@@ -887,7 +2232,7 @@ void dio_put_bool32_json(struct json_data_out *dout,
                          const struct plocation *location, bool value)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, value ? json_true() : json_false());
+    json_out_boolean(dout, location, value);
   } else {
     dio_put_bool32_raw(&dout->raw, value);
   }
@@ -901,7 +2246,7 @@ void dio_put_ufloat_json(struct json_data_out *dout,
                          float value, int float_factor)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, json_real(value));
+    json_out_real(dout, location, value);
   } else {
     dio_put_ufloat_raw(&dout->raw, value, float_factor);
   }
@@ -915,7 +2260,7 @@ void dio_put_sfloat_json(struct json_data_out *dout,
                          float value, int float_factor)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, json_real(value));
+    json_out_real(dout, location, value);
   } else {
     dio_put_sfloat_raw(&dout->raw, value, float_factor);
   }
@@ -960,20 +2305,21 @@ void dio_put_memory_json(struct json_data_out *dout,
                          size_t size)
 {
   if (dout->json) {
+    struct json_out_path path;
     int i;
 
     dio_put_farray_json(dout, location, size);
 
-    location->sub_location = plocation_elem_new(0);
+    json_out_path_init(&path, location);
 
     for (i = 0; i < size; i++) {
-      location->sub_location->number = i;
+      struct json_out_value elem = { .kind = JSON_OUT_INTEGER,
+                                     .integer = ((unsigned char *)value)[i] };
 
-      dio_put_uint8_json(dout, location,
-                         ((unsigned char *)value)[i]);
+      json_out_path_elem(&path, i);
+      json_out_write(dout, &path, &elem);
+      path.n--;
     }
-
-    FC_FREE(location->sub_location);
   } else {
     dio_put_memory_raw(&dout->raw, value, size);
   }
@@ -987,7 +2333,7 @@ void dio_put_string_json(struct json_data_out *dout,
                          const char *value)
 {
   if (dout->json) {
-    plocation_write_data(dout->json, location, json_string(value));
+    json_out_string(dout, location, value);
   } else {
     dio_put_string_raw(&dout->raw, value);
   }
@@ -1026,26 +2372,26 @@ void dio_put_requirement_json(struct json_data_out *dout,
   if (dout->json) {
     int kind, range, value;
     bool survives, present, quiet;
-
-    /* Create the requirement object. */
-    json_t *requirement = json_object();
+    struct json_out_path path;
+    struct json_out_value requirement = { .kind = JSON_OUT_OBJECT };
 
     /* Read the requirement values. */
     req_get_values(preq, &kind, &range, &survives, &present, &quiet, &value);
 
+    /* Create the requirement object. */
+    json_out_path_init(&path, location);
+    json_out_write(dout, &path, &requirement);
+
     /* Write the requirement values to the fields of the requirement
      * object. */
-    json_object_set_new(requirement, "kind", json_integer(kind));
-    json_object_set_new(requirement, "value", json_integer(value));
+    json_out_member_integer(dout, &path, "kind", kind);
+    json_out_member_integer(dout, &path, "value", value);
 
-    json_object_set_new(requirement, "range", json_integer(range));
+    json_out_member_integer(dout, &path, "range", range);
 
-    json_object_set_new(requirement, "survives", json_boolean(survives));
-    json_object_set_new(requirement, "present", json_boolean(present));
-    json_object_set_new(requirement, "quiet", json_boolean(quiet));
-
-    /* Put the requirement object in the packet. */
-    plocation_write_data(dout->json, location, requirement);
+    json_out_member_boolean(dout, &path, "survives", survives);
+    json_out_member_boolean(dout, &path, "present", present);
+    json_out_member_boolean(dout, &path, "quiet", quiet);
   } else {
     dio_put_requirement_raw(&dout->raw, preq);
   }
@@ -1059,16 +2405,17 @@ void dio_put_action_probability_json(struct json_data_out *dout,
                                      const struct act_prob *prob)
 {
   if (dout->json) {
+    struct json_out_path path;
+    struct json_out_value action_probability = { .kind = JSON_OUT_OBJECT };
+
     /* Create the action probability object. */
-    json_t *action_probability = json_object();
+    json_out_path_init(&path, location);
+    json_out_write(dout, &path, &action_probability);
 
     /* Write the action probability values to the fields of the action
      * probability object. */
-    json_object_set_new(action_probability, "min", json_integer(prob->min));
-    json_object_set_new(action_probability, "max", json_integer(prob->max));
-
-    /* Put the action probability object in the packet. */
-    plocation_write_data(dout->json, location, action_probability);
+    json_out_member_integer(dout, &path, "min", prob->min);
+    json_out_member_integer(dout, &path, "max", prob->max);
   } else {
     dio_put_action_probability_raw(&dout->raw, prob);
   }
@@ -1077,22 +2424,17 @@ void dio_put_action_probability_json(struct json_data_out *dout,
 /**********************************************************************//**
   Receive bool value.
 **************************************************************************/
-static bool dio_get_bool8_json_internal(json_t *json_packet,
+static bool dio_get_bool8_json_internal(struct json_data_in *din, int from,
                                         const struct plocation *location,
                                         bool *dest)
 {
-  json_t *pbool = plocation_read_data(json_packet, location);
+  int pos = json_in_find(din, from, location);
 
-  if (!pbool) {
+  if (pos < 0) {
     log_error("ERROR: Unable to get bool8 from location: %s", plocation_name(location));
     return FALSE;
-  } 
-  *dest = json_is_true(pbool);
-
-  if (!dest) {
-    log_error("ERROR: Unable to get bool from location: %s", plocation_name(location));
-    return FALSE;
   }
+  *dest = (din->text[pos] == 't');
 
   return TRUE;
 }
@@ -1104,7 +2446,9 @@ bool dio_get_bool8_json(struct connection *pc, struct data_in *din,
                         const struct plocation *location, bool *dest)
 {
   if (pc->json_mode) {
-    return dio_get_bool8_json_internal(pc->json_packet, location, dest);
+    return dio_get_bool8_json_internal(&pc->json_packet,
+                                       pc->json_packet.root,
+                                       location, dest);
   } else {
     return dio_get_bool8_raw(din, dest);
   }
@@ -1117,18 +2461,14 @@ bool dio_get_bool32_json(struct connection *pc, struct data_in *din,
                          const struct plocation *location, bool *dest)
 {
   if (pc->json_mode) {
-    json_t *pbool = plocation_read_data(pc->json_packet, location);
-
-    if (!pbool) {
-      log_error("ERROR: Unable to get bool32 from location: %s", plocation_name(location));
-      return FALSE;
-    }
-    *dest = json_is_true(pbool);
+    int pos = json_in_find(&pc->json_packet, pc->json_packet.root,
+                           location);
 
-    if (!dest) {
+    if (pos < 0) {
       log_error("ERROR: Unable to get bool32 from location: %s", plocation_name(location));
       return FALSE;
     }
+    *dest = (pc->json_packet.text[pos] == 't');
   } else {
     return dio_get_bool32_raw(din, dest);
   }
@@ -1144,13 +2484,14 @@ bool dio_get_ufloat_json(struct connection *pc, struct data_in *din,
                          float *dest, int float_factor)
 {
   if (pc->json_mode) {
-    json_t *preal = plocation_read_data(pc->json_packet, location);
+    int pos = json_in_find(&pc->json_packet, pc->json_packet.root,
+                           location);
 
-    if (!preal) {
+    if (pos < 0) {
       log_error("ERROR: Unable to get real from location: %s", plocation_name(location));
       return FALSE;
     }
-    *dest = json_real_value(preal);
+    *dest = json_in_real(&pc->json_packet, pos);
   } else {
     return dio_get_ufloat_raw(din, dest, float_factor);
   }
@@ -1166,13 +2507,14 @@ bool dio_get_sfloat_json(struct connection *pc, struct data_in *din,
                          float *dest, int float_factor)
 {
   if (pc->json_mode) {
-    json_t *preal = plocation_read_data(pc->json_packet, location);
+    int pos = json_in_find(&pc->json_packet, pc->json_packet.root,
+                           location);
 
-    if (!preal) {
+    if (pos < 0) {
       log_error("ERROR: Unable to get real from location: %s", plocation_name(location));
       return FALSE;
     }
-    *dest = json_real_value(preal);
+    *dest = json_in_real(&pc->json_packet, pos);
   } else {
     return dio_get_sfloat_raw(din, dest, float_factor);
   }
@@ -1187,18 +2529,14 @@ bool dio_get_sint8_json(struct connection *pc, struct data_in *din,
                         const struct plocation *location, int *dest)
 {
   if (pc->json_mode) {
-    json_t *pint = plocation_read_data(pc->json_packet, location);
-
-    if (!pint) {
-      log_error("ERROR: Unable to get sint8 from location: %s", plocation_name(location));
-      return FALSE;
-    }
-    *dest = json_integer_value(pint);
+    int pos = json_in_find(&pc->json_packet, pc->json_packet.root,
+                           location);
 
-    if (!dest) {
+    if (pos < 0) {
       log_error("ERROR: Unable to get sint8 from location: %s", plocation_name(location));
       return FALSE;
     }
+    *dest = json_in_integer(&pc->json_packet, pos);
   } else {
     return dio_get_sint8_raw(din, dest);
   }
@@ -1213,18 +2551,14 @@ bool dio_get_sint16_json(struct connection *pc, struct data_in *din,
                          const struct plocation *location, int *dest)
 {
   if (pc->json_mode) {
-    json_t *pint = plocation_read_data(pc->json_packet, location);
-
-    if (!pint) {
-      log_error("ERROR: Unable to get sint16 from location: %s", plocation_name(location));
-      return FALSE;
-    }
-    *dest = json_integer_value(pint);
+    int pos = json_in_find(&pc->json_packet, pc->json_packet.root,
+                           location);
 
-    if (!dest) {
+    if (pos < 0) {
       log_error("ERROR: Unable to get sint16 from location: %s", plocation_name(location));
       return FALSE;
     }
+    *dest = json_in_integer(&pc->json_packet, pos);
   } else {
     return dio_get_sint16_raw(din, dest);
   }
@@ -1240,23 +2574,26 @@ bool dio_get_memory_json(struct connection *pc, struct data_in *din,
                          void *dest, size_t dest_size)
 {
   if (pc->json_mode) {
+    struct plocation elem = { .kind = PADR_ELEMENT };
     int i;
 
-    location->sub_location = plocation_elem_new(0);
+    location->sub_location = &elem;
 
     for (i = 0; i < dest_size; i++) {
       int val;
 
-      location->sub_location->number = i;
+      elem.number = i;
 
-      if (!dio_get_uint8_json_internal(pc->json_packet, location, &val)) {
-        free(location->sub_location);
+      if (!dio_get_uint8_json_internal(&pc->json_packet,
+                                       pc->json_packet.root,
+                                       location, &val)) {
+        location->sub_location = NULL;
         return FALSE;
       }
       ((unsigned char *)dest)[i] = val;
     }
 
-    FC_FREE(location->sub_location);
+    location->sub_location = NULL;
   } else {
     return dio_get_memory_raw(din, dest, dest_size);
   }
@@ -1267,27 +2604,38 @@ bool dio_get_memory_json(struct connection *pc, struct data_in *din,
 /**********************************************************************//**
   Receive at max max_dest_size bytes long NULL-terminated string.
 **************************************************************************/
-static bool dio_get_string_json_internal(json_t *json_packet,
+static bool dio_get_string_json_internal(struct json_data_in *din,
                                          const struct plocation *location,
                                          char *dest, size_t max_dest_size)
 {
-  json_t *pstring = plocation_read_data(json_packet, location);
-  const char *result_str;
+  int pos = json_in_find(din, din->root, location);
+  char buf[MAX_LEN_PACKET];
+  char *result_str;
+  bool ret = TRUE;
 
-  if (!pstring) {
+  if (pos < 0) {
     log_error("ERROR: Unable to get string from location: %s", plocation_name(location));
     return FALSE;
   }
 
-  result_str = json_string_value(pstring);
+  result_str = json_in_string(din, pos, buf, sizeof(buf));
+
+  if (result_str == NULL) {
+    log_error("ERROR: Unable to get string from location: %s", plocation_name(location));
+    return FALSE;
+  }
 
   if (dest
       && !dataio_get_conv_callback(dest, max_dest_size, result_str, strlen(result_str))) {
     log_error("ERROR: Unable to get string from location: %s", plocation_name(location));
-    return FALSE;
+    ret = FALSE;
   }
 
-  return TRUE;
+  if (result_str != buf) {
+    free(result_str);
+  }
+
+  return ret;
 }
 
 /**********************************************************************//**
@@ -1298,7 +2646,7 @@ bool dio_get_string_json(struct connection *pc, struct data_in *din,
                          char *dest, size_t max_dest_size)
 {
   if (pc->json_mode) {
-    return dio_get_string_json_internal(pc->json_packet, location,
+    return dio_get_string_json_internal(&pc->json_packet, location,
                                         dest, max_dest_size);
   } else {
     return dio_get_string_raw(din, dest, max_dest_size);
@@ -1321,7 +2669,7 @@ bool dio_get_estring_json(struct connection *pc, struct data_in *din,
     /* The encoded string has the same size limit as the decoded string. */
     escaped_value = fc_malloc(max_dest_size);
 
-    if (!dio_get_string_json_internal(pc->json_packet, location,
+    if (!dio_get_string_json_internal(&pc->json_packet, location,
                                       escaped_value, max_dest_size)) {
       /* dio_get_string_json() has logged this already. */
       return FALSE;
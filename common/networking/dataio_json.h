@@ -31,11 +31,47 @@ struct unit_order;
 struct worklist;
 struct requirement;
 
+#define JSON_OUT_MAX_DEPTH 8
+#define JSON_OUT_MAX_KEYS 256
+
+/* A step of the address of a location inside a JSON packet. */
+struct json_out_step {
+  bool elem;
+  union {
+    int number;
+    const char *name;
+  };
+};
+
+/* A JSON container whose text is not yet closed. */
+struct json_out_level {
+  struct json_out_step step;    /* Where it is in its parent. */
+  bool array;
+  int size;                     /* Arrays: number of elements. */
+  int next;                     /* Arrays: elements written so far. */
+  int first_key;                /* Objects: first key in keys[]. */
+};
+
+/* A packet is written as JSON text while the locations written to come
+ * in document order. Otherwise what was written so far is loaded into
+ * the jansson DOM, and the rest of the packet is written there. */
 struct json_data_out {
   struct raw_data_out raw;
-  json_t *json;
+  bool json;
+  json_t *dom;                  /* NULL while writing text. */
+  size_t start;                 /* Where the text starts in raw. */
+  int depth;
+  struct json_out_level level[JSON_OUT_MAX_DEPTH];
+  int nkeys;
+  const char *keys[JSON_OUT_MAX_KEYS];  /* Keys of the open objects. */
 };
 
+void dio_output_json_start(struct json_data_out *dout);
+void dio_output_json_finish(struct json_data_out *dout);
+
+bool dio_input_json_init(struct json_data_in *din, const char *text,
+                         int len);
+
 /* gets */
 bool dio_get_type_json(struct data_in *din, enum data_type type, int *dest)
     fc__attribute((nonnull (3)));
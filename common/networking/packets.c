@@ -360,6 +360,122 @@ int send_packet_data(struct connection *pc, unsigned char *data, int len,
   return result;
 }
 
+#ifdef FREECIV_SEND_MEMO
+/* The last encoding of each packet type, with the input it was made
+ * from. The encoding of a delta packet only depends on the packet, the
+ * state the connection had for it, the capability variant and the
+ * header layout, so it can be reused for the next connection when these
+ * are the same, e.g. for every global observer in a broadcast. */
+struct packet_send_memo {
+  bool valid;
+  int variant;
+  int different;
+  bool resend;
+  int header_length;
+  int header_type;
+  size_t size;
+  void *packet;
+  void *old;
+  size_t len;                   /* 0 when the packet was discarded. */
+  unsigned char data[MAX_LEN_PACKET];
+};
+
+static struct packet_send_memo *send_memos[PACKET_LAST];
+
+/**********************************************************************//**
+  Check whether the packet to send to pc was just encoded for the same
+  delta state. On a hit, the encoding is written to dout, or the packet
+  is to be discarded. On a miss, the input is remembered for
+  packet_send_memo_store(), which the caller must call once it has
+  encoded or discarded the packet.
+**************************************************************************/
+enum packet_send_memo_result
+packet_send_memo_check(const struct connection *pc, enum packet_type type,
+                       int variant, const void *packet, const void *old,
+                       size_t size, int different, bool resend,
+                       struct raw_data_out *dout)
+{
+  struct packet_send_memo *memo = send_memos[type];
+
+  if (NULL != memo && memo->valid
+      && memo->variant == variant
+      && memo->different == different
+      && memo->resend == resend
+      && memo->header_length == pc->packet_header.length
+      && memo->header_type == pc->packet_header.type
+      && memo->size == size
+      && 0 == memcmp(memo->packet, packet, size)
+      && 0 == memcmp(memo->old, old, size)) {
+    if (0 == memo->len) {
+      return PACKET_SEND_MEMO_DISCARD;
+    }
+
+    dio_output_rewind(dout);
+    dio_put_memory_raw(dout, memo->data, memo->len);
+
+    return PACKET_SEND_MEMO_REPLAY;
+  }
+
+  if (NULL == memo) {
+    memo = fc_calloc(1, sizeof(*memo));
+    send_memos[type] = memo;
+  }
+  if (memo->size != size) {
+    memo->packet = fc_realloc(memo->packet, size);
+    memo->old = fc_realloc(memo->old, size);
+    memo->size = size;
+  }
+
+  memo->valid = FALSE;
+  memo->variant = variant;
+  memo->different = different;
+  memo->resend = resend;
+  memo->header_length = pc->packet_header.length;
+  memo->header_type = pc->packet_header.type;
+  memcpy(memo->packet, packet, size);
+  memcpy(memo->old, old, size);
+
+  return PACKET_SEND_MEMO_MISS;
+}
+
+/**********************************************************************//**
+  Remember the encoding made after a miss of packet_send_memo_check().
+  dout is NULL if the packet was discarded.
+**************************************************************************/
+void packet_send_memo_store(enum packet_type type,
+                            const struct raw_data_out *dout)
+{
+  struct packet_send_memo *memo = send_memos[type];
+
+  fc_assert_ret(NULL != memo);
+
+  if (NULL == dout) {
+    memo->len = 0;
+  } else {
+    memo->len = dout->used;
+    fc_assert_ret(0 < memo->len && memo->len <= sizeof(memo->data));
+    memcpy(memo->data, dout->dest, memo->len);
+  }
+  memo->valid = TRUE;
+}
+
+/**********************************************************************//**
+  Free the send memos.
+**************************************************************************/
+static void packet_send_memos_free(void)
+{
+  int i;
+
+  for (i = 0; i < PACKET_LAST; i++) {
+    if (NULL != send_memos[i]) {
+      free(send_memos[i]->packet);
+      free(send_memos[i]->old);
+      FC_FREE(send_memos[i]);
+    }
+  }
+}
+#endif /* FREECIV_SEND_MEMO */
+
 /**********************************************************************//**
   Read and return a packet from the connection 'pc'. The type of the
   packet is written in 'ptype'. On error, the connection is closed and
@@ -465,32 +581,14 @@ void *get_packet_from_connection_raw(struct connection *pc,
 
     } while (error != Z_OK);
 
-    buffer->ndata -= whole_packet_len;
-    /* 
-     * Remove the packet with the compressed data and shift all the
-     * remaining data to the front. 
-     */
-    memmove(buffer->data, buffer->data + whole_packet_len, buffer->ndata);
-
-    if (buffer->ndata + decompressed_size > buffer->nsize) {
-      buffer->nsize += decompressed_size;
-      buffer->data = fc_realloc(buffer->data, buffer->nsize);
-    }
-
     /*
-     * Make place for the uncompressed data by moving the remaining
-     * data.
-     */
-    memmove(buffer->data + decompressed_size, buffer->data, buffer->ndata);
-
-    /* 
-     * Copy the uncompressed data.
+     * Replace the packet with the compressed data by the uncompressed
+     * data. This usually reuses the room in front of the remaining data.
      */
-    memcpy(buffer->data, decompressed, decompressed_size);
+    socket_packet_buffer_consume(buffer, whole_packet_len);
+    socket_packet_buffer_prepend(buffer, decompressed, decompressed_size);
 
     free(decompressed);
-
-    buffer->ndata += decompressed_size;
     
     log_compress("COMPRESS: decompressed %ld into %ld",
                  compressed_size, decompressed_size);
@@ -596,8 +694,7 @@ void remove_packet_from_buffer(struct socket_packet_buffer *buffer)
 
   dio_input_init(&din, buffer->data, buffer->ndata);
   dio_get_uint16_raw(&din, &len);
-  memmove(buffer->data, buffer->data + len, buffer->ndata - len);
-  buffer->ndata -= len;
+  socket_packet_buffer_consume(buffer, len);
   log_debug("remove_packet_from_buffer: remove %d; remaining %d",
             len, buffer->ndata);
 }
@@ -881,4 +978,7 @@ const struct packet_handlers *packet_handlers_get(const char *capability)
 void packets_deinit(void)
 {
   packet_handlers_free();
+#ifdef FREECIV_SEND_MEMO
+  packet_send_memos_free();
+#endif
 }
@@ -143,6 +143,28 @@ void packets_deinit(void);
 #include "packets_json.h"
 #else
 
+#ifdef FREECIV_DELTA_PROTOCOL
+/* Packets sent to several connections with the same delta state reuse
+ * the encoding done for the first one. */
+#define FREECIV_SEND_MEMO
+
+enum packet_send_memo_result {
+  PACKET_SEND_MEMO_MISS,        /* Encode the packet. */
+  PACKET_SEND_MEMO_DISCARD,     /* Nothing changed, do not send. */
+  PACKET_SEND_MEMO_REPLAY       /* Encoding copied to the output. */
+};
+
+struct raw_data_out;
+
+enum packet_send_memo_result
+packet_send_memo_check(const struct connection *pc, enum packet_type type,
+                       int variant, const void *packet, const void *old,
+                       size_t size, int different, bool resend,
+                       struct raw_data_out *dout);
+void packet_send_memo_store(enum packet_type type,
+                            const struct raw_data_out *dout);
+#endif /* FREECIV_DELTA_PROTOCOL */
+
 #define SEND_PACKET_START(packet_type) \
   unsigned char buffer[MAX_LEN_PACKET]; \
   struct raw_data_out dout; \
@@ -80,8 +80,6 @@ void *get_packet_from_connection_json(struct connection *pc,
   struct data_in din;
   void *data;
   void *(*receive_handler)(struct connection *);
-  json_error_t error;
-  json_t *pint;
 
   if (!pc->used) {
     return NULL;		/* connection was closed, stop reading */
@@ -118,43 +116,43 @@ void *get_packet_from_connection_json(struct connection *pc,
    * connection. If it is a valid JSON packet, the connection is switched
    * to JSON mode.
    */
-  if (is_server() && pc->server.last_request_id_seen == 0) {
-    /* Try to parse JSON packet. Note that json string has '\0' */
-    pc->json_packet = json_loadb((char*)pc->buffer->data + 2, whole_packet_len - 3, 0, &error);
-
-    /* Set the connection mode */
-    pc->json_mode = (pc->json_packet != NULL);
-  }
-
-  if (pc->json_mode) {
-    /* Parse JSON packet. Note that json string has '\0' */
-    pc->json_packet = json_loadb((char*)pc->buffer->data + 2, whole_packet_len - 3, 0, &error);
-
-    /* Log errors before we scrap the data */
-    if (!pc->json_packet) {
-      log_error("ERROR: Unable to parse packet: %s", pc->buffer->data + 2);
-      log_error("%s", error.text);
+  if (pc->json_mode
+      || (is_server() && pc->server.last_request_id_seen == 0)) {
+    /* The JSON text is followed by '\0'. It is read in place, and
+     * removed from the buffer once the packet has been received. */
+    bool parsed = dio_input_json_init(&pc->json_packet,
+                                      (char *) pc->buffer->data + 2,
+                                      whole_packet_len - 3);
+
+    if (is_server() && pc->server.last_request_id_seen == 0) {
+      /* Set the connection mode */
+      pc->json_mode = parsed;
     }
 
-    log_packet_json("Json in: %s", pc->buffer->data + 2);
+    if (pc->json_mode && !parsed) {
+      /* Log errors before we scrap the data */
+      log_error("ERROR: Unable to parse packet: %s", pc->buffer->data + 2);
+      log_error("%s", pc->json_packet.error);
 
-    /* Shift remaining data to the front */
-    pc->buffer->ndata -= whole_packet_len;
-    memmove(pc->buffer->data, pc->buffer->data + whole_packet_len, pc->buffer->ndata);
+      /* Remove the packet from the buffer */
+      socket_packet_buffer_consume(pc->buffer, whole_packet_len);
 
-    if (!pc->json_packet) {
       return NULL;
     }
+  }
 
-    pint = json_object_get(pc->json_packet, "pid");
+  if (pc->json_mode) {
+    struct plocation pid_addr = { .kind = PADR_FIELD, .name = "pid" };
 
-    if (!pint) {
+    log_packet_json("Json in: %s", pc->buffer->data + 2);
+
+    if (!dio_get_uint16_json(pc, &din, &pid_addr, &utype.itype)) {
       log_error("ERROR: Unable to get packet type.");
+      socket_packet_buffer_consume(pc->buffer, whole_packet_len);
       return NULL;
     }
 
-    json_int_t packet_type = json_integer_value(pint);
-    utype.type = packet_type;
+    utype.type = utype.itype;
   } else {
     dio_get_type_raw(&din, pc->packet_header.type, &utype.itype);
     utype.type = utype.itype;
@@ -166,6 +164,9 @@ void *get_packet_from_connection_json(struct connection *pc,
     log_verbose("Received unsupported packet type %d (%s). The connection "
                 "will be closed now.",
                 utype.type, packet_name(utype.type));
+    if (pc->json_mode) {
+      socket_packet_buffer_consume(pc->buffer, whole_packet_len);
+    }
     connection_close(pc, _("unsupported packet type"));
     return NULL;
   }
@@ -26,18 +26,16 @@ void *get_packet_from_connection_json(struct connection *pc,
 
 #define SEND_PACKET_START(packet_type)                                  \
   unsigned char buffer[MAX_LEN_PACKET * 5];                             \
-  struct plocation *pid_addr;                                           \
-  char *json_buffer = NULL;                                             \
   struct json_data_out dout;                                            \
   dio_output_init(&(dout.raw), buffer, sizeof(buffer));                 \
-  if (pc->json_mode) {                                                      \
-    dout.json = json_object();                                          \
+  if (pc->json_mode) {                                                  \
+    struct plocation pid_addr = { .kind = PADR_FIELD, .name = "pid" };  \
+                                                                        \
     dio_put_uint16_raw(&(dout.raw), 0);                                 \
-    pid_addr = plocation_field_new("pid");                              \
-    dio_put_uint8_json(&dout, pid_addr, packet_type);                   \
-    FC_FREE(pid_addr);                                                  \
+    dio_output_json_start(&dout);                                       \
+    dio_put_uint8_json(&dout, &pid_addr, packet_type);                  \
   } else {                                                              \
-    dout.json = NULL;                                                   \
+    dout.json = FALSE;                                                  \
     dio_put_type_raw(&dout.raw, pc->packet_header.length, 0);           \
     dio_put_type_raw(&dout.raw, pc->packet_header.type, packet_type);   \
   }
@@ -45,18 +43,15 @@ void *get_packet_from_connection_json(struct connection *pc,
 #define SEND_PACKET_END(packet_type) \
   {                                                                     \
     size_t size;                                                        \
-    if (pc->json_mode) {                                                    \
-      json_buffer = json_dumps(dout.json, JSON_COMPACT | JSON_ENSURE_ASCII); \
-      if (json_buffer) {                                                \
-        dio_put_string_raw(&(dout.raw), json_buffer);                   \
-        log_packet_json("Json out: %s", json_buffer);                   \
+    if (pc->json_mode) {                                                \
+      dio_output_json_finish(&dout);                                    \
+      if (!dout.raw.too_short) {                                        \
+        log_packet_json("Json out: %s", (const char *) buffer + 2);     \
       }                                                                 \
       size = dio_output_used(&dout.raw);                                \
                                                                         \
       dio_output_rewind(&(dout.raw));                                   \
       dio_put_uint16_raw(&(dout.raw), size);                            \
-      free(json_buffer);                                                \
-      json_decref(dout.json);                                           \
     } else {                                                            \
       size = dio_output_used(&dout.raw);                                \
                                                                         \
@@ -85,7 +80,7 @@ void *get_packet_from_connection_json(struct connection *pc,
 
 #define RECEIVE_PACKET_END(result) \
   if (pc->json_mode) { \
-    json_decref(pc->json_packet);        \
+    remove_packet_from_buffer(pc->buffer); \
     result = fc_malloc(sizeof(*result)); \
     *result = packet_buf; \
     return result; \
@@ -15,6 +15,8 @@
 #include <fc_config.h>
 #endif
 
+#include <string.h>
+
 /* utility */
 #include "fcintl.h"
 #include "log.h"
@@ -25,6 +27,7 @@
 /* common */
 #include "ai.h"
 #include "city.h"
+#include "effects.h"
 #include "fc_interface.h"
 #include "featured_text.h"
 #include "game.h"
@@ -484,6 +487,7 @@ struct player *player_new(struct player_slot *pslot)
   pplayer = fc_calloc(1, sizeof(*pplayer));
   pplayer->slot = pslot;
   pslot->player = pplayer;
+  effect_value_cache_invalidate();
 
   pplayer->diplstates = fc_calloc(player_slot_count(),
                                   sizeof(*pplayer->diplstates));
@@ -710,6 +714,7 @@ void player_destroy(struct player *pplayer)
 
   pslot = pplayer->slot;
   fc_assert(pslot->player == pplayer);
+  effect_value_cache_invalidate();
 
   /* Remove all that is game-dependent in the player structure. */
   player_clear(pplayer, TRUE);
@@ -1239,6 +1244,113 @@ int player_get_expected_income(const struct player *pplayer)
   return income;
 }
 
+/*******************************************************************//**
+  Reset the running counts over the player's tile_known and cities.
+  Server only; tile_known must be empty.
+***********************************************************************/
+void player_known_counts_reset(struct player *pplayer)
+{
+  pplayer->server.known_tiles = 0;
+  pplayer->server.known_continents = 0;
+  pplayer->server.known_continents_stamp = -1;
+  pplayer->server.largest_city_size = -1;
+}
+
+/*******************************************************************//**
+  Free the per continent known tile counts of the player.
+***********************************************************************/
+void player_known_counts_free(struct player *pplayer)
+{
+  if (pplayer->server.known_continent_tiles != NULL) {
+    free(pplayer->server.known_continent_tiles);
+    pplayer->server.known_continent_tiles = NULL;
+  }
+  pplayer->server.known_continents_stamp = -1;
+}
+
+/*******************************************************************//**
+  Update the running counts after the known status of ptile changed
+  for pplayer.  Must be called once per actual change.
+***********************************************************************/
+void player_known_tile_changed(struct player *pplayer,
+                               const struct tile *ptile, bool known)
+{
+  Continent_id cont = tile_continent(ptile);
+
+  pplayer->server.known_tiles += (known ? 1 : -1);
+
+  if (pplayer->server.known_continents_stamp
+      != wld.map.server.continents_stamp) {
+    /* Recounted on next use anyway. */
+    return;
+  }
+
+  if (cont > 0 && cont <= wld.map.num_continents) {
+    int *count = &pplayer->server.known_continent_tiles[cont];
+
+    if (known) {
+      if ((*count)++ == 0) {
+        pplayer->server.known_continents++;
+      }
+    } else if (--(*count) == 0) {
+      pplayer->server.known_continents--;
+    }
+  }
+}
+
+/*******************************************************************//**
+  Return the number of continents the player knows at least one tile of.
+  The per continent counts are rebuilt only after continent numbers
+  have been reassigned.
+***********************************************************************/
+int player_known_continents(struct player *pplayer)
+{
+  if (pplayer->server.known_continents_stamp
+      != wld.map.server.continents_stamp) {
+    int *counts = fc_realloc(pplayer->server.known_continent_tiles,
+                             (wld.map.num_continents + 1)
+                             * sizeof(*counts));
+
+    memset(counts, 0, (wld.map.num_continents + 1) * sizeof(*counts));
+    pplayer->server.known_continent_tiles = counts;
+    pplayer->server.known_continents = 0;
+
+    whole_map_iterate(&(wld.map), ptile) {
+      Continent_id cont = tile_continent(ptile);
+
+      if (cont > 0 && cont <= wld.map.num_continents
+          && dbv_isset(&pplayer->tile_known, tile_index(ptile))
+          && counts[cont]++ == 0) {
+        pplayer->server.known_continents++;
+      }
+    } whole_map_iterate_end;
+
+    pplayer->server.known_continents_stamp
+      = wld.map.server.continents_stamp;
+  }
+
+  return pplayer->server.known_continents;
+}
+
+/*******************************************************************//**
+  Return the size of the player's largest city, recounting it only when
+  a city that may have been the largest one shrank or changed hands.
+***********************************************************************/
+int player_largest_city_size(struct player *pplayer)
+{
+  if (pplayer->server.largest_city_size < 0) {
+    int largest = 0;
+
+    city_list_iterate(pplayer->cities, pcity) {
+      largest = MAX(largest, city_size_get(pcity));
+    } city_list_iterate_end;
+
+    pplayer->server.largest_city_size = largest;
+  }
+
+  return pplayer->server.largest_city_size;
+}
+
 /*******************************************************************//**
   Returns TRUE iff the player knows at least one tech which has the
   given flag.
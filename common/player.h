@@ -338,6 +338,16 @@ struct player {
       int huts; /* How many huts this player has found */
 
       int bulbs_last_turn; /* Number of bulbs researched last turn only. */
+
+      /* Running counts over tile_known and the player's cities, kept up
+       * to date where those change so that achievements can be checked
+       * without scanning the map. */
+      int known_tiles;
+      int *known_continent_tiles; /* Known tiles by continent id. */
+      int known_continents;       /* Continents with any known tile. */
+      int known_continents_stamp; /* wld.map.server.continents_stamp the
+                                   * above were counted for, or -1. */
+      int largest_city_size;      /* -1 when it has to be recounted. */
     } server;
 
     struct {
@@ -440,6 +450,13 @@ int num_known_tech_with_flag(const struct player *pplayer,
 			     enum tech_flag_id flag);
 int player_get_expected_income(const struct player *pplayer);
 
+void player_known_counts_reset(struct player *pplayer);
+void player_known_counts_free(struct player *pplayer);
+void player_known_tile_changed(struct player *pplayer,
+                               const struct tile *ptile, bool known);
+int player_known_continents(struct player *pplayer);
+int player_largest_city_size(struct player *pplayer);
+
 struct city *player_capital(const struct player *pplayer);
 
 const char *love_text(const int love);
@@ -23,6 +23,7 @@
 
 /* common */
 #include "fc_types.h"
+#include "effects.h"
 #include "game.h"
 #include "player.h"
 #include "name_translation.h"
@@ -56,6 +57,18 @@ static struct name_translation advance_unknown_name = NAME_INIT;
 static struct strvec *future_rule_name;
 static struct strvec *future_name_translation;
 
+/* Static prerequisite closures of the tech tree, see
+ * research_tree_update(). */
+static struct {
+  int num_techs;
+  struct advance *require[A_LAST][AR_SIZE]; /* What they were computed for */
+  bv_techs reqs[A_LAST];       /* advance_req_iterate() of each tech */
+  bv_techs roots[A_LAST];      /* advance_root_req_iterate() of each tech */
+  bv_techs self_roots[A_LAST]; /* Roots of each tech requiring themselves */
+  bool roots_valid[A_LAST];    /* Other roots have valid requirements */
+  bool reqs_valid[A_LAST];     /* All direct requirements are valid */
+} research_tree = { .num_techs = -1 };
+
 /************************************************************************//**
   Initializes all player research structure.
 ****************************************************************************/
@@ -394,14 +407,87 @@ research_allowed(const struct research *presearch,
 #define research_may_become_allowed(presearch, tech)                      \
   research_allowed(presearch, tech, reqs_may_activate)
 
+/************************************************************************//**
+  Refresh the prerequisite closures of the tech tree if it changed since
+  they were computed.  Cheap when nothing changed: only the requirement
+  pointers are compared.
+
+  Helper for research_update().
+****************************************************************************/
+static void research_tree_update(void)
+{
+  bool changed = (research_tree.num_techs != advance_count());
+
+  advance_index_iterate(A_NONE, i) {
+    enum tech_req req;
+
+    for (req = 0; req < AR_SIZE && !changed; req++) {
+      changed = (research_tree.require[i][req]
+                 != advance_requires(advance_by_number(i), req));
+    }
+  } advance_index_iterate_end;
+
+  if (!changed) {
+    return;
+  }
+
+  research_tree.num_techs = advance_count();
+  advance_index_iterate(A_NONE, i) {
+    const struct advance *padvance = valid_advance_by_number(i);
+    enum tech_req req;
+
+    for (req = 0; req < AR_SIZE; req++) {
+      research_tree.require[i][req]
+        = advance_requires(advance_by_number(i), req);
+    }
+
+    BV_CLR_ALL(research_tree.reqs[i]);
+    BV_CLR_ALL(research_tree.roots[i]);
+    BV_CLR_ALL(research_tree.self_roots[i]);
+    research_tree.roots_valid[i] = TRUE;
+    research_tree.reqs_valid[i] = TRUE;
+
+    for (req = 0; req < AR_SIZE; req++) {
+      if (valid_advance_by_number(advance_required(i, req)) == NULL) {
+        research_tree.reqs_valid[i] = FALSE;
+      }
+    }
+
+    if (padvance == NULL || i == A_NONE) {
+      continue;
+    }
+
+    advance_req_iterate(padvance, preq) {
+      BV_SET(research_tree.reqs[i], advance_number(preq));
+    } advance_req_iterate_end;
+
+    advance_root_req_iterate(padvance, proot) {
+      BV_SET(research_tree.roots[i], advance_number(proot));
+      if (advance_requires(proot, AR_ROOT) == proot) {
+        BV_SET(research_tree.self_roots[i], advance_number(proot));
+      } else {
+        for (req = 0; req < AR_SIZE; req++) {
+          if (valid_advance(advance_requires(proot, req)) == NULL) {
+            research_tree.roots_valid[i] = FALSE;
+          }
+        }
+      }
+    } advance_root_req_iterate_end;
+  } advance_index_iterate_end;
+}
+
 /************************************************************************//**
   Returns TRUE iff the given tech is ever reachable by the players sharing
   the research as far as research_reqs are concerned.
 
+  may_allow[] caches research_may_become_allowed() per tech for the
+  duration of one research_update(): -1 when not evaluated yet.
+
   Helper for research_get_reachable().
 ****************************************************************************/
 static bool research_get_reachable_rreqs(const struct research *presearch,
-                                         Tech_type_id tech)
+                                         Tech_type_id tech,
+                                         signed char *may_allow)
 {
   bv_techs done;
   Tech_type_id techs[game.control.num_tech_types];
@@ -418,13 +504,18 @@ static bool research_get_reachable_rreqs(const struct research *presearch,
   /* Check that all recursive requirements have their research_reqs
    * in order. */
   for (i = 0; i < techs_num; i++) {
-    if (presearch->inventions[techs[i]].state == TECH_KNOWN) {
+    Tech_type_id t = techs[i];
+
+    if (presearch->inventions[t].state == TECH_KNOWN) {
       /* This tech is already reached. What is required to research it and
        * the techs it depends on is therefore irrelevant. */
       continue;
     }
 
-    if (!research_may_become_allowed(presearch, techs[i])) {
+    if (may_allow[t] < 0) {
+      may_allow[t] = research_may_become_allowed(presearch, t);
+    }
+    if (!may_allow[t]) {
       /* It will always be illegal to start researching this tech because
        * of unchanging requirements. Since it isn't already known and can't
        * be researched it must be unreachable. */
@@ -432,12 +523,13 @@ static bool research_get_reachable_rreqs(const struct research *presearch,
     }
 
     /* Check if required techs are research_reqs reachable. */
+    if (!research_tree.reqs_valid[t]) {
+      return FALSE;
+    }
     for (req = 0; req < AR_SIZE; req++) {
-      Tech_type_id req_tech = advance_required(techs[i], req);
+      Tech_type_id req_tech = advance_required(t, req);
 
-      if (valid_advance_by_number(req_tech) == NULL) {
-        return FALSE;
-      } else if (!BV_ISSET(done, req_tech)) {
+      if (!BV_ISSET(done, req_tech)) {
         fc_assert(techs_num < ARRAY_SIZE(techs));
         techs[techs_num] = req_tech;
         techs_num++;
@@ -452,86 +544,79 @@ static bool research_get_reachable_rreqs(const struct research *presearch,
 
 /************************************************************************//**
   Returns TRUE iff the given tech is ever reachable by the players sharing
-  the research by checking tech tree limitations.
+  the research by checking tech tree limitations.  'unknown' holds the
+  techs the research doesn't know.
 
   Helper for research_update().
 ****************************************************************************/
 static bool research_get_reachable(const struct research *presearch,
-                                   Tech_type_id tech)
+                                   Tech_type_id tech,
+                                   const bv_techs *unknown,
+                                   signed char *may_allow)
 {
-  if (valid_advance_by_number(tech) == NULL) {
+  if (valid_advance_by_number(tech) == NULL
+      || !research_tree.roots_valid[tech]) {
     return FALSE;
-  } else {
-    advance_root_req_iterate(advance_by_number(tech), proot) {
-      if (advance_requires(proot, AR_ROOT) == proot) {
-        /* This tech requires itself; it can only be reached by special
-         * means (init_techs, lua script, ...).
-         * If you already know it, you can "reach" it; if not, not. (This
-         * case is needed for descendants of this tech.) */
-        if (presearch->inventions[advance_number(proot)].state != TECH_KNOWN) {
-          return FALSE;
-        }
-      } else {
-        enum tech_req req;
-
-        for (req = 0; req < AR_SIZE; req++) {
-          if (valid_advance(advance_requires(proot, req)) == NULL) {
-            return FALSE;
-          }
-        }
-      }
-    } advance_root_req_iterate_end;
   }
 
-  /* Check research reqs reachability. */
-  if (!research_get_reachable_rreqs(presearch, tech)) {
+  /* A tech requiring itself as root can only be reached by special
+   * means (init_techs, lua script, ...).  If you already know it, you
+   * can "reach" it; if not, not. (This case is needed for descendants
+   * of this tech.) */
+  if (BV_CHECK_MASK(research_tree.self_roots[tech], *unknown)) {
     return FALSE;
   }
 
-  return TRUE;
-}
-
-/************************************************************************//**
-  Returns TRUE iff the players sharing 'presearch' already have got the
-  knowledge of all root requirement technologies for 'tech' (without which
-  it's impossible to gain 'tech').
-
-  Helper for research_update().
-****************************************************************************/
-static bool research_get_root_reqs_known(const struct research *presearch,
-                                         Tech_type_id tech)
-{
-  advance_root_req_iterate(advance_by_number(tech), proot) {
-    if (presearch->inventions[advance_number(proot)].state != TECH_KNOWN) {
-      return FALSE;
-    }
-  } advance_root_req_iterate_end;
-
-  return TRUE;
+  /* Check research reqs reachability. */
+  return research_get_reachable_rreqs(presearch, tech, may_allow);
 }
 
 /************************************************************************//**
   Mark as TECH_PREREQS_KNOWN each tech which is available, not known and
   which has all requirements fullfiled.
 
+  The prerequisite closures of every tech are computed once per tech tree
+  (see research_tree_update()), and the state dependent inputs (cost and
+  research_reqs of a tech) are evaluated at most once per tech here
+  rather than once for every tech requiring it.
+
   Recalculate presearch->num_known_tech_with_flag
   Should always be called after research_invention_set().
 ****************************************************************************/
 void research_update(struct research *presearch)
 {
   enum tech_flag_id flag;
+  bv_techs known, unknown;
+  signed char may_allow[A_LAST];
+  int bulbs[A_LAST];
+  bool civ1civ2 = (game.info.tech_cost_style == TECH_COST_CIV1CIV2);
   int techs_researched;
 
+  research_tree_update();
+  effect_value_cache_invalidate();
+
+  BV_CLR_ALL(known);
+  BV_SET_ALL(unknown);
+  advance_index_iterate(A_NONE, i) {
+    if (presearch->inventions[i].state == TECH_KNOWN) {
+      BV_SET(known, i);
+      BV_CLR(unknown, i);
+    }
+    may_allow[i] = -1;
+    bulbs[i] = -1;
+  } advance_index_iterate_end;
+
   advance_index_iterate(A_FIRST, i) {
     enum tech_state state = presearch->inventions[i].state;
-    bool root_reqs_known = TRUE;
-    bool reachable = research_get_reachable(presearch, i);
+    bool root_reqs_known;
+    bool reachable = research_get_reachable(presearch, i, &unknown,
+                                            may_allow);
 
     /* Finding if the root reqs of an unreachable tech isn't redundant.
      * A tech can be unreachable via research but have known root reqs
      * because of unfilfilled research_reqs. Unfulfilled research_reqs
      * doesn't prevent the player from aquiring the tech by other means. */
-    root_reqs_known = research_get_root_reqs_known(presearch, i);
+    root_reqs_known = !BV_CHECK_MASK(research_tree.roots[i], unknown);
 
     if (reachable) {
       if (state != TECH_KNOWN) {
@@ -560,24 +645,38 @@ void research_update(struct research *presearch)
       continue;
     }
 
-    techs_researched = presearch->techs_researched;
-    advance_req_iterate(valid_advance_by_number(i), preq) {
-      Tech_type_id j = advance_number(preq);
+    if (civ1civ2) {
+      /* The cost of each tech depends on how many were counted before
+       * it, so follow the order of advance_req_iterate(). */
+      techs_researched = presearch->techs_researched;
+      advance_req_iterate(valid_advance_by_number(i), preq) {
+        Tech_type_id j = advance_number(preq);
 
-      if (TECH_KNOWN == research_invention_state(presearch, j)) {
-        continue;
-      }
+        if (TECH_KNOWN == research_invention_state(presearch, j)) {
+          continue;
+        }
 
-      BV_SET(presearch->inventions[i].required_techs, j);
-      presearch->inventions[i].num_required_techs++;
-      presearch->inventions[i].bulbs_required +=
-          research_total_bulbs_required(presearch, j, FALSE);
-      /* This is needed to get a correct result for the
-       * research_total_bulbs_required() call when
-       * game.info.game.info.tech_cost_style is TECH_COST_CIV1CIV2. */
-      presearch->techs_researched++;
-    } advance_req_iterate_end;
-    presearch->techs_researched = techs_researched;
+        BV_SET(presearch->inventions[i].required_techs, j);
+        presearch->inventions[i].num_required_techs++;
+        presearch->inventions[i].bulbs_required +=
+            research_total_bulbs_required(presearch, j, FALSE);
+        presearch->techs_researched++;
+      } advance_req_iterate_end;
+      presearch->techs_researched = techs_researched;
+      continue;
+    }
+
+    presearch->inventions[i].required_techs = research_tree.reqs[i];
+    BV_CLR_ALL_FROM(presearch->inventions[i].required_techs, known);
+    advance_index_iterate(A_FIRST, j) {
+      if (BV_ISSET(presearch->inventions[i].required_techs, j)) {
+        if (bulbs[j] < 0) {
+          bulbs[j] = research_total_bulbs_required(presearch, j, FALSE);
+        }
+        presearch->inventions[i].num_required_techs++;
+        presearch->inventions[i].bulbs_required += bulbs[j];
+      }
+    } advance_index_iterate_end;
   } advance_index_iterate_end;
 
 #ifdef FREECIV_DEBUG
@@ -663,6 +762,7 @@ enum tech_state research_invention_set(struct research *presearch,
       game.info.global_advance_count++;
     }
   }
+  effect_value_cache_invalidate();
 
   return old;
 }
@@ -68,6 +68,7 @@ struct tile {
 /* 'struct tile_list' and related functions. */
 #define SPECLIST_TAG tile
 #define SPECLIST_TYPE struct tile
+#define SPECLIST_NO_MUTEX
 #include "speclist.h"
 #define tile_list_iterate(tile_list, ptile)                                 \
   TYPED_LIST_ITERATE(struct tile, tile_list, ptile)
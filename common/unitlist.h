@@ -25,6 +25,7 @@ extern "C" {
 /* get 'struct unit_list' and related functions: */
 #define SPECLIST_TAG unit
 #define SPECLIST_TYPE struct unit
+#define SPECLIST_NO_MUTEX
 #include "speclist.h"
 
 #define unit_list_iterate(unitlist, punit) \
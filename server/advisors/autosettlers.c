@@ -299,6 +299,54 @@ adv_want adv_settlers_road_bonus(struct tile *ptile, struct road_type *proad)
   return bonus;
 }
 
+/* Best tile improvement found so far by settler_evaluate_improvements()
+ * or settler_evaluate_tile(). */
+struct settler_choice {
+  adv_want value;       /* Total or improvement value, see improve_worked */
+  int old_value;        /* Current value of the chosen tile; compared if
+                         * value is equal. Not initialized to zero, so that
+                         * value = 0 activities are not chosen. */
+  int extra;
+  bool improve_worked;
+  int delay;
+  enum unit_activity act;
+  struct extra_type *target;
+  struct tile *ptile;
+};
+
+/**********************************************************************//**
+  Initialize settler choice to "nothing found yet".
+**************************************************************************/
+static void settler_choice_init(struct settler_choice *best)
+{
+  best->value = 0;
+  best->old_value = 9999;
+  best->extra = 0;
+  best->improve_worked = FALSE;
+  best->delay = 0;
+  best->act = ACTIVITY_IDLE;
+  best->target = NULL;
+  best->ptile = NULL;
+}
+
+/**********************************************************************//**
+  Return the want of the settler choice, comparable between choices.
+**************************************************************************/
+static adv_want settler_choice_want(const struct settler_choice *best)
+{
+  adv_want want = best->value;
+
+  if (!best->improve_worked) {
+    /* value contains total value of improved tile. Check amount of
+     * improvement instead. */
+    want = amortize((want - best->old_value + best->extra) * WORKER_FACTOR,
+                    best->delay);
+  }
+  want /= WORKER_FACTOR;
+
+  return MAX(want, 0); /* sanity */
+}
+
 /**********************************************************************//**
   Compares the best known tile improvement action with improving ptile
   with activity act.  Calculates the value of improving the tile by
@@ -311,15 +359,8 @@ static void consider_settler_action(const struct player *pplayer,
                                     adv_want extra,
                                     int new_tile_value, int old_tile_value,
                                     bool in_use, int delay,
-                                    adv_want *best_value,
-                                    int *best_old_tile_value,
-                                    int *best_extra,
-                                    bool *improve_worked,
-                                    int *best_delay,
-                                    enum unit_activity *best_act,
-                                    struct extra_type **best_target,
-                                    struct tile **best_tile,
-                                    struct tile *ptile)
+                                    struct tile *ptile,
+                                    struct settler_choice *best)
 {
   bool improves;
   int total_value = 0, base_value = 0;
@@ -341,19 +382,20 @@ static void consider_settler_action(const struct player *pplayer,
 
   /* find the present value of the future benefit of this action */
   if (improves || extra > 0) {
-    if (!(*improve_worked) && !in_use) {
+    if (!best->improve_worked && !in_use) {
       /* Going to improve tile that is not yet in use.
        * Getting the best possible total for next citizen to work on is more
        * important than amount tile gets improved. */
-      if (improves && (new_tile_value > *best_value
-                       || (new_tile_value == *best_value && old_tile_value < *best_old_tile_value))) {
-        *best_value = new_tile_value;
-        *best_old_tile_value = old_tile_value;
-        *best_extra = extra;
-        *best_act = act;
-        *best_target = target;
-        *best_tile = ptile;
-        *best_delay = delay;
+      if (improves && (new_tile_value > best->value
+                       || (new_tile_value == best->value
+                           && old_tile_value < best->old_value))) {
+        best->value = new_tile_value;
+        best->old_value = old_tile_value;
+        best->extra = extra;
+        best->act = act;
+        best->target = target;
+        best->ptile = ptile;
+        best->delay = delay;
       }
 
       return;
@@ -372,31 +414,32 @@ static void consider_settler_action(const struct player *pplayer,
     /* use factor to prevent rounding errors */
     total_value = amortize(total_value, delay);
 
-    if (*improve_worked) {
-      old_improvement_value = *best_value;
+    if (best->improve_worked) {
+      old_improvement_value = best->value;
     } else {
-      /* Convert old best_value to improvement value compatible with in_use
+      /* Convert old best value to improvement value compatible with in_use
        * tile value */
-      old_improvement_value = amortize((*best_value - *best_old_tile_value) * WORKER_FACTOR / 2,
-                                       *best_delay);
+      old_improvement_value = amortize((best->value - best->old_value)
+                                       * WORKER_FACTOR / 2,
+                                       best->delay);
     }
 
     if (total_value > old_improvement_value
         || (total_value == old_improvement_value
-            && old_tile_value > *best_old_tile_value)) {
+            && old_tile_value > best->old_value)) {
       if (in_use) {
-        *best_value = total_value;
-        *improve_worked = TRUE;
+        best->value = total_value;
+        best->improve_worked = TRUE;
       } else {
-        *best_value = new_tile_value;
-        *improve_worked = FALSE;
+        best->value = new_tile_value;
+        best->improve_worked = FALSE;
       }
-      *best_old_tile_value = old_tile_value;
-      *best_extra = extra;
-      *best_act = act;
-      *best_target = target;
-      *best_tile = ptile;
-      *best_delay = delay;
+      best->old_value = old_tile_value;
+      best->extra = extra;
+      best->act = act;
+      best->target = target;
+      best->ptile = ptile;
+      best->delay = delay;
     }
   }
 }
@@ -417,6 +460,278 @@ autosettler_tile_behavior(const struct tile *ptile,
   return TB_NORMAL;
 }
 
+/**********************************************************************//**
+  Can punit consider working on city tile ptile at all?
+**************************************************************************/
+static bool settler_can_consider_tile(const struct player *pplayer,
+                                      struct unit *punit,
+                                      const struct city *pcity,
+                                      struct tile *ptile)
+{
+  if (tile_worked(ptile) != pcity && !city_can_work_tile(pcity, ptile)) {
+    /* Don't risk bothering with this tile. */
+    return FALSE;
+  }
+
+  if (!adv_settler_safe_tile(pplayer, punit, ptile)) {
+    /* Too dangerous place */
+    return FALSE;
+  }
+
+  /* Do not go to tiles that already have workers there. */
+  unit_list_iterate(ptile->units, aunit) {
+    if (unit_owner(aunit) == pplayer
+        && aunit->id != punit->id
+        && unit_has_type_flag(aunit, UTYF_SETTLERS)) {
+      return FALSE;
+    }
+  } unit_list_iterate_end;
+
+  return TRUE;
+}
+
+/**********************************************************************//**
+  Consider all the activities punit could do at city tile ptile, reached
+  at position pos, and update best accordingly.
+**************************************************************************/
+static void settler_evaluate_tile(struct unit *punit, struct city *pcity,
+                                  struct tile *ptile, int cindex,
+                                  const struct pf_position *pos,
+                                  bool omniscient,
+                                  struct settler_choice *best)
+{
+  const struct player *pplayer = unit_owner(punit);
+  bool in_use = (tile_worked(ptile) == pcity);
+  int oldv = city_tile_value(pcity, ptile, 0, 0);
+  int turns;
+
+  /* Now, consider various activities... */
+  as_transform_action_iterate(act) {
+    struct extra_type *target = NULL;
+    enum extra_cause cause =
+        activity_to_extra_cause(action_id_get_activity(act));
+    enum extra_rmcause rmcause =
+        activity_to_extra_rmcause(action_id_get_activity(act));
+
+    if (cause != EC_NONE) {
+      target = next_extra_for_tile(ptile, cause, pplayer,
+                                   punit);
+    } else if (rmcause != ERM_NONE) {
+      target = prev_extra_in_tile(ptile, rmcause, pplayer,
+                                  punit);
+    }
+
+    if (adv_city_worker_act_get(pcity, cindex,
+                                action_id_get_activity(act)) >= 0
+        && action_prob_possible(
+          action_speculate_unit_on_tile(act,
+                                        punit, unit_home(punit),
+                                        ptile,
+                                        omniscient,
+                                        ptile, target))) {
+      int base_value =
+          adv_city_worker_act_get(pcity, cindex,
+                                  action_id_get_activity(act));
+
+      turns = pos->turn
+          + get_turns_for_activity_at(punit,
+                                      action_id_get_activity(act),
+                                      ptile, target);
+      if (pos->moves_left == 0) {
+        /* We need moves left to begin activity immediately. */
+        turns++;
+      }
+
+      consider_settler_action(pplayer,
+                              action_id_get_activity(act),
+                              target, 0.0, base_value,
+                              oldv, in_use, turns, ptile, best);
+
+    } /* endif: can the worker perform this action */
+  } as_transform_action_iterate_end;
+
+  extra_type_iterate(pextra) {
+    enum unit_activity act = ACTIVITY_LAST;
+    enum unit_activity eval_act = ACTIVITY_LAST;
+    int base_value;
+    bool removing = tile_has_extra(ptile, pextra);
+
+    if (removing) {
+      as_rmextra_action_iterate(try_act) {
+        struct action *taction = action_by_number(try_act);
+        if (is_extra_removed_by_action(pextra, taction)) {
+          /* We do not even evaluate actions we can't do.
+           * Removal is not considered prerequisite for anything */
+          if (action_prob_possible(
+                action_speculate_unit_on_tile(try_act,
+                                              punit,
+                                              unit_home(punit),
+                                              ptile,
+                                              omniscient,
+                                              ptile, pextra))) {
+            act = action_get_activity(taction);
+            eval_act = action_get_activity(taction);
+            break;
+          }
+        }
+      } as_rmextra_action_iterate_end;
+    } else {
+      as_extra_action_iterate(try_act) {
+        struct action *taction = action_by_number(try_act);
+        if (is_extra_caused_by_action(pextra, taction)) {
+          eval_act = action_id_get_activity(try_act);
+          if (action_prob_possible(
+                action_speculate_unit_on_tile(try_act,
+                                              punit,
+                                              unit_home(punit),
+                                              ptile,
+                                              omniscient,
+                                              ptile, pextra))) {
+            act = action_get_activity(taction);
+            break;
+          }
+        }
+      } as_extra_action_iterate_end;
+    }
+
+    if (eval_act == ACTIVITY_LAST) {
+      /* No activity can provide (or remove) the extra */
+      continue;
+    }
+
+    if (removing) {
+      base_value = adv_city_worker_rmextra_get(pcity, cindex, pextra);
+    } else {
+      base_value = adv_city_worker_extra_get(pcity, cindex, pextra);
+    }
+
+    if (base_value >= 0) {
+      adv_want extra;
+      struct road_type *proad;
+
+      turns = pos->turn + get_turns_for_activity_at(punit, eval_act,
+                                                    ptile, pextra);
+      if (pos->moves_left == 0) {
+        /* We need moves left to begin activity immediately. */
+        turns++;
+      }
+
+      proad = extra_road_get(pextra);
+
+      if (proad != NULL && road_provides_move_bonus(proad)) {
+        int mc_multiplier = 1;
+        int mc_divisor = 1;
+        int old_move_cost = tile_terrain(ptile)->movement_cost * SINGLE_MOVE;
+
+        /* Here 'old' means actually 'without the evaluated': In case of
+         * removal activity it's the value after the removal. */
+
+        extra_type_by_cause_iterate(EC_ROAD, pold) {
+          if (tile_has_extra(ptile, pold) && pold != pextra) {
+            struct road_type *po_road = extra_road_get(pold);
+
+            /* This ignores the fact that new road may be native to units that
+             * old road is not. */
+            if (po_road->move_cost < old_move_cost) {
+              old_move_cost = po_road->move_cost;
+            }
+          }
+        } extra_type_by_cause_iterate_end;
+
+        if (proad->move_cost < old_move_cost) {
+          if (proad->move_cost >= terrain_control.move_fragments) {
+            mc_divisor = proad->move_cost / terrain_control.move_fragments;
+          } else {
+            if (proad->move_cost == 0) {
+              mc_multiplier = 2;
+            } else {
+              mc_multiplier = 1 - proad->move_cost;
+            }
+            mc_multiplier += old_move_cost;
+          }
+        }
+
+        extra = adv_settlers_road_bonus(ptile, proad) * mc_multiplier / mc_divisor;
+
+      } else {
+        extra = 0;
+      }
+
+      if (extra_has_flag(pextra, EF_GLOBAL_WARMING)) {
+        extra -= pplayer->ai_common.warmth;
+      }
+      if (extra_has_flag(pextra, EF_NUCLEAR_WINTER)) {
+        extra -= pplayer->ai_common.frost;
+      }
+
+      if (removing) {
+        extra = -extra;
+      }
+
+      if (act != ACTIVITY_LAST) {
+        consider_settler_action(pplayer, act, pextra, extra, base_value,
+                                oldv, in_use, turns, ptile, best);
+      } else {
+        fc_assert(!removing);
+
+        road_deps_iterate(&(pextra->reqs), pdep) {
+          struct extra_type *dep_tgt;
+
+          dep_tgt = road_extra_get(pdep);
+
+          if (action_prob_possible(
+                action_speculate_unit_on_tile(ACTION_ROAD,
+                                              punit, unit_home(punit), ptile,
+                                              omniscient,
+                                              ptile, dep_tgt))) {
+            /* Consider building dependency road for later upgrade to target extra.
+             * Here we set value to be sum of dependency
+             * road and target extra values, which increases want, and turns is sum
+             * of dependency and target build turns, which decreases want. This can
+             * result in either bigger or lesser want than when checkin dependency
+             * road for the sake of itself when its turn in extra_type_iterate() is. */
+            int dep_turns = turns + get_turns_for_activity_at(punit,
+                                                              ACTIVITY_GEN_ROAD,
+                                                              ptile,
+                                                              dep_tgt);
+            int dep_value = base_value + adv_city_worker_extra_get(pcity, cindex, dep_tgt);
+
+            consider_settler_action(pplayer, ACTIVITY_GEN_ROAD, dep_tgt, extra,
+                                    dep_value,
+                                    oldv, in_use, dep_turns, ptile, best);
+          }
+        } road_deps_iterate_end;
+
+        base_deps_iterate(&(pextra->reqs), pdep) {
+          struct extra_type *dep_tgt;
+
+          dep_tgt = base_extra_get(pdep);
+          if (action_prob_possible(
+                action_speculate_unit_on_tile(ACTION_BASE,
+                                              punit, unit_home(punit), ptile,
+                                              omniscient,
+                                              ptile, dep_tgt))) {
+            /* Consider building dependency base for later upgrade to
+             * target extra. See similar road implementation above for
+             * extended commentary. */
+            int dep_turns = turns + get_turns_for_activity_at(punit,
+                                                              ACTIVITY_BASE,
+                                                              ptile,
+                                                              dep_tgt);
+            int dep_value = base_value + adv_city_worker_extra_get(pcity,
+                                                                   cindex,
+                                                                   dep_tgt);
+
+            consider_settler_action(pplayer, ACTIVITY_BASE, dep_tgt,
+                                    0.0, dep_value, oldv, in_use,
+                                    dep_turns, ptile, best);
+          }
+        } base_deps_iterate_end;
+      }
+    }
+  } extra_type_iterate_end;
+}
+
 /**********************************************************************//**
   Finds tiles to improve, using punit.
 
@@ -445,14 +760,8 @@ adv_want settler_evaluate_improvements(struct unit *punit,
   struct pf_parameter parameter;
   struct pf_map *pfm;
   struct pf_position pos;
-  int oldv;             /* Current value of consideration tile. */
-  int best_oldv = 9999; /* oldv of best target so far; compared if
-                         * newv == best_newv; not initialized to zero,
-                         * so that newv = 0 activities are not chosen. */
-  adv_want best_newv = 0;
-  bool improve_worked = FALSE;
-  int best_extra = 0;
-  int best_delay = 0;
+  struct settler_choice best;
+  adv_want best_newv;
 
   /* closest worker, if any, headed towards target tile */
   struct unit *enroute = NULL;
@@ -462,35 +771,15 @@ adv_want settler_evaluate_improvements(struct unit *punit,
   parameter.get_TB = autosettler_tile_behavior;
   pfm = pf_map_new(&parameter);
 
+  settler_choice_init(&best);
+
   city_list_iterate(pplayer->cities, pcity) {
     struct tile *pcenter = city_tile(pcity);
 
     /* try to work near the city */
     city_tile_iterate_index(city_map_radius_sq_get(pcity), pcenter, ptile,
                             cindex) {
-      bool consider = TRUE;
-      bool in_use = (tile_worked(ptile) == pcity);
-
-      if (!in_use && !city_can_work_tile(pcity, ptile)) {
-        /* Don't risk bothering with this tile. */
-        continue;
-      }
-
-      if (!adv_settler_safe_tile(pplayer, punit, ptile)) {
-        /* Too dangerous place */
-        continue;
-      }
-
-      /* Do not go to tiles that already have workers there. */
-      unit_list_iterate(ptile->units, aunit) {
-        if (unit_owner(aunit) == pplayer
-            && aunit->id != punit->id
-            && unit_has_type_flag(aunit, UTYF_SETTLERS)) {
-          consider = FALSE;
-        }
-      } unit_list_iterate_end;
-
-      if (!consider) {
+      if (!settler_can_consider_tile(pplayer, punit, pcity, ptile)) {
         continue;
       }
 
@@ -500,7 +789,7 @@ adv_want settler_evaluate_improvements(struct unit *punit,
       }
 
       if (pf_map_position(pfm, ptile, &pos)) {
-        int eta = FC_INFINITY, inbound_distance = FC_INFINITY, turns;
+        int eta = FC_INFINITY, inbound_distance = FC_INFINITY;
 
         if (enroute) {
           eta = state[tile_index(ptile)].eta;
@@ -524,264 +813,19 @@ adv_want settler_evaluate_improvements(struct unit *punit,
                      enroute->id, eta, inbound_distance);
           }
 
-          oldv = city_tile_value(pcity, ptile, 0, 0);
-
-          /* Now, consider various activities... */
-          as_transform_action_iterate(act) {
-            struct extra_type *target = NULL;
-            enum extra_cause cause =
-                activity_to_extra_cause(action_id_get_activity(act));
-            enum extra_rmcause rmcause =
-                activity_to_extra_rmcause(action_id_get_activity(act));
-
-            if (cause != EC_NONE) {
-              target = next_extra_for_tile(ptile, cause, pplayer,
-                                           punit);
-            } else if (rmcause != ERM_NONE) {
-              target = prev_extra_in_tile(ptile, rmcause, pplayer,
-                                          punit);
-            }
-
-            if (adv_city_worker_act_get(pcity, cindex,
-                                        action_id_get_activity(act)) >= 0
-                && action_prob_possible(
-                  action_speculate_unit_on_tile(act,
-                                                punit, unit_home(punit),
-                                                ptile,
-                                                parameter.omniscience,
-                                                ptile, target))) {
-              int base_value =
-                  adv_city_worker_act_get(pcity, cindex,
-                                          action_id_get_activity(act));
-
-              turns = pos.turn
-                  + get_turns_for_activity_at(punit,
-                                              action_id_get_activity(act),
-                                              ptile, target);
-              if (pos.moves_left == 0) {
-                /* We need moves left to begin activity immediately. */
-                turns++;
-              }
-
-              consider_settler_action(pplayer,
-                                      action_id_get_activity(act),
-                                      target, 0.0, base_value,
-                                      oldv, in_use, turns,
-                                      &best_newv, &best_oldv, &best_extra,
-                                      &improve_worked,
-                                      &best_delay, best_act, best_target,
-                                      best_tile, ptile);
-
-            } /* endif: can the worker perform this action */
-          } as_transform_action_iterate_end;
-
-          extra_type_iterate(pextra) {
-            enum unit_activity act = ACTIVITY_LAST;
-            enum unit_activity eval_act = ACTIVITY_LAST;
-            int base_value;
-            bool removing = tile_has_extra(ptile, pextra);
-
-            if (removing) {
-              as_rmextra_action_iterate(try_act) {
-                struct action *taction = action_by_number(try_act);
-                if (is_extra_removed_by_action(pextra, taction)) {
-                  /* We do not even evaluate actions we can't do.
-                   * Removal is not considered prerequisite for anything */
-                  if (action_prob_possible(
-                        action_speculate_unit_on_tile(try_act,
-                                                      punit,
-                                                      unit_home(punit),
-                                                      ptile,
-                                                      parameter.omniscience,
-                                                      ptile, pextra))) {
-                    act = action_get_activity(taction);
-                    eval_act = action_get_activity(taction);
-                    break;
-                  }
-                }
-              } as_rmextra_action_iterate_end;
-            } else {
-              as_extra_action_iterate(try_act) {
-                struct action *taction = action_by_number(try_act);
-                if (is_extra_caused_by_action(pextra, taction)) {
-                  eval_act = action_id_get_activity(try_act);
-                  if (action_prob_possible(
-                        action_speculate_unit_on_tile(try_act,
-                                                      punit,
-                                                      unit_home(punit),
-                                                      ptile,
-                                                      parameter.omniscience,
-                                                      ptile, pextra))) {
-                    act = action_get_activity(taction);
-                    break;
-                  }
-                }
-              } as_extra_action_iterate_end;
-            }
-
-            if (eval_act == ACTIVITY_LAST) {
-              /* No activity can provide (or remove) the extra */
-              continue;
-            }
-
-            if (removing) {
-              base_value = adv_city_worker_rmextra_get(pcity, cindex, pextra);
-            } else {
-              base_value = adv_city_worker_extra_get(pcity, cindex, pextra);
-            }
-
-            if (base_value >= 0) {
-              adv_want extra;
-              struct road_type *proad;
-
-              turns = pos.turn + get_turns_for_activity_at(punit, eval_act,
-                                                           ptile, pextra);
-              if (pos.moves_left == 0) {
-                /* We need moves left to begin activity immediately. */
-                turns++;
-              }
-
-              proad = extra_road_get(pextra);
-
-              if (proad != NULL && road_provides_move_bonus(proad)) {
-                int mc_multiplier = 1;
-                int mc_divisor = 1;
-                int old_move_cost = tile_terrain(ptile)->movement_cost * SINGLE_MOVE;
-
-                /* Here 'old' means actually 'without the evaluated': In case of
-                 * removal activity it's the value after the removal. */
-
-                extra_type_by_cause_iterate(EC_ROAD, pold) {
-                  if (tile_has_extra(ptile, pold) && pold != pextra) {
-                    struct road_type *po_road = extra_road_get(pold);
-
-                    /* This ignores the fact that new road may be native to units that
-                     * old road is not. */
-                    if (po_road->move_cost < old_move_cost) {
-                      old_move_cost = po_road->move_cost;
-                    }
-                  }
-                } extra_type_by_cause_iterate_end;
-
-                if (proad->move_cost < old_move_cost) {
-                  if (proad->move_cost >= terrain_control.move_fragments) {
-                    mc_divisor = proad->move_cost / terrain_control.move_fragments;
-                  } else {
-                    if (proad->move_cost == 0) {
-                      mc_multiplier = 2;
-                    } else {
-                      mc_multiplier = 1 - proad->move_cost;
-                    }
-                    mc_multiplier += old_move_cost;
-                  }
-                }
-
-                extra = adv_settlers_road_bonus(ptile, proad) * mc_multiplier / mc_divisor;
-
-              } else {
-                extra = 0;
-              }
-
-              if (extra_has_flag(pextra, EF_GLOBAL_WARMING)) {
-                extra -= pplayer->ai_common.warmth;
-              }
-              if (extra_has_flag(pextra, EF_NUCLEAR_WINTER)) {
-                extra -= pplayer->ai_common.frost;
-              }
-
-              if (removing) {
-                extra = -extra;
-              }
-
-              if (act != ACTIVITY_LAST) {
-                consider_settler_action(pplayer, act, pextra, extra, base_value,
-                                        oldv, in_use, turns,
-                                        &best_newv, &best_oldv, &best_extra,
-                                        &improve_worked,
-                                        &best_delay, best_act, best_target,
-                                        best_tile, ptile);
-              } else {
-                fc_assert(!removing);
-
-                road_deps_iterate(&(pextra->reqs), pdep) {
-                  struct extra_type *dep_tgt;
-
-                  dep_tgt = road_extra_get(pdep);
-
-                  if (action_prob_possible(
-                        action_speculate_unit_on_tile(ACTION_ROAD,
-                                                      punit, unit_home(punit), ptile,
-                                                      parameter.omniscience,
-                                                      ptile, dep_tgt))) {
-                    /* Consider building dependency road for later upgrade to target extra.
-                     * Here we set value to be sum of dependency
-                     * road and target extra values, which increases want, and turns is sum
-                     * of dependency and target build turns, which decreases want. This can
-                     * result in either bigger or lesser want than when checkin dependency
-                     * road for the sake of itself when its turn in extra_type_iterate() is. */
-                    int dep_turns = turns + get_turns_for_activity_at(punit,
-                                                                      ACTIVITY_GEN_ROAD,
-                                                                      ptile,
-                                                                      dep_tgt);
-                    int dep_value = base_value + adv_city_worker_extra_get(pcity, cindex, dep_tgt);
-
-                    consider_settler_action(pplayer, ACTIVITY_GEN_ROAD, dep_tgt, extra,
-                                            dep_value,
-                                            oldv, in_use, dep_turns,
-                                            &best_newv, &best_oldv, &best_extra,
-                                            &improve_worked,
-                                            &best_delay, best_act, best_target,
-                                            best_tile, ptile);
-                  }
-                } road_deps_iterate_end;
-
-                base_deps_iterate(&(pextra->reqs), pdep) {
-                  struct extra_type *dep_tgt;
-
-                  dep_tgt = base_extra_get(pdep);
-                  if (action_prob_possible(
-                        action_speculate_unit_on_tile(ACTION_BASE,
-                                                      punit, unit_home(punit), ptile,
-                                                      parameter.omniscience,
-                                                      ptile, dep_tgt))) {
-                    /* Consider building dependency base for later upgrade to
-                     * target extra. See similar road implementation above for
-                     * extended commentary. */
-                    int dep_turns = turns + get_turns_for_activity_at(punit,
-                                                                      ACTIVITY_BASE,
-                                                                      ptile,
-                                                                      dep_tgt);
-                    int dep_value = base_value + adv_city_worker_extra_get(pcity,
-                                                                           cindex,
-                                                                           dep_tgt);
-
-                    consider_settler_action(pplayer, ACTIVITY_BASE, dep_tgt,
-                                            0.0, dep_value, oldv, in_use,
-                                            dep_turns, &best_newv, &best_oldv,
-                                            &best_extra, &improve_worked,
-                                            &best_delay,
-                                            best_act, best_target,
-                                            best_tile, ptile);
-                  }
-                } base_deps_iterate_end;
-              }
-            }
-          } extra_type_iterate_end;
+          settler_evaluate_tile(punit, pcity, ptile, cindex, &pos,
+                                parameter.omniscience, &best);
         } /* endif: can we arrive sooner than current worker, if any? */
       } /* endif: are we travelling to a legal destination? */
     } city_tile_iterate_index_end;
   } city_list_iterate_end;
 
-  if (!improve_worked) {
-    /* best_newv contains total value of improved tile. Check amount of improvement
-     * instead. */
-    best_newv = amortize((best_newv - best_oldv + best_extra) * WORKER_FACTOR, best_delay);
-  }
-  best_newv /= WORKER_FACTOR;
-
-  best_newv = MAX(best_newv, 0); /* sanity */
+  best_newv = settler_choice_want(&best);
 
   if (best_newv > 0) {
+    *best_act = best.act;
+    *best_target = best.target;
+    *best_tile = best.ptile;
     log_debug("Settler %d@(%d,%d) wants to %s at (%d,%d) with desire " ADV_WANT_PRINTF,
               punit->id, TILE_XY(unit_tile(punit)),
               get_activity_text(*best_act), TILE_XY(*best_tile), best_newv);
@@ -789,6 +833,7 @@ adv_want settler_evaluate_improvements(struct unit *punit,
     /* Fill in dummy values.  The callers should check if the return value
      * is > 0 but this will avoid confusing them. */
     *best_act = ACTIVITY_IDLE;
+    *best_target = NULL;
     *best_tile = NULL;
   }
 
@@ -890,6 +935,48 @@ struct city *settler_evaluate_city_requests(struct unit *punit,
   return taskcity;
 }
 
+/**********************************************************************//**
+  Send punit to fulfill the best worker task requested by a nearby city,
+  if any. Returns TRUE if such a task was found.
+**************************************************************************/
+static bool auto_settler_city_request_work(struct player *pplayer,
+                                           struct unit *punit,
+                                           struct settlermap *state,
+                                           int recursion)
+{
+  struct worker_task *best_task;
+  struct extra_type *best_target;
+  struct pf_path *path = NULL;
+  struct city *taskcity;
+  int completion_time = 0;
+
+  taskcity = settler_evaluate_city_requests(punit, &best_task, &path, state);
+
+  if (taskcity == NULL) {
+    return FALSE;
+  }
+
+  if (path != NULL) {
+    completion_time = pf_path_last_position(path)->turn;
+  }
+
+  adv_unit_new_task(punit, AUT_AUTO_SETTLER, NULL);
+
+  best_target = best_task->tgt;
+
+  if (auto_settler_setup_work(pplayer, punit, state, recursion,
+                              path, best_task->ptile, best_task->act,
+                              &best_target, completion_time)) {
+    clear_worker_task(taskcity, best_task);
+  }
+
+  if (path != NULL) {
+    pf_path_destroy(path);
+  }
+
+  return TRUE;
+}
+
 /**********************************************************************//**
   Find some work for our settlers and/or workers.
 **************************************************************************/
@@ -899,12 +986,10 @@ void auto_settler_findwork(struct player *pplayer,
                            struct settlermap *state,
                            int recursion)
 {
-  struct worker_task *best_task;
   enum unit_activity best_act;
   struct tile *best_tile = NULL;
   struct extra_type *best_target;
   struct pf_path *path = NULL;
-  struct city *taskcity;
 
   /* time it will take worker to complete its given task */
   int completion_time = 0;
@@ -924,28 +1009,7 @@ void auto_settler_findwork(struct player *pplayer,
                 || unit_has_type_flag(punit, UTYF_SETTLERS));
 
   /* Have nearby cities requests? */
-
-  taskcity = settler_evaluate_city_requests(punit, &best_task, &path, state);
-
-  if (taskcity != NULL) {
-    if (path != NULL) {
-      completion_time = pf_path_last_position(path)->turn;
-    }
-
-    adv_unit_new_task(punit, AUT_AUTO_SETTLER, best_tile);
-
-    best_target = best_task->tgt;
-
-    if (auto_settler_setup_work(pplayer, punit, state, recursion,
-                                path, best_task->ptile, best_task->act,
-                                &best_target, completion_time)) {
-      clear_worker_task(taskcity, best_task);
-    }
-
-    if (path != NULL) {
-      pf_path_destroy(path);
-    }
-
+  if (auto_settler_city_request_work(pplayer, punit, state, recursion)) {
     return;
   }
 
@@ -1123,6 +1187,349 @@ bool adv_settler_safe_tile(const struct player *pplayer, struct unit *punit,
   return TRUE;
 }
 
+/* Auto workers that can not be told apart by the job evaluation share
+ * one class; its path finding and job values are calculated only once. */
+struct as_batch_job {
+  struct tile *ptile;
+  enum unit_activity act;
+  struct extra_type *target;
+  adv_want want;
+  int turn;                     /* Arrival turn */
+};
+
+struct as_batch_class {
+  int rep_id;                   /* Unit the class is evaluated with */
+  struct tile *ptile;
+  struct pf_map *pfm;           /* Paths of the class, kept for assignment */
+  struct as_batch_job *jobs;
+  int num_jobs;
+};
+
+/* Limit of auction rounds per worker; workers still without a job after
+ * that take the best free job greedily. */
+#define AS_BATCH_MAX_BIDS 64
+
+/**********************************************************************//**
+  Would the job evaluation for unit a and unit b be identical?
+**************************************************************************/
+static bool as_batch_same_class(const struct unit *a, const struct unit *b)
+{
+  return (unit_type_get(a) == unit_type_get(b)
+          && unit_tile(a) == unit_tile(b)
+          && a->moves_left == b->moves_left
+          && a->hp == b->hp
+          && a->veteran == b->veteran
+          && a->fuel == b->fuel
+          && a->homecity == b->homecity
+          && unit_transport_get(a) == unit_transport_get(b));
+}
+
+/**********************************************************************//**
+  Calculate the best job at every city tile the class representative
+  could work on. tile_job must be an array of MAP_INDEX_SIZE entries set
+  to -1; it is restored before returning. The path finding map is left
+  in pclass->pfm for the caller to destroy.
+**************************************************************************/
+static void as_batch_class_evaluate(struct player *pplayer,
+                                    struct as_batch_class *pclass,
+                                    struct settlermap *state,
+                                    int *tile_job)
+{
+  struct unit *punit = player_unit_by_number(pplayer, pclass->rep_id);
+  struct pf_parameter parameter;
+  struct pf_map *pfm;
+  int jobs_size = 0;
+  int i;
+
+  if (punit == NULL) {
+    return;
+  }
+
+  pft_fill_unit_parameter(&parameter, punit);
+  parameter.omniscience = !has_handicap(pplayer, H_MAP);
+  parameter.get_TB = autosettler_tile_behavior;
+  pfm = pf_map_new(&parameter);
+
+  city_list_iterate(pplayer->cities, pcity) {
+    city_tile_iterate_index(city_map_radius_sq_get(pcity), city_tile(pcity),
+                            ptile, cindex) {
+      struct settler_choice best;
+      struct pf_position pos;
+      adv_want want;
+      int idx = tile_index(ptile);
+
+      if (NULL != player_unit_by_number(pplayer, state[idx].enroute)) {
+        /* Already reserved by a worker handled before the batch. */
+        continue;
+      }
+
+      if (!settler_can_consider_tile(pplayer, punit, pcity, ptile)
+          || !pf_map_position(pfm, ptile, &pos)) {
+        continue;
+      }
+
+      settler_choice_init(&best);
+      settler_evaluate_tile(punit, pcity, ptile, cindex, &pos,
+                            parameter.omniscience, &best);
+      want = settler_choice_want(&best);
+
+      if (want <= 0) {
+        continue;
+      }
+
+      if (tile_job[idx] >= 0) {
+        /* Tile shared by several cities; keep the best use of it. */
+        struct as_batch_job *pjob = &pclass->jobs[tile_job[idx]];
+
+        if (want > pjob->want) {
+          pjob->act = best.act;
+          pjob->target = best.target;
+          pjob->want = want;
+        }
+        continue;
+      }
+
+      if (pclass->num_jobs >= jobs_size) {
+        jobs_size = MAX(16, jobs_size * 2);
+        pclass->jobs = fc_realloc(pclass->jobs,
+                                  jobs_size * sizeof(*pclass->jobs));
+      }
+      tile_job[idx] = pclass->num_jobs;
+      pclass->jobs[pclass->num_jobs].ptile = ptile;
+      pclass->jobs[pclass->num_jobs].act = best.act;
+      pclass->jobs[pclass->num_jobs].target = best.target;
+      pclass->jobs[pclass->num_jobs].want = want;
+      pclass->jobs[pclass->num_jobs].turn = pos.turn;
+      pclass->num_jobs++;
+    } city_tile_iterate_index_end;
+  } city_list_iterate_end;
+
+  for (i = 0; i < pclass->num_jobs; i++) {
+    tile_job[tile_index(pclass->jobs[i].ptile)] = -1;
+  }
+
+  pclass->pfm = pfm;
+}
+
+/**********************************************************************//**
+  Assign jobs to all the workers at once, maximizing the total want,
+  with an auction: unassigned workers bid for the job with the best
+  want minus price, raising its price by the margin to their second best
+  option, and outbid workers go back to the queue. Doing nothing is
+  always an option with value 0.
+
+  worker_class holds the class index of each worker; the chosen job
+  index within the class, or -1, is stored to worker_job.
+**************************************************************************/
+static void as_batch_assign(const struct as_batch_class *classes,
+                            const int *worker_class, int num_workers,
+                            int *worker_job)
+{
+  float *price = fc_calloc(MAP_INDEX_SIZE, sizeof(*price));
+  int *owner = fc_malloc(MAP_INDEX_SIZE * sizeof(*owner));
+  int *queue = fc_malloc(num_workers * sizeof(*queue));
+  int queued = 0, bids = 0;
+  float eps = 1.0 / (num_workers + 1);
+  int i, w;
+
+  for (i = 0; i < MAP_INDEX_SIZE; i++) {
+    owner[i] = -1;
+  }
+  /* Queue is popped from the end; process workers in unit list order. */
+  for (w = num_workers - 1; w >= 0; w--) {
+    worker_job[w] = -1;
+    queue[queued++] = w;
+  }
+
+  while (queued > 0 && bids < AS_BATCH_MAX_BIDS * num_workers) {
+    const struct as_batch_class *pclass;
+    float first = 0.0, second = 0.0;
+    int best = -1;
+    int idx;
+
+    w = queue[--queued];
+    pclass = &classes[worker_class[w]];
+
+    for (i = 0; i < pclass->num_jobs; i++) {
+      float value = pclass->jobs[i].want
+                    - price[tile_index(pclass->jobs[i].ptile)];
+
+      if (value > first) {
+        second = first;
+        first = value;
+        best = i;
+      } else if (value > second) {
+        second = value;
+      }
+    }
+
+    if (best < 0) {
+      /* Nothing worth the current prices. */
+      continue;
+    }
+
+    idx = tile_index(pclass->jobs[best].ptile);
+    price[idx] += first - second + eps;
+    if (owner[idx] >= 0) {
+      worker_job[owner[idx]] = -1;
+      queue[queued++] = owner[idx];
+    }
+    owner[idx] = w;
+    worker_job[w] = best;
+    bids++;
+  }
+
+  /* Bid limit reached; the rest take what is left. */
+  while (queued > 0) {
+    const struct as_batch_class *pclass;
+    int best = -1;
+
+    w = queue[--queued];
+    pclass = &classes[worker_class[w]];
+
+    for (i = 0; i < pclass->num_jobs; i++) {
+      if (owner[tile_index(pclass->jobs[i].ptile)] < 0
+          && (best < 0 || pclass->jobs[i].want > pclass->jobs[best].want)) {
+        best = i;
+      }
+    }
+
+    if (best >= 0) {
+      owner[tile_index(pclass->jobs[best].ptile)] = w;
+      worker_job[w] = best;
+    }
+  }
+
+  free(queue);
+  free(owner);
+  free(price);
+}
+
+/**********************************************************************//**
+  Find work for a batch of idle auto workers jointly, instead of letting
+  each of them pick the best job for itself in turn. Workers first take
+  worker tasks requested by cities as usual. The rest are grouped to
+  classes of identical workers, job values are calculated once per class,
+  and jobs are then assigned to maximize their total want.
+**************************************************************************/
+static void auto_settlers_plan_batch(struct player *pplayer,
+                                     const int *unit_ids, int num_units,
+                                     struct settlermap *state)
+{
+  struct as_batch_class *classes;
+  int *worker_id, *worker_class, *worker_job, *tile_job;
+  int num_classes = 0, num_workers = 0;
+  bool city_tasks = FALSE;
+  int i, w;
+
+  city_list_iterate(pplayer->cities, pcity) {
+    if (worker_task_list_size(pcity->task_reqs) > 0) {
+      city_tasks = TRUE;
+      break;
+    }
+  } city_list_iterate_end;
+
+  classes = fc_calloc(num_units, sizeof(*classes));
+  worker_id = fc_malloc(num_units * sizeof(*worker_id));
+  worker_class = fc_malloc(num_units * sizeof(*worker_class));
+  worker_job = fc_malloc(num_units * sizeof(*worker_job));
+
+  for (i = 0; i < num_units; i++) {
+    struct unit *punit = player_unit_by_number(pplayer, unit_ids[i]);
+    int c;
+
+    if (punit == NULL || punit->activity != ACTIVITY_IDLE) {
+      continue;
+    }
+
+    if (city_tasks
+        && auto_settler_city_request_work(pplayer, punit, state, 0)) {
+      continue;
+    }
+
+    for (c = 0; c < num_classes; c++) {
+      struct unit *rep = player_unit_by_number(pplayer, classes[c].rep_id);
+
+      if (rep != NULL && as_batch_same_class(rep, punit)) {
+        break;
+      }
+    }
+    if (c == num_classes) {
+      classes[c].rep_id = punit->id;
+      classes[c].ptile = unit_tile(punit);
+      num_classes++;
+    }
+
+    worker_id[num_workers] = punit->id;
+    worker_class[num_workers] = c;
+    num_workers++;
+  }
+
+  if (num_workers > 0) {
+    TIMING_LOG(AIT_WORKERS, TIMER_START);
+    tile_job = fc_malloc(MAP_INDEX_SIZE * sizeof(*tile_job));
+    for (i = 0; i < MAP_INDEX_SIZE; i++) {
+      tile_job[i] = -1;
+    }
+    for (i = 0; i < num_classes; i++) {
+      as_batch_class_evaluate(pplayer, &classes[i], state, tile_job);
+    }
+    free(tile_job);
+
+    as_batch_assign(classes, worker_class, num_workers, worker_job);
+    TIMING_LOG(AIT_WORKERS, TIMER_STOP);
+  }
+
+  for (w = 0; w < num_workers; w++) {
+    struct unit *punit = player_unit_by_number(pplayer, worker_id[w]);
+    const struct as_batch_class *pclass = &classes[worker_class[w]];
+    struct as_batch_job *pjob;
+    struct extra_type *target;
+    struct pf_path *path;
+
+    /* Earlier workers may have caused this one to die, or to move, while
+     * starting their work. */
+    if (punit == NULL) {
+      continue;
+    }
+    if (unit_tile(punit) != pclass->ptile
+        || punit->activity != ACTIVITY_IDLE) {
+      auto_settler_findwork(pplayer, punit, state, 0);
+      continue;
+    }
+
+    if (worker_job[w] < 0) {
+      adv_unit_new_task(punit, AUT_AUTO_SETTLER, NULL);
+      auto_settler_setup_work(pplayer, punit, state, 0, NULL, NULL,
+                              ACTIVITY_IDLE, NULL, 0);
+      continue;
+    }
+
+    pjob = &pclass->jobs[worker_job[w]];
+    target = pjob->target;
+    /* Workers of a class share the paths of its evaluation. */
+    path = (NULL != pclass->pfm ? pf_map_path(pclass->pfm, pjob->ptile)
+            : NULL);
+    adv_unit_new_task(punit, AUT_AUTO_SETTLER, pjob->ptile);
+    auto_settler_setup_work(pplayer, punit, state, 0, path, pjob->ptile,
+                            pjob->act, &target, pjob->turn);
+    if (NULL != path) {
+      pf_path_destroy(path);
+    }
+  }
+
+  for (i = 0; i < num_classes; i++) {
+    if (NULL != classes[i].pfm) {
+      pf_map_destroy(classes[i].pfm);
+    }
+    free(classes[i].jobs);
+  }
+  free(worker_job);
+  free(worker_class);
+  free(worker_id);
+  free(classes);
+}
+
 /**********************************************************************//**
   Run through all the players settlers and let those on ai.control work 
   automagically.
@@ -1130,8 +1537,12 @@ bool adv_settler_safe_tile(const struct player *pplayer, struct unit *punit,
 void auto_settlers_player(struct player *pplayer) 
 {
   struct settlermap *state;
+  int *batch_ids;
+  int batch_size = 0;
 
   state = fc_calloc(MAP_INDEX_SIZE, sizeof(*state));
+  batch_ids = fc_malloc(MAX(1, unit_list_size(pplayer->units))
+                        * sizeof(*batch_ids));
 
   as_timer = timer_renew(as_timer, TIMER_CPU, TIMER_DEBUG);
   timer_start(as_timer);
@@ -1197,13 +1608,24 @@ void auto_settlers_player(struct player *pplayer)
       }
       if (punit->activity == ACTIVITY_IDLE) {
         if (!is_ai(pplayer)) {
-          auto_settler_findwork(pplayer, punit, state, 0);
+          if (unit_has_type_flag(punit, UTYF_SETTLERS)) {
+            /* Planned jointly below. */
+            batch_ids[batch_size++] = punit->id;
+          } else {
+            auto_settler_findwork(pplayer, punit, state, 0);
+          }
         } else {
           CALL_PLR_AI_FUNC(settler_run, pplayer, pplayer, punit, state);
         }
       }
     }
   } unit_list_iterate_safe_end;
+
+  if (batch_size > 0) {
+    auto_settlers_plan_batch(pplayer, batch_ids, batch_size, state);
+  }
+  free(batch_ids);
+
   /* Reset auto settler state for the next run. */
   if (is_ai(pplayer)) {
     CALL_PLR_AI_FUNC(settler_reset, pplayer, pplayer);
@@ -18,8 +18,11 @@
 /* common */
 #include "city.h"
 #include "game.h"
+#include "government.h"
+#include "improvement.h"
 #include "map.h"
 #include "player.h"
+#include "research.h"
 #include "tile.h"
 
 /* server */
@@ -31,11 +34,20 @@
 
 #include "infracache.h"
 
+/* Recalculate all tiles of a city at least this often, so that inputs
+ * not covered by the signatures (e.g. turn or year requirements) do not
+ * keep stale values around forever. */
+#define INFRA_CACHE_MAX_AGE 16
+
 /* cache activities within the city map */
 struct worker_activity_cache {
   int act[ACTIVITY_LAST];
   int extra[MAX_EXTRA_TYPES];
   int rmextra[MAX_EXTRA_TYPES];
+  /* Signature of the tile and its neighbours when the values were
+   * calculated. Meaningful only when 'valid' is set. */
+  unsigned int sig;
+  bool valid;
 };
 
 static int adv_calc_irrigate_transform(const struct city *pcity,
@@ -233,54 +245,197 @@ static int adv_calc_rmextra(const struct city *pcity, const struct tile *ptile,
   return goodness;
 }
 
+/**********************************************************************//**
+  Combine value into signature.
+**************************************************************************/
+static inline unsigned int infra_sig_mix(unsigned int sig, unsigned int val)
+{
+  return sig ^ (val + 0x9e3779b9 + (sig << 6) + (sig >> 2));
+}
+
+/**********************************************************************//**
+  Signature of the tile properties the cached values depend on.
+**************************************************************************/
+static unsigned int infra_tile_sig(const struct tile *ptile)
+{
+  const struct terrain *pterrain = tile_terrain(ptile);
+  const struct player *owner = tile_owner(ptile);
+  const struct player *extras_owner = extra_owner(ptile);
+  unsigned int sig = tile_index(ptile);
+  size_t i;
+
+  sig = infra_sig_mix(sig, pterrain != NULL ? terrain_number(pterrain) + 1 : 0);
+  sig = infra_sig_mix(sig, owner != NULL ? player_number(owner) + 1 : 0);
+  sig = infra_sig_mix(sig, extras_owner != NULL
+                           ? player_number(extras_owner) + 1 : 0);
+  sig = infra_sig_mix(sig, tile_resource(ptile) != NULL
+                           ? extra_number(tile_resource(ptile)) + 1 : 0);
+  sig = infra_sig_mix(sig, tile_city(ptile) != NULL);
+
+  for (i = 0; i < ARRAY_SIZE(ptile->extras.vec); i++) {
+    sig = infra_sig_mix(sig, ptile->extras.vec[i]);
+  }
+
+  return sig;
+}
+
+/**********************************************************************//**
+  Signature of the tile and its neighbours. Requirements of extras and
+  terrain changes may look at adjacent tiles, so a change next to the
+  tile invalidates its values too.
+**************************************************************************/
+static unsigned int infra_tile_area_sig(const struct tile *ptile)
+{
+  unsigned int sig = infra_tile_sig(ptile);
+
+  adjc_iterate(&(wld.map), ptile, adjc_tile) {
+    sig = infra_sig_mix(sig, infra_tile_sig(adjc_tile));
+  } adjc_iterate_end;
+
+  return sig;
+}
+
+/**********************************************************************//**
+  Signature of the player wide inputs of tile values: government, nation,
+  multipliers, known techs and wonders.
+**************************************************************************/
+static unsigned int infra_player_sig(const struct player *pplayer)
+{
+  const struct research *presearch = research_get(pplayer);
+  unsigned int sig = player_number(pplayer);
+
+  sig = infra_sig_mix(sig, government_number(government_of_player(pplayer)));
+  sig = infra_sig_mix(sig, nation_number(nation_of_player(pplayer)));
+  multipliers_iterate(pmul) {
+    sig = infra_sig_mix(sig, pplayer->multipliers[multiplier_index(pmul)]);
+  } multipliers_iterate_end;
+  advance_index_iterate(A_FIRST, tech) {
+    sig = infra_sig_mix(sig, research_invention_state(presearch, tech));
+  } advance_index_iterate_end;
+  sig = infra_sig_mix(sig, presearch->future_tech);
+  sig = infra_sig_mix(sig, game.info.global_advance_count);
+
+  improvement_iterate(pimprove) {
+    if (is_great_wonder(pimprove)) {
+      sig = infra_sig_mix(sig, game.info.great_wonder_owners
+                                   [improvement_index(pimprove)]);
+    }
+    if (is_wonder(pimprove)) {
+      sig = infra_sig_mix(sig, pplayer->wonders[improvement_index(pimprove)]);
+    }
+  } improvement_iterate_end;
+
+  return sig;
+}
+
+/**********************************************************************//**
+  Signature of the city wide inputs of tile values.
+**************************************************************************/
+static unsigned int infra_city_sig(const struct city *pcity,
+                                   unsigned int player_sig)
+{
+  unsigned int sig = infra_sig_mix(player_sig, city_size_get(pcity));
+
+  sig = infra_sig_mix(sig, base_city_celebrating(pcity));
+  sig = infra_sig_mix(sig, city_map_radius_sq_get(pcity));
+
+  city_built_iterate(pcity, pimprove) {
+    sig = infra_sig_mix(sig, improvement_number(pimprove) + 1);
+  } city_built_iterate_end;
+
+  return sig;
+}
+
+/**********************************************************************//**
+  Calculate cached values of a single city tile.
+**************************************************************************/
+static void infra_cache_tile_update(struct city *pcity,
+                                    const struct tile *ptile, int cindex)
+{
+  as_transform_action_iterate(act) {
+    adv_city_worker_act_set(pcity, cindex, action_id_get_activity(act), -1);
+  } as_transform_action_iterate_end;
+
+  adv_city_worker_act_set(pcity, cindex, ACTIVITY_MINE,
+                          adv_calc_mine_transform(pcity, ptile));
+  adv_city_worker_act_set(pcity, cindex, ACTIVITY_IRRIGATE,
+                          adv_calc_irrigate_transform(pcity, ptile));
+  adv_city_worker_act_set(pcity, cindex, ACTIVITY_TRANSFORM,
+                          adv_calc_transform(pcity, ptile));
+
+  /* road_bonus() is handled dynamically later; it takes into
+   * account settlers that have already been assigned to building
+   * roads this turn. */
+  extra_type_iterate(pextra) {
+    /* We have no use for extra value, if workers cannot be assigned
+     * to build it, so don't use time to calculate values otherwise */
+    if (pextra->buildable
+        && is_extra_caused_by_worker_action(pextra)) {
+      adv_city_worker_extra_set(pcity, cindex, pextra,
+                                adv_calc_extra(pcity, ptile, pextra));
+    } else {
+      adv_city_worker_extra_set(pcity, cindex, pextra, 0);
+    }
+    if (tile_has_extra(ptile, pextra) && is_extra_removed_by_worker_action(pextra)) {
+      adv_city_worker_rmextra_set(pcity, cindex, pextra,
+                                  adv_calc_rmextra(pcity, ptile, pextra));
+    } else {
+      adv_city_worker_rmextra_set(pcity, cindex, pextra, 0);
+    }
+  } extra_type_iterate_end;
+}
+
 /**********************************************************************//**
   Do all tile improvement calculations and cache them for later.
 
   These values are used in settler_evaluate_improvements() so this function
   must be called before doing that.  Currently this is only done when handling
   auto-settlers or when the AI contemplates building worker units.
+
+  The cache persists between calls. Only tiles whose own or adjacent
+  terrain, extras or ownership changed are recalculated, unless the city
+  or player wide inputs (government, techs, buildings, size) changed or
+  the city has not been fully refreshed for INFRA_CACHE_MAX_AGE turns.
 **************************************************************************/
 void initialize_infrastructure_cache(struct player *pplayer)
 {
+  unsigned int player_sig = infra_player_sig(pplayer);
+
   city_list_iterate(pplayer->cities, pcity) {
+    struct adv_city *adv = pcity->server.adv;
     struct tile *pcenter = city_tile(pcity);
     int radius_sq = city_map_radius_sq_get(pcity);
+    unsigned int city_sig;
 
-    city_map_iterate(radius_sq, city_index, city_x, city_y) {
-      as_transform_action_iterate(act) {
-        adv_city_worker_act_set(pcity, city_index, action_id_get_activity(act),
-                                -1);
-      } as_transform_action_iterate_end;
-    } city_map_iterate_end;
+    /* Reallocating for a new radius also invalidates all entries. */
+    adv_city_update(pcity);
+    city_sig = infra_city_sig(pcity, player_sig);
+
+    if (adv->act_cache_turn < 0 || city_sig != adv->act_cache_sig
+        || game.info.turn - adv->act_cache_turn >= INFRA_CACHE_MAX_AGE) {
+      city_map_iterate(radius_sq, city_index, city_x, city_y) {
+        as_transform_action_iterate(act) {
+          adv_city_worker_act_set(pcity, city_index,
+                                  action_id_get_activity(act), -1);
+        } as_transform_action_iterate_end;
+        adv->act_cache[city_index].valid = FALSE;
+      } city_map_iterate_end;
+
+      adv->act_cache_sig = city_sig;
+      adv->act_cache_turn = game.info.turn;
+    }
 
     city_tile_iterate_index(radius_sq, pcenter, ptile, cindex) {
-      adv_city_worker_act_set(pcity, cindex, ACTIVITY_MINE,
-                              adv_calc_mine_transform(pcity, ptile));
-      adv_city_worker_act_set(pcity, cindex, ACTIVITY_IRRIGATE,
-                              adv_calc_irrigate_transform(pcity, ptile));
-      adv_city_worker_act_set(pcity, cindex, ACTIVITY_TRANSFORM,
-                              adv_calc_transform(pcity, ptile));
-
-      /* road_bonus() is handled dynamically later; it takes into
-       * account settlers that have already been assigned to building
-       * roads this turn. */
-      extra_type_iterate(pextra) {
-        /* We have no use for extra value, if workers cannot be assigned
-         * to build it, so don't use time to calculate values otherwise */
-        if (pextra->buildable
-            && is_extra_caused_by_worker_action(pextra)) {
-          adv_city_worker_extra_set(pcity, cindex, pextra,
-                                    adv_calc_extra(pcity, ptile, pextra));
-        } else {
-          adv_city_worker_extra_set(pcity, cindex, pextra, 0);
-        }
-        if (tile_has_extra(ptile, pextra) && is_extra_removed_by_worker_action(pextra)) {
-          adv_city_worker_rmextra_set(pcity, cindex, pextra,
-                                      adv_calc_rmextra(pcity, ptile, pextra));
-        } else {
-          adv_city_worker_rmextra_set(pcity, cindex, pextra, 0);
-        }
-      } extra_type_iterate_end;
+      struct worker_activity_cache *pcache = &adv->act_cache[cindex];
+      unsigned int tile_sig = infra_tile_area_sig(ptile);
+
+      if (pcache->valid && pcache->sig == tile_sig) {
+        continue;
+      }
+
+      infra_cache_tile_update(pcity, ptile, cindex);
+      pcache->sig = tile_sig;
+      pcache->valid = TRUE;
     } city_tile_iterate_index_end;
   } city_list_iterate_end;
 }
@@ -464,11 +619,12 @@ void adv_city_update(struct city *pcity)
       = fc_realloc(pcity->server.adv->act_cache,
                    city_map_tiles(radius_sq)
                    * sizeof(*(pcity->server.adv->act_cache)));
-    /* initialize with 0 */
+    /* initialize with 0; this also marks all entries invalid */
     memset(pcity->server.adv->act_cache, 0,
            city_map_tiles(radius_sq)
            * sizeof(*(pcity->server.adv->act_cache)));
     pcity->server.adv->act_cache_radius_sq = radius_sq;
+    pcity->server.adv->act_cache_turn = -1;
   }
 }
 
@@ -481,6 +637,8 @@ void adv_city_alloc(struct city *pcity)
 
   pcity->server.adv->act_cache = NULL;
   pcity->server.adv->act_cache_radius_sq = -1;
+  pcity->server.adv->act_cache_sig = 0;
+  pcity->server.adv->act_cache_turn = -1;
   /* allocate memory for pcity->ai->act_cache */
   adv_city_update(pcity);
 }
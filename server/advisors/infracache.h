@@ -23,6 +23,10 @@ struct adv_city {
    * a particular activity on a particular tile. */
   struct worker_activity_cache *act_cache;
   int act_cache_radius_sq;
+  /* City wide inputs the cached values were calculated with, and the
+   * turn all tiles were last recalculated. */
+  unsigned int act_cache_sig;
+  int act_cache_turn;
 
   /* building desirabilities - easiest to handle them here -- Syela */
   /* The units of building_want are output
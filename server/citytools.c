@@ -1168,6 +1168,8 @@ bool transfer_city(struct player *ptaker, struct city *pcity,
   pcity->owner = ptaker;
   map_claim_ownership(pcenter, ptaker, pcenter, TRUE);
   city_list_prepend(ptaker->cities, pcity);
+  pgiver->server.largest_city_size = -1;
+  ptaker->server.largest_city_size = -1;
 
   /* Hide/reveal units. Do it after vision have been given to taker, city
    * owner has been changed, and before any script could be spawned. */
@@ -1548,6 +1550,7 @@ void create_city(struct player *pplayer, struct tile *ptile,
   vision_reveal_tiles(pcity->server.vision, game.server.vision_reveal_tiles);
   city_refresh_vision(pcity);
   city_list_prepend(pplayer->cities, pcity);
+  pplayer->server.largest_city_size = -1;
 
   /* This is dependent on the current vision, so must be done after
    * vision is prepared and before arranging workers. */
@@ -142,6 +142,21 @@ static void update_city_activity(struct city *pcity);
 static void nullify_caravan_and_disband_plus(struct city *pcity);
 static bool city_illness_check(const struct city * pcity);
 
+/* Size, in native tiles, of the square buckets of the migration index. */
+#define MGR_BUCKET_SIZE 8
+
+/* All cities, bucketed by their native position when the migration checks
+ * started. The candidate search only looks at the buckets in range instead
+ * of at every tile in range. Cities are referred to by id, as migration may
+ * disband cities. */
+static struct {
+  int xbuckets;
+  int ybuckets;
+  int *start;     /* Offset of each bucket in 'ids'; one extra entry at the
+                   * end holds the total number of cities. */
+  int *ids;
+} mgr_index = { 0, 0, NULL, NULL };
+
 static float city_migration_score(struct city *pcity);
 static bool do_city_migration(struct city *pcity_from,
                               struct city *pcity_to);
@@ -3747,6 +3762,150 @@ static bool do_city_migration(struct city *pcity_from,
   return TRUE;
 }
 
+/**********************************************************************//**
+  Returns the migration index bucket of the given tile.
+**************************************************************************/
+static int mgr_index_bucket(const struct tile *ptile)
+{
+  int nat_x, nat_y;
+
+  index_to_native_pos(&nat_x, &nat_y, tile_index(ptile));
+
+  return (nat_y / MGR_BUCKET_SIZE) * mgr_index.xbuckets
+         + nat_x / MGR_BUCKET_SIZE;
+}
+
+/**********************************************************************//**
+  Put all cities into the migration index.
+**************************************************************************/
+static void mgr_index_build(void)
+{
+  int nbuckets, i;
+  int *fill;
+
+  mgr_index.xbuckets = (wld.map.xsize + MGR_BUCKET_SIZE - 1)
+                       / MGR_BUCKET_SIZE;
+  mgr_index.ybuckets = (wld.map.ysize + MGR_BUCKET_SIZE - 1)
+                       / MGR_BUCKET_SIZE;
+  nbuckets = mgr_index.xbuckets * mgr_index.ybuckets;
+  mgr_index.start = fc_calloc(nbuckets + 1, sizeof(*mgr_index.start));
+
+  /* Count the cities of each bucket ... */
+  players_iterate(pplayer) {
+    city_list_iterate(pplayer->cities, pcity) {
+      mgr_index.start[mgr_index_bucket(city_tile(pcity)) + 1]++;
+    } city_list_iterate_end;
+  } players_iterate_end;
+  for (i = 0; i < nbuckets; i++) {
+    mgr_index.start[i + 1] += mgr_index.start[i];
+  }
+
+  /* ... and store them grouped by bucket. */
+  mgr_index.ids = fc_malloc(MAX(1, mgr_index.start[nbuckets])
+                            * sizeof(*mgr_index.ids));
+  fill = fc_malloc(nbuckets * sizeof(*fill));
+  memcpy(fill, mgr_index.start, nbuckets * sizeof(*fill));
+  players_iterate(pplayer) {
+    city_list_iterate(pplayer->cities, pcity) {
+      mgr_index.ids[fill[mgr_index_bucket(city_tile(pcity))]++] = pcity->id;
+    } city_list_iterate_end;
+  } players_iterate_end;
+  free(fill);
+}
+
+/**********************************************************************//**
+  Free the migration index.
+**************************************************************************/
+static void mgr_index_free(void)
+{
+  FC_FREE(mgr_index.start);
+  FC_FREE(mgr_index.ids);
+  mgr_index.xbuckets = 0;
+  mgr_index.ybuckets = 0;
+}
+
+/**********************************************************************//**
+  Fill 'buckets' with the buckets along one native axis that hold the
+  coordinates within 'dist' of 'center'. Returns the number of buckets.
+**************************************************************************/
+static int mgr_index_axis(int center, int dist, int size, int nbuckets,
+                          bool wrap, int *buckets)
+{
+  int lo = center - dist;
+  int hi = center + dist;
+  int first, last, b, n = 0;
+
+  if (wrap) {
+    if (hi - lo + 1 >= size) {
+      first = 0;
+      last = nbuckets - 1;
+    } else {
+      lo = FC_WRAP(lo, size);
+      hi = FC_WRAP(hi, size);
+      first = lo / MGR_BUCKET_SIZE;
+      last = hi / MGR_BUCKET_SIZE;
+      if (lo > hi) {
+        /* The range wraps around the map edge. */
+        if (last >= first) {
+          first = 0;
+          last = nbuckets - 1;
+        } else {
+          for (b = first; b < nbuckets; b++) {
+            buckets[n++] = b;
+          }
+          first = 0;
+        }
+      }
+    }
+  } else {
+    first = MAX(lo, 0) / MGR_BUCKET_SIZE;
+    last = MIN(hi, size - 1) / MGR_BUCKET_SIZE;
+  }
+
+  for (b = first; b <= last; b++) {
+    buckets[n++] = b;
+  }
+
+  return n;
+}
+
+/**********************************************************************//**
+  Append to 'found' all cities in the migration index within real
+  distance 'dist' of 'ptile'.
+**************************************************************************/
+static void mgr_index_nearby(const struct tile *ptile, int dist,
+                             struct city_list *found)
+{
+  int xbuckets[mgr_index.xbuckets], ybuckets[mgr_index.ybuckets];
+  int nat_x, nat_y, nx, ny, i, j, k;
+
+  index_to_native_pos(&nat_x, &nat_y, tile_index(ptile));
+
+  /* An iso-map compresses the distance in the native X direction but not
+   * in the native Y direction; see is_border_tile(). */
+  nx = mgr_index_axis(nat_x, dist, wld.map.xsize, mgr_index.xbuckets,
+                      current_topo_has_flag(TF_WRAPX), xbuckets);
+  ny = mgr_index_axis(nat_y, MAP_IS_ISOMETRIC ? 2 * dist : dist,
+                      wld.map.ysize, mgr_index.ybuckets,
+                      current_topo_has_flag(TF_WRAPY), ybuckets);
+
+  for (j = 0; j < ny; j++) {
+    for (i = 0; i < nx; i++) {
+      int bucket = ybuckets[j] * mgr_index.xbuckets + xbuckets[i];
+
+      for (k = mgr_index.start[bucket]; k < mgr_index.start[bucket + 1];
+           k++) {
+        struct city *pcity = game_city_by_number(mgr_index.ids[k]);
+
+        if (pcity != NULL
+            && real_map_distance(ptile, city_tile(pcity)) <= dist) {
+          city_list_append(found, pcity);
+        }
+      }
+    }
+  }
+}
+
 /**********************************************************************//**
   Check for citizens who want to migrate between the cities that overlap.
   Migrants go to the city with higher score, if the growth of the target
@@ -3782,6 +3941,8 @@ bool check_city_migrations(void)
     return FALSE;
   }
 
+  mgr_index_build();
+
   /* check for migration */
   players_iterate(pplayer) {
     if (!pplayer->cities) {
@@ -3793,6 +3954,8 @@ bool check_city_migrations(void)
     }
   } players_iterate_end;
 
+  mgr_index_free();
+
   return internat;
 }
 
@@ -3931,31 +4094,44 @@ static void apply_disaster(struct city *pcity, struct disaster_type *pdis)
 **************************************************************************/
 void check_disasters(void)
 {
+  int n = 0;
+
   if (game.info.disasters == 0) {
     /* Shortcut out as no disaster is possible. */
     return;
   }
 
   players_iterate(pplayer) {
-    /* Safe city iterator needed as disaster may destroy city */
-    city_list_iterate_safe(pplayer->cities, pcity) {
-      int id = pcity->id;
+    n += city_list_size(pplayer->cities);
+  } players_iterate_end;
 
-      disaster_type_iterate(pdis) {
-        if (city_exist(id)) {
-          /* City survived earlier disasters. */
-          int probability = game.info.disasters * pdis->frequency;
-          int result = fc_rand(DISASTER_BASE_RARITY);
+  if (n > 0) {
+    /* Ids, as a disaster may destroy a city. */
+    int ids[n];
+    int i = 0;
 
-          if (result < probability)  {
-            if (can_disaster_happen(pdis, pcity)) {
-              apply_disaster(pcity, pdis);
-            }
-          }
+    players_iterate(pplayer) {
+      city_list_iterate(pplayer->cities, pcity) {
+        ids[i++] = pcity->id;
+      } city_list_iterate_end;
+    } players_iterate_end;
+
+    disaster_type_iterate(pdis) {
+      int probability = game.info.disasters * pdis->frequency;
+
+      /* Jump from one city whose roll succeeds to the next, rather
+       * than rolling for every city. */
+      for (i = fc_rand_gap(probability, DISASTER_BASE_RARITY); i < n;
+           i += 1 + fc_rand_gap(probability, DISASTER_BASE_RARITY)) {
+        struct city *pcity = game_city_by_number(ids[i]);
+
+        /* City survived earlier disasters. */
+        if (pcity != NULL && can_disaster_happen(pdis, pcity)) {
+          apply_disaster(pcity, pdis);
         }
-      } disaster_type_iterate_end;
-    } city_list_iterate_safe_end;
-  } players_iterate_end;
+      }
+    } disaster_type_iterate_end;
+  }
 }
 
 /**********************************************************************//**
@@ -3970,7 +4146,8 @@ static bool check_city_migrations_player(const struct player *pplayer)
 {
   char city_link_text[MAX_LEN_LINK];
   float best_city_player_score, best_city_world_score;
-  struct city *best_city_player, *best_city_world, *acity;
+  struct city *best_city_player, *best_city_world;
+  struct city_list *nearby = city_list_new();
   float score_from, score_tmp, weight;
   int dist, mgr_dist;
   bool internat = FALSE;
@@ -4007,13 +4184,14 @@ static bool check_city_migrations_player(const struct player *pplayer)
               player_name(pplayer));
 
     /* consider all cities within the maximal possible distance
-     * (= CITY_MAP_MAX_RADIUS + GAME_MAX_MGR_DISTANCE) */
-    iterate_outward(&(wld.map), city_tile(pcity),
-                    CITY_MAP_MAX_RADIUS + GAME_MAX_MGR_DISTANCE, ptile) {
-      acity = tile_city(ptile);
-
-      if (!acity || acity == pcity) {
-        /* no city or the city in the center */
+     * (= CITY_MAP_MAX_RADIUS + game.server.mgr_distance) */
+    city_list_clear(nearby);
+    mgr_index_nearby(city_tile(pcity),
+                     CITY_MAP_MAX_RADIUS + game.server.mgr_distance, nearby);
+
+    city_list_iterate(nearby, acity) {
+      if (acity == pcity) {
+        /* the city in the center */
         continue;
       }
 
@@ -4075,7 +4253,7 @@ static bool check_city_migrations_player(const struct player *pplayer)
                     best_city_world_score, score_from);
         }
       }
-    } iterate_outward_end;
+    } city_list_iterate_end;
 
     if (best_city_player_score > 0) {
       /* first, do the migration within one nation */
@@ -4119,6 +4297,8 @@ static bool check_city_migrations_player(const struct player *pplayer)
     }
   } city_list_iterate_safe_end;
 
+  city_list_destroy(nearby);
+
   return internat;
 }
 
@@ -209,6 +209,13 @@ int main(int argc, char *argv[])
       break;
     } else if ((option = get_option_malloc("--log", argv, &inx, argc, TRUE))) {
       srvarg.log_filename = option;
+    } else if ((option = get_option_malloc("--Queue-log", argv, &inx, argc, FALSE))) {
+      if (!str_to_int(option, &srvarg.log_queue_kb)
+          || srvarg.log_queue_kb < 0) {
+        showhelp = TRUE;
+        break;
+      }
+      free(option);
 #ifndef FREECIV_NDEBUG
     } else if (is_option("--Fatal", argv[inx])) {
       if (inx + 1 >= argc || '-' == argv[inx + 1][0]) {
@@ -224,6 +231,8 @@ int main(int argc, char *argv[])
 #endif /* FREECIV_NDEBUG */
     } else if ((option = get_option_malloc("--Ranklog", argv, &inx, argc, TRUE))) {
       srvarg.ranklog_filename = option;
+    } else if ((option = get_option_malloc("--Timings", argv, &inx, argc, TRUE))) {
+      srvarg.timings_filename = option;
     } else if (is_option("--keep", argv[inx])) {
       srvarg.metaconnection_persistent = TRUE;
       /* Implies --meta */
@@ -395,6 +404,11 @@ int main(int argc, char *argv[])
                 /* TRANS: "log" is exactly what user must type, do not translate. */
                 _("log FILE"),
                 _("Use FILE as logfile"));
+    cmdhelp_add(help, "Q",
+                /* TRANS: "Queue-log" is exactly what user must type, do not translate. */
+                _("Queue-log KB"),
+                _("Write the logfile from a background thread, queueing "
+                  "up to KB kilobytes of messages"));
     cmdhelp_add(help, "m", "meta",
                 _("Notify metaserver and send server's info"));
     cmdhelp_add(help, "M",
@@ -436,6 +450,11 @@ int main(int argc, char *argv[])
                 /* TRANS: "read" is exactly what user must type, do not translate. */
                 _("read FILE"),
                 _("Read startup script FILE"));
+    cmdhelp_add(help, "T",
+                /* TRANS: "Timings" is exactly what user must type, do not translate. */
+                _("Timings FILE"),
+                _("Profile the game and write a JSON timing summary to "
+                  "FILE when it ends"));
     cmdhelp_add(help, "R",
                 /* TRANS: "Ranklog" is exactly what user must type, do not translate. */
                 _("Ranklog FILE"),
@@ -102,7 +102,7 @@ static struct command commands[] = {
    /* TRANS: don't translate text in '' */
    N_("Show a list of:\n"
       " - the player colors,\n"
-      " - connections to the server,\n"
+      " - connections to the server and their delta cache use,\n"
       " - all player delegations,\n"
       " - your ignore list,\n"
       " - the list of defined map images,\n"
@@ -698,6 +698,20 @@ static struct command commands[] = {
    NULL, mapimg_help,
    CMD_ECHO_ADMINS, VCF_NONE, 50
   },
+  {"profile",  ALLOW_ADMIN,
+   /* TRANS: translate text between <> only */
+   N_("profile on|off|reset\n"
+      "profile show [<prefix>]\n"
+      "profile export <filename> [csv|json]"),
+   N_("Collect and report per turn server timings."),
+   N_("While profiling is on, the time spent in the phases of each turn "
+      "and some event counts are collected and kept for the last 64 "
+      "turns. 'show' lists the probes whose name starts with the given "
+      "prefix for the latest turn and on average, and 'export' writes "
+      "all recorded turns to a CSV (default) or JSON file. Times are "
+      "in milliseconds."), NULL,
+   CMD_ECHO_ADMINS, VCF_NONE, 50
+  },
   {"rfcstyle",	ALLOW_HACK,
    /* no translatable parameters */
    SYN_ORIG_("rfcstyle"),
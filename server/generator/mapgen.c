@@ -23,6 +23,7 @@
 /* utility */
 #include "bitvector.h"
 #include "fcintl.h"
+#include "fcthread.h"
 #include "log.h"
 #include "maphand.h" /* assign_continent_numbers(), MAP_NCONT */
 #include "mem.h"
@@ -3362,6 +3363,219 @@ static struct fair_tile *fair_map_island_new(int size, int startpos_num)
   return pisland;
 }
 
+/* Parameters shared by all the attempts of the fair islands generator. */
+struct fair_map_params {
+  struct terrain *deepest_ocean;
+  int players_per_island;
+  int teams_num;
+  int team_players_num;
+};
+
+/* One attempt of the fair islands generator. */
+struct fair_map_candidate {
+  const struct fair_map_params *params;
+  int islandmass1, islandmass2, islandmass3;
+  RANDOM_STATE rstate;
+  struct fair_tile *pmap;       /* NULL if the attempt failed. */
+};
+
+/**********************************************************************//**
+  Try to build the fair islands map with the given island sizes. Returns
+  NULL on failure.
+**************************************************************************/
+static struct fair_tile *
+fair_map_candidate_new(const struct fair_map_params *params,
+                       int islandmass1, int islandmass2, int islandmass3)
+{
+  struct fair_tile *pmap = fair_map_new();
+  struct fair_tile *pisland;
+  bool done = TRUE;
+  int i;
+
+  whole_map_iterate(&(wld.map), ptile) {
+    struct fair_tile *pftile = pmap + tile_index(ptile);
+
+    if (tile_terrain(ptile) != params->deepest_ocean) {
+      pftile->flags |= (FTF_ASSIGNED | FTF_NO_HUT);
+      adjc_iterate(&(wld.map), ptile, atile) {
+        struct fair_tile *aftile = pmap + tile_index(atile);
+
+        if (!(aftile->flags & FTF_ASSIGNED)
+            && tile_terrain(atile) == params->deepest_ocean) {
+          aftile->flags |= FTF_OCEAN;
+        }
+      } adjc_iterate_end;
+    }
+    pftile->pterrain = tile_terrain(ptile);
+    pftile->presource = tile_resource(ptile);
+    pftile->extras = *tile_extras(ptile);
+  } whole_map_iterate_end;
+
+  /* Create main player island. */
+  log_debug("Making main island.");
+  pisland = fair_map_island_new(islandmass1, params->players_per_island);
+
+  log_debug("Place main islands on the map.");
+  i = 0;
+
+  if (wld.map.server.team_placement != TEAM_PLACEMENT_DISABLED
+      && params->team_players_num > 0) {
+    /* Do team placement. On the heap, as this may run in a thread with
+     * a small stack. */
+    struct iter_index *outwards_indices
+      = fc_malloc(wld.map.num_iterate_outwards_indices
+                  * sizeof(*outwards_indices));
+    int start_x[params->teams_num], start_y[params->teams_num];
+    int dx = 0, dy = 0;
+    int j, k;
+
+    /* Build outwards_indices. */
+    memcpy(outwards_indices, wld.map.iterate_outwards_indices,
+           wld.map.num_iterate_outwards_indices
+           * sizeof(*outwards_indices));
+    switch (wld.map.server.team_placement) {
+    case TEAM_PLACEMENT_DISABLED:
+      fc_assert(wld.map.server.team_placement != TEAM_PLACEMENT_DISABLED);
+      break;
+    case TEAM_PLACEMENT_CLOSEST:
+    case TEAM_PLACEMENT_CONTINENT:
+      for (j = 0; j < wld.map.num_iterate_outwards_indices; j++) {
+        /* We want square distances for comparing. */
+        outwards_indices[j].dist =
+            map_vector_to_sq_distance(outwards_indices[j].dx,
+                                      outwards_indices[j].dy);
+      }
+      qsort(outwards_indices, wld.map.num_iterate_outwards_indices,
+            sizeof(outwards_indices[0]), fair_team_placement_closest);
+      break;
+    case TEAM_PLACEMENT_HORIZONTAL:
+      qsort(outwards_indices, wld.map.num_iterate_outwards_indices,
+            sizeof(outwards_indices[0]), fair_team_placement_horizontal);
+      break;
+    case TEAM_PLACEMENT_VERTICAL:
+      qsort(outwards_indices, wld.map.num_iterate_outwards_indices,
+            sizeof(outwards_indices[0]), fair_team_placement_vertical);
+      break;
+    }
+
+    /* Make start point for teams. */
+    if (current_topo_has_flag(TF_WRAPX)) {
+      dx = fc_rand(wld.map.xsize);
+    }
+    if (current_topo_has_flag(TF_WRAPY)) {
+      dy = fc_rand(wld.map.ysize);
+    }
+    for (j = 0; j < params->teams_num; j++) {
+      start_x[j] = (wld.map.xsize * (2 * j + 1)) / (2 * params->teams_num) + dx;
+      start_y[j] = (wld.map.ysize * (2 * j + 1)) / (2 * params->teams_num) + dy;
+      if (current_topo_has_flag(TF_WRAPX)) {
+        start_x[j] = FC_WRAP(start_x[j], wld.map.xsize);
+      }
+      if (current_topo_has_flag(TF_WRAPY)) {
+        start_y[j] = FC_WRAP(start_y[j], wld.map.ysize);
+      }
+    }
+    /* Randomize. */
+    array_shuffle(start_x, params->teams_num);
+    array_shuffle(start_y, params->teams_num);
+
+    j = 0;
+    teams_iterate(pteam) {
+      int members_count = player_list_size(team_members(pteam));
+      int team_id;
+      int x, y;
+
+      if (members_count <= 1) {
+        continue;
+      }
+      team_id = team_number(pteam);
+
+      NATIVE_TO_MAP_POS(&x, &y, start_x[j], start_y[j]);
+      log_verbose("Team %d (%s) will start on (%d, %d)",
+                  team_id, team_rule_name(pteam), x, y);
+
+      for (k = 0; k < members_count; k += params->players_per_island) {
+        if (!fair_map_place_island_team(pmap, x, y, pisland,
+                                        outwards_indices, team_id)) {
+          log_verbose("Failed to place island number %d for team %d (%s).",
+                      k, team_id, team_rule_name(pteam));
+          done = FALSE;
+          break;
+        }
+      }
+      if (!done) {
+        break;
+      }
+      i += k;
+      j++;
+    } teams_iterate_end;
+
+    fc_assert(!done || i == params->team_players_num);
+    free(outwards_indices);
+  }
+
+  if (done) {
+    /* Place last player islands. */
+    for (; i < player_count(); i += params->players_per_island) {
+      if (!fair_map_place_island_rand(pmap, pisland)) {
+        log_verbose("Failed to place island number %d.", i);
+        done = FALSE;
+        break;
+      }
+    }
+    fc_assert(!done || i == player_count());
+  }
+  fair_map_destroy(pisland);
+
+  if (done) {
+    log_debug("Create and place small islands on the map.");
+    for (i = 0; i < player_count(); i++) {
+      pisland = fair_map_island_new(islandmass2, 0);
+      if (!fair_map_place_island_rand(pmap, pisland)) {
+        log_verbose("Failed to place small island2 number %d.", i);
+        done = FALSE;
+        fair_map_destroy(pisland);
+        break;
+      }
+      fair_map_destroy(pisland);
+    }
+  }
+  if (done) {
+    for (i = 0; i < player_count(); i++) {
+      pisland = fair_map_island_new(islandmass3, 0);
+      if (!fair_map_place_island_rand(pmap, pisland)) {
+        log_verbose("Failed to place small island3 number %d.", i);
+        done = FALSE;
+        fair_map_destroy(pisland);
+        break;
+      }
+      fair_map_destroy(pisland);
+    }
+  }
+
+  if (!done) {
+    fair_map_destroy(pmap);
+    return NULL;
+  }
+
+  return pmap;
+}
+
+/**********************************************************************//**
+  Run an attempt of the fair islands generator, with its own random state.
+  May be called from another thread than the main one.
+**************************************************************************/
+static void fair_map_candidate_run(void *data)
+{
+  struct fair_map_candidate *pcand = data;
+
+  fc_rand_set_thread_state(&pcand->rstate);
+  pcand->pmap = fair_map_candidate_new(pcand->params, pcand->islandmass1,
+                                       pcand->islandmass2,
+                                       pcand->islandmass3);
+  fc_rand_set_thread_state(NULL);
+}
+
 /**********************************************************************//**
   Build a map using generator 'FAIR'.
 **************************************************************************/
@@ -3369,12 +3583,15 @@ static bool map_generate_fair_islands(void)
 {
   struct terrain *deepest_ocean
     = pick_ocean(TERRAIN_OCEAN_DEPTH_MAXIMUM, FALSE);
-  struct fair_tile *pmap, *pisland;
+  struct fair_tile *pmap = NULL;
   int playermass, islandmass1 , islandmass2, islandmass3;
   int min_island_size = wld.map.server.tinyisles ? 1 : 2;
   int players_per_island = 1;
   int teams_num = 0, team_players_num = 0, single_players_num = 0;
   int i, iter = CLIP(1, 100000 / map_num_tiles(), 10);
+  struct fair_map_params params;
+  struct fair_map_candidate candidates[iter];
+  int first, batch;
   bool done = FALSE;
 
   teams_iterate(pteam) {
@@ -3497,188 +3714,70 @@ static bool map_generate_fair_islands(void)
   log_debug("playermass=%d, islandmass1=%d, islandmass2=%d, islandmass3=%d",
             playermass, islandmass1, islandmass2, islandmass3);
 
-  pmap = fair_map_new();
-
-  while (--iter >= 0) {
-    done = TRUE;
-
-    whole_map_iterate(&(wld.map), ptile) {
-      struct fair_tile *pftile = pmap + tile_index(ptile);
-
-      if (tile_terrain(ptile) != deepest_ocean) {
-        pftile->flags |= (FTF_ASSIGNED | FTF_NO_HUT);
-        adjc_iterate(&(wld.map), ptile, atile) {
-          struct fair_tile *aftile = pmap + tile_index(atile);
-
-          if (!(aftile->flags & FTF_ASSIGNED)
-              && tile_terrain(atile) == deepest_ocean) {
-            aftile->flags |= FTF_OCEAN;
-          }
-        } adjc_iterate_end;
-      }
-      pftile->pterrain = tile_terrain(ptile);
-      pftile->presource = tile_resource(ptile);
-      pftile->extras = *tile_extras(ptile);
-    } whole_map_iterate_end;
-
-    /* Create main player island. */
-    log_debug("Making main island.");
-    pisland = fair_map_island_new(islandmass1, players_per_island);
-
-    log_debug("Place main islands on the map.");
-    i = 0;
-
-    if (wld.map.server.team_placement != TEAM_PLACEMENT_DISABLED
-        && team_players_num > 0) {
-      /* Do team placement. */
-      struct iter_index outwards_indices[wld.map.num_iterate_outwards_indices];
-      int start_x[teams_num], start_y[teams_num];
-      int dx = 0, dy = 0;
-      int j, k;
-
-      /* Build outwards_indices. */
-      memcpy(outwards_indices, wld.map.iterate_outwards_indices,
-             sizeof(outwards_indices));
-      switch (wld.map.server.team_placement) {
-      case TEAM_PLACEMENT_DISABLED:
-        fc_assert(wld.map.server.team_placement != TEAM_PLACEMENT_DISABLED);
-        break;
-      case TEAM_PLACEMENT_CLOSEST:
-      case TEAM_PLACEMENT_CONTINENT:
-        for (j = 0; j < wld.map.num_iterate_outwards_indices; j++) {
-          /* We want square distances for comparing. */
-          outwards_indices[j].dist =
-              map_vector_to_sq_distance(outwards_indices[j].dx,
-                                        outwards_indices[j].dy);
-        }
-        qsort(outwards_indices, wld.map.num_iterate_outwards_indices,
-              sizeof(outwards_indices[0]), fair_team_placement_closest);
-        break;
-      case TEAM_PLACEMENT_HORIZONTAL:
-        qsort(outwards_indices, wld.map.num_iterate_outwards_indices,
-              sizeof(outwards_indices[0]), fair_team_placement_horizontal);
-        break;
-      case TEAM_PLACEMENT_VERTICAL:
-        qsort(outwards_indices, wld.map.num_iterate_outwards_indices,
-              sizeof(outwards_indices[0]), fair_team_placement_vertical);
-        break;
-      }
-
-      /* Make start point for teams. */
-      if (current_topo_has_flag(TF_WRAPX)) {
-        dx = fc_rand(wld.map.xsize);
-      }
-      if (current_topo_has_flag(TF_WRAPY)) {
-        dy = fc_rand(wld.map.ysize);
-      }
-      for (j = 0; j < teams_num; j++) {
-        start_x[j] = (wld.map.xsize * (2 * j + 1)) / (2 * teams_num) + dx;
-        start_y[j] = (wld.map.ysize * (2 * j + 1)) / (2 * teams_num) + dy;
-        if (current_topo_has_flag(TF_WRAPX)) {
-          start_x[j] = FC_WRAP(start_x[j], wld.map.xsize);
-        }
-        if (current_topo_has_flag(TF_WRAPY)) {
-          start_y[j] = FC_WRAP(start_y[j], wld.map.ysize);
-        }
+  /* Every attempt gets its own random state, derived from the current
+   * one, so that they can be evaluated concurrently. The first attempt
+   * which succeeds wins, whatever the number of threads. */
+  params.deepest_ocean = deepest_ocean;
+  params.players_per_island = players_per_island;
+  params.teams_num = teams_num;
+  params.team_players_num = team_players_num;
+  {
+    RANDOM_TYPE seeds[iter];
+    RANDOM_STATE rstate;
+
+    for (i = 0; i < iter; i++) {
+      seeds[i] = fc_rand(MAX_UINT32);
+    }
+    rstate = fc_rand_state();
+    for (i = 0; i < iter; i++) {
+      fc_srand(seeds[i]);
+      candidates[i].rstate = fc_rand_state();
+      candidates[i].params = &params;
+      candidates[i].islandmass1 = islandmass1;
+      candidates[i].islandmass2 = islandmass2;
+      candidates[i].islandmass3 = islandmass3;
+      candidates[i].pmap = NULL;
+
+      /* Decrease land mass of the next attempt, for better chances. */
+      islandmass1 = MAX((islandmass1 * 99) / 100, min_island_size);
+      islandmass2 = MAX((islandmass2 * 99) / 100, min_island_size);
+      islandmass3 = MAX((islandmass3 * 99) / 100, min_island_size);
+    }
+    fc_rand_set_state(rstate);
+  }
+
+  fc_rand_thread_states_init();
+  batch = CLIP(1, wld.map.server.mapgen_threads, iter);
+  for (first = 0; first < iter && NULL == pmap; first += batch) {
+    fc_thread threads[batch];
+    bool started[batch];
+    int last = MIN(first + batch, iter);
+
+    /* The first attempt of the batch is run by the calling thread. */
+    for (i = first + 1; i < last; i++) {
+      started[i - first] = (0 == fc_thread_start(&threads[i - first],
+                                                 fair_map_candidate_run,
+                                                 candidates + i));
+      if (!started[i - first]) {
+        fair_map_candidate_run(candidates + i);
       }
-      /* Randomize. */
-      array_shuffle(start_x, teams_num);
-      array_shuffle(start_y, teams_num);
-
-      j = 0;
-      teams_iterate(pteam) {
-        int members_count = player_list_size(team_members(pteam));
-        int team_id;
-        int x, y;
-
-        if (members_count <= 1) {
-          continue;
-        }
-        team_id = team_number(pteam);
-
-        NATIVE_TO_MAP_POS(&x, &y, start_x[j], start_y[j]);
-        log_verbose("Team %d (%s) will start on (%d, %d)",
-                    team_id, team_rule_name(pteam), x, y);
-
-        for (k = 0; k < members_count; k += players_per_island) {
-          if (!fair_map_place_island_team(pmap, x, y, pisland,
-                                          outwards_indices, team_id)) {
-            log_verbose("Failed to place island number %d for team %d (%s).",
-                        k, team_id, team_rule_name(pteam));
-            done = FALSE;
-            break;
-          }
-        }
-        if (!done) {
-          break;
-        }
-        i += k;
-        j++;
-      } teams_iterate_end;
-
-      fc_assert(!done || i == team_players_num);
     }
-
-    if (done) {
-      /* Place last player islands. */
-      for (; i < player_count(); i += players_per_island) {
-        if (!fair_map_place_island_rand(pmap, pisland)) {
-          log_verbose("Failed to place island number %d.", i);
-          done = FALSE;
-          break;
-        }
+    fair_map_candidate_run(candidates + first);
+    for (i = first + 1; i < last; i++) {
+      if (started[i - first]) {
+        fc_thread_wait(&threads[i - first]);
       }
-      fc_assert(!done || i == player_count());
     }
-    fair_map_destroy(pisland);
 
-    if (done) {
-      log_debug("Create and place small islands on the map.");
-      for (i = 0; i < player_count(); i++) {
-        pisland = fair_map_island_new(islandmass2, 0);
-        if (!fair_map_place_island_rand(pmap, pisland)) {
-          log_verbose("Failed to place small island2 number %d.", i);
-          done = FALSE;
-          fair_map_destroy(pisland);
-          break;
-        }
-        fair_map_destroy(pisland);
+    for (i = first; i < last; i++) {
+      if (NULL == pmap) {
+        pmap = candidates[i].pmap;
+      } else if (NULL != candidates[i].pmap) {
+        fair_map_destroy(candidates[i].pmap);
       }
     }
-    if (done) {
-      for (i = 0; i < player_count(); i++) {
-        pisland = fair_map_island_new(islandmass3, 0);
-        if (!fair_map_place_island_rand(pmap, pisland)) {
-          log_verbose("Failed to place small island3 number %d.", i);
-          done = FALSE;
-          fair_map_destroy(pisland);
-          break;
-        }
-        fair_map_destroy(pisland);
-      }
-    }
-
-    if (done) {
-      break;
-    }
-
-    fair_map_destroy(pmap);
-    pmap = fair_map_new();
-
-    /* Decrease land mass, for better chances. */
-    islandmass1 = (islandmass1 * 99) / 100;
-    if (islandmass1 < min_island_size) {
-      islandmass1 = min_island_size;
-    }
-    islandmass2 = (islandmass2 * 99) / 100;
-    if (islandmass2 < min_island_size) {
-      islandmass2 = min_island_size;
-    }
-    islandmass3 = (islandmass3 * 99) / 100;
-    if (islandmass3 < min_island_size) {
-      islandmass3 = min_island_size;
-    }
   }
+  done = (NULL != pmap);
 
   if (!done) {
     log_verbose("Failed to create map after %d iterations.", iter);
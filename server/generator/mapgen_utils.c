@@ -16,6 +16,7 @@
 
 /* utility */
 #include "fcintl.h"
+#include "fcthread.h"
 #include "log.h"
 #include "rand.h"
 #include "support.h"            /* bool type */
@@ -111,6 +112,229 @@ void set_placed_near_pos(struct tile *ptile, int dist)
   } square_iterate_end;
 }
 
+/* Do not bother starting threads for less rows than this per thread. */
+#define MAPGEN_MIN_ROWS_PER_THREAD 16
+
+struct mapgen_rows_job {
+  mapgen_rows_func_t func;
+  void *data;
+  int nat_y0, nat_y1;
+};
+
+/**********************************************************************//**
+  Number of bands the rows are split in by mapgen_process_rows(). The
+  band number 'i' starts at row (ysize * i / bands).
+**************************************************************************/
+static int mapgen_row_bands(void)
+{
+  int bands = MIN(wld.map.server.mapgen_threads,
+                  wld.map.ysize / MAPGEN_MIN_ROWS_PER_THREAD);
+
+  return MAX(1, bands);
+}
+
+/**********************************************************************//**
+  Number of the band starting at the given row.
+**************************************************************************/
+static int mapgen_row_band(int nat_y0)
+{
+  int bands = mapgen_row_bands();
+  int band = 0;
+
+  while (band + 1 < bands && wld.map.ysize * (band + 1) / bands <= nat_y0) {
+    band++;
+  }
+  return band;
+}
+
+/**********************************************************************//**
+  Thread function processing a band of rows.
+**************************************************************************/
+static void mapgen_rows_thread(void *arg)
+{
+  struct mapgen_rows_job *job = arg;
+
+  job->func(job->nat_y0, job->nat_y1, job->data);
+}
+
+/**********************************************************************//**
+  Call func for all the native rows of the map, split in contiguous bands
+  processed by up to 'mapgen_threads' threads. Returns when all rows have
+  been processed.
+
+  The function must only write the parts of the data belonging to its own
+  rows, and must not use the random number generator, so the result does
+  not depend on the number of threads.
+**************************************************************************/
+void mapgen_process_rows(mapgen_rows_func_t func, void *data)
+{
+  struct mapgen_rows_job jobs[MAP_MAX_MAPGEN_THREADS];
+  fc_thread threads[MAP_MAX_MAPGEN_THREADS];
+  bool started[MAP_MAX_MAPGEN_THREADS];
+  int ysize = wld.map.ysize;
+  int num_jobs = mapgen_row_bands();
+  int i;
+
+  if (1 == num_jobs) {
+    func(0, ysize, data);
+    return;
+  }
+
+  for (i = 0; i < num_jobs; i++) {
+    jobs[i].func = func;
+    jobs[i].data = data;
+    jobs[i].nat_y0 = ysize * i / num_jobs;
+    jobs[i].nat_y1 = ysize * (i + 1) / num_jobs;
+  }
+
+  /* The first band is done by the calling thread. */
+  for (i = 1; i < num_jobs; i++) {
+    started[i] = (0 == fc_thread_start(&threads[i], mapgen_rows_thread,
+                                       &jobs[i]));
+    if (!started[i]) {
+      mapgen_rows_thread(&jobs[i]);
+    }
+  }
+  mapgen_rows_thread(&jobs[0]);
+  for (i = 1; i < num_jobs; i++) {
+    if (started[i]) {
+      fc_thread_wait(&threads[i]);
+    }
+  }
+}
+
+struct int_map_range {
+  const int *int_map;
+  int *minval, *maxval;         /* Per row results. */
+};
+
+/**********************************************************************//**
+  Find the minimum and maximum values of the given rows of an integer map.
+**************************************************************************/
+static void int_map_range_rows(int nat_y0, int nat_y1, void *data)
+{
+  const struct int_map_range *range = data;
+  const int xsize = wld.map.xsize;
+  int x, y;
+
+  for (y = nat_y0; y < nat_y1; y++) {
+    const int *row = range->int_map + y * xsize;
+    int minval = row[0], maxval = row[0];
+
+    for (x = 1; x < xsize; x++) {
+      minval = MIN(minval, row[x]);
+      maxval = MAX(maxval, row[x]);
+    }
+    range->minval[y] = minval;
+    range->maxval[y] = maxval;
+  }
+}
+
+struct int_map_levels {
+  int *int_map;
+  int minval;
+  int size;                     /* Number of different values. */
+  int *frequencies;             /* 'size' counters per band of rows. */
+  const int *levels;
+};
+
+/**********************************************************************//**
+  Count the values of the given rows of an integer map. Each band of rows
+  uses its own counters.
+**************************************************************************/
+static void int_map_count_rows(int nat_y0, int nat_y1, void *data)
+{
+  const struct int_map_levels *lvl = data;
+  const int xsize = wld.map.xsize;
+  int *frequencies = lvl->frequencies
+                     + (size_t) mapgen_row_band(nat_y0) * lvl->size;
+  const int *row = lvl->int_map + nat_y0 * xsize;
+  const int *end = lvl->int_map + nat_y1 * xsize;
+
+  memset(frequencies, 0, lvl->size * sizeof(*frequencies));
+  for (; row < end; row++) {
+    frequencies[*row - lvl->minval]++;
+  }
+}
+
+/**********************************************************************//**
+  Replace the values of the given rows of an integer map by their levels.
+**************************************************************************/
+static void int_map_level_rows(int nat_y0, int nat_y1, void *data)
+{
+  const struct int_map_levels *lvl = data;
+  const int *levels = lvl->levels - lvl->minval;
+  int *row = lvl->int_map + nat_y0 * wld.map.xsize;
+  int *end = lvl->int_map + nat_y1 * wld.map.xsize;
+
+  for (; row < end; row++) {
+    *row = levels[*row];
+  }
+}
+
+/**********************************************************************//**
+  adjust_int_map_filtered() for the whole map. All the passes work on
+  the contiguous plane, split by rows. The counts are integers, so
+  summing the per band counters gives the same result whatever the
+  number of threads.
+**************************************************************************/
+static void adjust_int_map_whole(int *int_map, int int_map_max)
+{
+  const int ysize = wld.map.ysize;
+  const int total = MAP_INDEX_SIZE;
+  const int bands = mapgen_row_bands();
+  struct int_map_range range;
+  struct int_map_levels lvl;
+  int *levels;
+  int minval, maxval, count = 0;
+  int i, y;
+
+  if (0 == total) {
+    return;
+  }
+
+  range.int_map = int_map;
+  range.minval = fc_malloc(2 * ysize * sizeof(*range.minval));
+  range.maxval = range.minval + ysize;
+  mapgen_process_rows(int_map_range_rows, &range);
+  minval = range.minval[0];
+  maxval = range.maxval[0];
+  for (y = 1; y < ysize; y++) {
+    minval = MIN(minval, range.minval[y]);
+    maxval = MAX(maxval, range.maxval[y]);
+  }
+  free(range.minval);
+
+  lvl.int_map = int_map;
+  lvl.minval = minval;
+  lvl.size = 1 + maxval - minval;
+  lvl.frequencies = fc_malloc((size_t) bands * lvl.size
+                              * sizeof(*lvl.frequencies));
+  mapgen_process_rows(int_map_count_rows, &lvl);
+
+  /* Sum the counters of the bands. */
+  levels = fc_calloc(lvl.size, sizeof(*levels));
+  for (y = 0; y < bands; y++) {
+    const int *frequencies = lvl.frequencies + (size_t) y * lvl.size;
+
+    for (i = 0; i < lvl.size; i++) {
+      levels[i] += frequencies[i];
+    }
+  }
+  free(lvl.frequencies);
+
+  /* Create the linearize function as "incremental" frequencies */
+  for (i = 0; i < lvl.size; i++) {
+    count += levels[i];
+    levels[i] = (count * int_map_max) / total;
+  }
+
+  /* Apply the linearize function */
+  lvl.levels = levels;
+  mapgen_process_rows(int_map_level_rows, &lvl);
+  free(levels);
+}
+
 /**********************************************************************//**
   Change the values of the integer map, so that they contain ranking of each 
   tile scaled to [0 .. int_map_max].
@@ -126,6 +350,11 @@ void adjust_int_map_filtered(int *int_map, int int_map_max, void *data,
   int minval = 0, maxval = 0, total = 0;
   bool first = TRUE;
 
+  if (NULL == filter) {
+    adjust_int_map_whole(int_map, int_map_max);
+    return;
+  }
+
   /* Determine minimum and maximum value. */
   whole_map_iterate_filtered(ptile, data, filter) {
     if (first) {
@@ -179,51 +408,148 @@ bool is_normal_nat_pos(int x, int y)
   return is_normal_map_pos(x, y);
 }
 
+struct smooth_pass {
+  const int *source_map;
+  int *target_map;
+  const float *weight;
+  bool x_axis;
+  bool zeroes_at_edges;
+};
+
+/**********************************************************************//**
+  Add weight * source[i + offset] to sum[i] for all i in [0, len[. Out of
+  range elements are wrapped if 'wrap' is set, and skipped else.
+**************************************************************************/
+static inline void smooth_accumulate(float *sum, const int *source,
+                                     int offset, int len, bool wrap,
+                                     float weight)
+{
+  int begin = MAX(0, -offset), end = MIN(len, len - offset);
+  int i;
+
+  /* Plain contiguous part, the compiler can vectorize it. */
+  for (i = begin; i < end; i++) {
+    sum[i] += weight * source[i + offset];
+  }
+  if (wrap) {
+    for (i = 0; i < MIN(begin, len); i++) {
+      sum[i] += weight * source[FC_WRAP(i + offset, len)];
+    }
+    for (i = MAX(end, 0); i < len; i++) {
+      sum[i] += weight * source[FC_WRAP(i + offset, len)];
+    }
+  }
+}
+
+/**********************************************************************//**
+  Smooth the given rows along one axis; see smooth_int_map(). For every
+  tile, the weighted values are summed in the same order as the single
+  tile version did, so the result is the same to the bit.
+**************************************************************************/
+static void smooth_int_map_rows(int nat_y0, int nat_y1, void *data)
+{
+  const struct smooth_pass *pass = data;
+  const int xsize = wld.map.xsize, ysize = wld.map.ysize;
+  const bool wrapx = current_topo_has_flag(TF_WRAPX);
+  const bool wrapy = current_topo_has_flag(TF_WRAPY);
+  float *N = fc_malloc(2 * xsize * sizeof(*N));
+  float *D = N + xsize;
+  int i, x, y;
+
+  if (pass->x_axis) {
+    /* The divisors only depend on the column. */
+    for (x = 0; x < xsize; x++) {
+      D[x] = 0;
+      for (i = -2; i <= 2; i++) {
+        if (wrapx || (x + i >= 0 && x + i < xsize)) {
+          D[x] += pass->weight[i + 2];
+        }
+      }
+    }
+  }
+
+  for (y = nat_y0; y < nat_y1; y++) {
+    int *target = pass->target_map + y * xsize;
+
+    for (x = 0; x < xsize; x++) {
+      N[x] = 0;
+    }
+
+    if (pass->x_axis) {
+      const int *source = pass->source_map + y * xsize;
+
+      for (i = -2; i <= 2; i++) {
+        smooth_accumulate(N, source, i, xsize, wrapx, pass->weight[i + 2]);
+      }
+    } else {
+      float Dy = 0;
+
+      for (i = -2; i <= 2; i++) {
+        int sy = y + i;
+
+        if (sy < 0 || sy >= ysize) {
+          if (!wrapy) {
+            continue;
+          }
+          sy = FC_WRAP(sy, ysize);
+        }
+        Dy += pass->weight[i + 2];
+        smooth_accumulate(N, pass->source_map + sy * xsize, 0, xsize,
+                          FALSE, pass->weight[i + 2]);
+      }
+      for (x = 0; x < xsize; x++) {
+        D[x] = Dy;
+      }
+    }
+
+    if (pass->zeroes_at_edges) {
+      for (x = 0; x < xsize; x++) {
+        target[x] = N[x];
+      }
+    } else {
+      for (x = 0; x < xsize; x++) {
+        target[x] = N[x] / D[x];
+      }
+    }
+  }
+
+  free(N);
+}
+
 /**********************************************************************//**
   Apply a Gaussian diffusion filter on the map. The size of the map is
   MAP_INDEX_SIZE and the map is indexed by native_pos_to_index function.
   If zeroes_at_edges is set, any unreal position on diffusion has 0 value
   if zeroes_at_edges in unset the unreal position are not counted.
+
+  Works directly on the native rows of the map, possibly in several
+  threads (see mapgen_process_rows()).
 **************************************************************************/
 void smooth_int_map(int *int_map, bool zeroes_at_edges)
 {
   static const float weight_standard[5] = { 0.13, 0.19, 0.37, 0.19, 0.13 };
   static const float weight_isometric[5] = { 0.15, 0.21, 0.29, 0.21, 0.15 };
-  const float *weight;
-  bool axe = TRUE;
-  int *target_map, *source_map;
-  int *alt_int_map = fc_calloc(MAP_INDEX_SIZE, sizeof(*alt_int_map));
+  struct smooth_pass pass;
+  int *alt_int_map;
 
   fc_assert_ret(NULL != int_map);
 
-  weight = weight_standard;
-  target_map = alt_int_map;
-  source_map = int_map;
-
-  do {
-    whole_map_iterate(&(wld.map), ptile) {
-      float N = 0, D = 0;
-
-      axis_iterate(&(wld.map), ptile, pnear, i, 2, axe) {
-        D += weight[i + 2];
-        N += weight[i + 2] * source_map[tile_index(pnear)];
-      } axis_iterate_end;
-      if (zeroes_at_edges) {
-        D = 1;
-      }
-      target_map[tile_index(ptile)] = (float)N / D;
-    } whole_map_iterate_end;
-
-    if (MAP_IS_ISOMETRIC) {
-      weight = weight_isometric;
-    }
-
-    axe = !axe;
+  alt_int_map = fc_malloc(MAP_INDEX_SIZE * sizeof(*alt_int_map));
+  pass.zeroes_at_edges = zeroes_at_edges;
 
-    source_map = alt_int_map;
-    target_map = int_map;
+  /* Along the X axis first... */
+  pass.source_map = int_map;
+  pass.target_map = alt_int_map;
+  pass.weight = weight_standard;
+  pass.x_axis = TRUE;
+  mapgen_process_rows(smooth_int_map_rows, &pass);
 
-  } while (!axe);
+  /* ...then along the Y axis. */
+  pass.source_map = alt_int_map;
+  pass.target_map = int_map;
+  pass.weight = (MAP_IS_ISOMETRIC ? weight_isometric : weight_standard);
+  pass.x_axis = FALSE;
+  mapgen_process_rows(smooth_int_map_rows, &pass);
 
   FC_FREE(alt_int_map);
 }
@@ -447,6 +773,7 @@ int get_ocean_size(Continent_id id)
 void assign_continent_numbers(void)
 {
   /* Initialize */
+  wld.map.server.continents_stamp++;
   wld.map.num_continents = 0;
   wld.map.num_oceans = 0;
 
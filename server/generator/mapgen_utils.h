@@ -105,6 +105,10 @@ void adjust_int_map_filtered(int *int_map, int int_map_max, void *data,
 	     (bool (*)(const struct tile *ptile, const void *data) )NULL)
 void smooth_int_map(int *int_map, bool zeroes_at_edges);
 
+/* Row parallel processing of the map planes */
+typedef void (*mapgen_rows_func_t)(int nat_y0, int nat_y1, void *data);
+void mapgen_process_rows(mapgen_rows_func_t func, void *data);
+
 /* placed_map tool */
 void create_placed_map(void);
 void destroy_placed_map(void);
@@ -111,6 +111,41 @@ void destroy_tmap(void)
   temperature_map = NULL;
 }
 
+/**********************************************************************//**
+  Compute the base temperature of the given native rows; see create_tmap().
+**************************************************************************/
+static void create_tmap_rows(int nat_y0, int nat_y1, void *data)
+{
+  const bool real = *(const bool *) data;
+  int x, y;
+
+  for (y = nat_y0; y < nat_y1; y++) {
+    for (x = 0; x < wld.map.xsize; x++) {
+      const struct tile *ptile = native_pos_to_tile(&(wld.map), x, y);
+      /* the base temperature is equal to base map_colatitude */
+      int t = map_colatitude(ptile);
+
+      if (!real) {
+        tmap(ptile) = t;
+      } else {
+        /* high land can be 30% cooler */
+        float height = - 0.3 * MAX(0, hmap(ptile) - hmap_shore_level) 
+            / (hmap_max_level - hmap_shore_level); 
+        /* near ocean temperature can be 15% more "temperate" */
+        float temperate = (0.15 * (wld.map.server.temperature / 100 - t
+                                   / MAX_COLATITUDE)
+                           * 2 * MIN(50, count_terrain_class_near_tile(ptile,
+                                                                       FALSE,
+                                                                       TRUE,
+                                                                       TC_OCEAN))
+                           / 100);
+
+        tmap(ptile) =  t * (1.0 + temperate) * (1.0 + height);
+      }
+    }
+  }
+}
+
 /**********************************************************************//**
   Initialize the temperature_map
   if arg is FALSE, create a dummy tmap == map_colatitude
@@ -126,28 +161,7 @@ void create_tmap(bool real)
   fc_assert_ret(NULL == temperature_map);
 
   temperature_map = fc_malloc(sizeof(*temperature_map) * MAP_INDEX_SIZE);
-  whole_map_iterate(&(wld.map), ptile) {
-    /* the base temperature is equal to base map_colatitude */
-    int t = map_colatitude(ptile);
-
-    if (!real) {
-      tmap(ptile) = t;
-    } else {
-      /* high land can be 30% cooler */
-      float height = - 0.3 * MAX(0, hmap(ptile) - hmap_shore_level) 
-	  / (hmap_max_level - hmap_shore_level); 
-      /* near ocean temperature can be 15% more "temperate" */
-      float temperate = (0.15 * (wld.map.server.temperature / 100 - t
-                                 / MAX_COLATITUDE)
-                         * 2 * MIN(50, count_terrain_class_near_tile(ptile,
-                                                                     FALSE,
-                                                                     TRUE,
-                                                                     TC_OCEAN))
-                         / 100);
-
-      tmap(ptile) =  t * (1.0 + temperate) * (1.0 + height);
-    }
-  } whole_map_iterate_end;
+  mapgen_process_rows(create_tmap_rows, &real);
   /* adjust to get well sizes frequencies */
   /* Notice: if colatitude is loaded from a scenario never call adjust.
              Scenario may have an odd colatitude distribution and adjust will
@@ -55,11 +55,23 @@
 
 #include "maphand.h"
 
+/* Amount of data in the send buffer of a connection up to which the
+ * initial map is streamed to it. */
+#define MAP_SYNC_BUFFERED (MAX_LEN_BUFFER / 8)
+
 #define MAXIMUM_CLAIMED_OCEAN_SIZE (20)
 
 /* Suppress send_tile_info() during game_load() */
 static bool send_tile_suppressed = FALSE;
 
+/* Tiles whose knowledge update is postponed until the outermost
+ * tile_knowledge_journal_end(). */
+static struct {
+  int depth;
+  struct dbv pending;           /* Indexed by tile_index(). */
+  struct tile_list *tiles;      /* In order of first change. */
+} tile_journal = { 0, };
+
 static void player_tile_init(struct tile *ptile, struct player *pplayer);
 static void player_tile_free(struct tile *ptile, struct player *pplayer);
 static void give_tile_info_from_player_to_player(struct player *pfrom,
@@ -69,6 +81,7 @@ static void shared_vision_change_seen(struct player *pplayer,
                                       struct tile *ptile,
                                       const v_radius_t change,
                                       bool can_reveal_tiles);
+static void really_update_tile_knowledge(struct tile *ptile);
 static void map_change_seen(struct player *pplayer,
                             struct tile *ptile,
                             const v_radius_t change,
@@ -135,6 +148,8 @@ void climate_change(bool warming, int effect)
   log_verbose("Climate change: %s (%d)",
               warming ? "Global warming" : "Nuclear winter", effect);
 
+  tile_knowledge_journal_begin();
+
   while (effect > 0 && (k--) > 0) {
     struct terrain *old, *candidates[2], *new;
     struct tile *ptile;
@@ -213,6 +228,8 @@ void climate_change(bool warming, int effect)
       effect--;
     }
   }
+
+  tile_knowledge_journal_end();
 }
 
 /**********************************************************************//**
@@ -449,6 +466,95 @@ void send_all_known_tiles(struct conn_list *dest)
   flush_packets();
 }
 
+/**********************************************************************//**
+  Send the whole map to each connection in dest in the background:
+  the tiles are produced by send_known_tiles_continue() from the main
+  loop, as fast as each connection takes them, instead of waiting here
+  for the slowest one. Tile changes meanwhile are sent as usual; the
+  stream always sends the current state of a tile.
+
+  The tiles with units and with cities the connection knows of are sent
+  right away, so that the cities and units sent next are on known tiles.
+**************************************************************************/
+void send_known_tiles_stream(struct conn_list *dest)
+{
+  struct tile_list *tiles = tile_list_new();
+
+  /* Tiles with units or with a city any player knows of. */
+  whole_map_iterate(&(wld.map), ptile) {
+    bool site = (0 < unit_list_size(ptile->units)
+                 || NULL != tile_city(ptile));
+
+    if (!site) {
+      players_iterate(pplayer) {
+        if (NULL != map_get_player_site(ptile, pplayer)) {
+          site = TRUE;
+          break;
+        }
+      } players_iterate_end;
+    }
+
+    if (site) {
+      tile_list_append(tiles, ptile);
+    }
+  } whole_map_iterate_end;
+
+  conn_list_do_buffer(dest);
+  conn_list_iterate(dest, pconn) {
+    struct player *pplayer = pconn->playing;
+
+    if (NULL == pplayer && !pconn->observer) {
+      continue;
+    }
+
+    tile_list_iterate(tiles, ptile) {
+      if (0 < unit_list_size(ptile->units)
+          || (NULL != pplayer
+              ? NULL != map_get_player_site(ptile, pplayer)
+              : NULL != tile_city(ptile))) {
+        send_tile_info(pconn->self, ptile, FALSE);
+      }
+    } tile_list_iterate_end;
+  } conn_list_iterate_end;
+  conn_list_do_unbuffer(dest);
+  tile_list_destroy(tiles);
+
+  conn_list_iterate(dest, pconn) {
+    pconn->server.map_sync = 0;
+    send_known_tiles_continue(pconn);
+  } conn_list_iterate_end;
+}
+
+/**********************************************************************//**
+  Send map rows of the stream started by send_known_tiles_stream() until
+  the send buffer of the connection holds MAP_SYNC_BUFFERED bytes or the
+  whole map has been sent.
+**************************************************************************/
+void send_known_tiles_continue(struct connection *pconn)
+{
+  if (S_S_INITIAL == server_state()) {
+    /* No map any more. */
+    pconn->server.map_sync = -1;
+    return;
+  }
+
+  while (0 <= pconn->server.map_sync
+         && pconn->used && !pconn->server.is_closing
+         && pconn->send_buffer->ndata < MAP_SYNC_BUFFERED) {
+    int end = MIN(pconn->server.map_sync + wld.map.xsize,
+                  MAP_INDEX_SIZE);
+    int idx;
+
+    conn_compression_freeze(pconn);
+    for (idx = pconn->server.map_sync; idx < end; idx++) {
+      send_tile_info(pconn->self, index_to_tile(&(wld.map), idx), FALSE);
+    }
+    conn_compression_thaw(pconn);
+
+    pconn->server.map_sync = (end < MAP_INDEX_SIZE ? end : -1);
+  }
+}
+
 /**********************************************************************//**
   Suppress send_tile_info() during game_load()
 **************************************************************************/
@@ -1101,7 +1207,10 @@ void change_playertile_site(struct player_tile *ptile,
 **************************************************************************/
 void map_set_known(struct tile *ptile, struct player *pplayer)
 {
-  dbv_set(&pplayer->tile_known, tile_index(ptile));
+  if (!dbv_isset(&pplayer->tile_known, tile_index(ptile))) {
+    dbv_set(&pplayer->tile_known, tile_index(ptile));
+    player_known_tile_changed(pplayer, ptile, TRUE);
+  }
 }
 
 /**********************************************************************//**
@@ -1109,7 +1218,19 @@ void map_set_known(struct tile *ptile, struct player *pplayer)
 **************************************************************************/
 void map_clear_known(struct tile *ptile, struct player *pplayer)
 {
-  dbv_clr(&pplayer->tile_known, tile_index(ptile));
+  if (dbv_isset(&pplayer->tile_known, tile_index(ptile))) {
+    dbv_clr(&pplayer->tile_known, tile_index(ptile));
+    player_known_tile_changed(pplayer, ptile, FALSE);
+  }
+}
+
+/**********************************************************************//**
+  Clear known status of all tiles.
+**************************************************************************/
+void map_clear_all_known(struct player *pplayer)
+{
+  dbv_clr_all(&pplayer->tile_known);
+  player_known_counts_reset(pplayer);
 }
 
 /**********************************************************************//**
@@ -1153,6 +1274,7 @@ void player_map_init(struct player *pplayer)
   } whole_map_iterate_end;
 
   dbv_init(&pplayer->tile_known, MAP_INDEX_SIZE);
+  player_known_counts_reset(pplayer);
 }
 
 /**********************************************************************//**
@@ -1172,6 +1294,7 @@ void player_map_free(struct player *pplayer)
   pplayer->server.private_map = NULL;
 
   dbv_free(&pplayer->tile_known);
+  player_known_counts_free(pplayer);
 }
 
 /**********************************************************************//**
@@ -1361,6 +1484,9 @@ bool update_player_tile_knowledge(struct player *pplayer, struct tile *ptile)
   for the tile, since these are the only values held in the playermap.
 
   A tile's owner always can see terrain changes in his or her territory.
+
+  Between tile_knowledge_journal_begin() and tile_knowledge_journal_end()
+  the tile is only recorded, and updated once when the journal closes.
 **************************************************************************/
 void update_tile_knowledge(struct tile *ptile)
 {
@@ -1368,6 +1494,62 @@ void update_tile_knowledge(struct tile *ptile)
     return;
   }
 
+  if (0 < tile_journal.depth) {
+    int idx = tile_index(ptile);
+
+    if (!dbv_isset(&tile_journal.pending, idx)) {
+      dbv_set(&tile_journal.pending, idx);
+      tile_list_append(tile_journal.tiles, ptile);
+    }
+    return;
+  }
+
+  really_update_tile_knowledge(ptile);
+}
+
+/**********************************************************************//**
+  Start collecting the tiles passed to update_tile_knowledge(). Tiles
+  changed several times before the matching tile_knowledge_journal_end()
+  are compared and sent only once. Calls may be nested.
+**************************************************************************/
+void tile_knowledge_journal_begin(void)
+{
+  if (0 == tile_journal.depth++) {
+    dbv_init(&tile_journal.pending, map_num_tiles());
+    tile_journal.tiles = tile_list_new();
+  }
+}
+
+/**********************************************************************//**
+  Close a journal opened with tile_knowledge_journal_begin(). Closing the
+  outermost one updates the knowledge of every recorded tile.
+**************************************************************************/
+void tile_knowledge_journal_end(void)
+{
+  struct tile_list *tiles;
+
+  fc_assert_ret(0 < tile_journal.depth);
+
+  if (0 < --tile_journal.depth) {
+    return;
+  }
+
+  tiles = tile_journal.tiles;
+  tile_journal.tiles = NULL;
+  dbv_free(&tile_journal.pending);
+
+  tile_list_iterate(tiles, ptile) {
+    really_update_tile_knowledge(ptile);
+  } tile_list_iterate_end;
+  tile_list_destroy(tiles);
+}
+
+/**********************************************************************//**
+  Update the knowledge of the tile for everybody who sees it, sending it
+  to everyone whose info is changed.
+**************************************************************************/
+static void really_update_tile_knowledge(struct tile *ptile)
+{
   /* Players */
   players_iterate(pplayer) {
     if (map_is_known_and_seen(ptile, pplayer, V_MAIN)) {
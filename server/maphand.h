@@ -54,6 +54,8 @@ void give_seamap_from_player_to_player(struct player *pfrom, struct player *pdes
 void give_citymap_from_player_to_player(struct city *pcity,
 					struct player *pfrom, struct player *pdest);
 void send_all_known_tiles(struct conn_list *dest);
+void send_known_tiles_stream(struct conn_list *dest);
+void send_known_tiles_continue(struct connection *pconn);
 
 bool send_tile_suppression(bool now);
 void send_tile_info(struct conn_list *dest, struct tile *ptile,
@@ -79,6 +81,7 @@ bool map_is_known_and_seen(const struct tile *ptile,
 bool map_is_known(const struct tile *ptile, const struct player *pplayer);
 void map_set_known(struct tile *ptile, struct player *pplayer);
 void map_clear_known(struct tile *ptile, struct player *pplayer);
+void map_clear_all_known(struct player *pplayer);
 void map_know_and_see_all(struct player *pplayer);
 void show_map_to_all(void);
 
@@ -94,6 +97,8 @@ struct player_tile *map_get_player_tile(const struct tile *ptile,
 					const struct player *pplayer);
 bool update_player_tile_knowledge(struct player *pplayer,struct tile *ptile);
 void update_tile_knowledge(struct tile *ptile);
+void tile_knowledge_journal_begin(void);
+void tile_knowledge_journal_end(void);
 void update_player_tile_last_seen(struct player *pplayer, struct tile *ptile);
 
 void give_shared_vision(struct player *pfrom, struct player *pto);
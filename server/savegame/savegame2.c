@@ -2309,7 +2309,7 @@ static void sg_load_map_known(struct loaddata *loading)
     }
 
     players_iterate(pplayer) {
-      dbv_clr_all(&pplayer->tile_known);
+      map_clear_all_known(pplayer);
     } players_iterate_end;
 
     /* HACK: we read the known data from hex into 32-bit integers, and
@@ -3296,6 +3296,7 @@ static void sg_load_player_cities(struct loaddata *loading,
     city_refresh_vision(pcity);
 
     city_list_append(plr->cities, pcity);
+    plr->server.largest_city_size = -1;
   }
 
   tasks_handled = FALSE;
@@ -83,6 +83,7 @@
 #include "auth.h"
 #include "connecthand.h"
 #include "console.h"
+#include "maphand.h"
 #include "meta.h"
 #include "plrhand.h"
 #include "srv_main.h"
@@ -553,6 +554,11 @@ enum server_events server_sniff_all_input(void)
 
     get_lanserver_announcement();
 
+    /* Send more of the initial map to the connections that can take it. */
+    conn_list_iterate(game.est_connections, pconn) {
+      send_known_tiles_continue(pconn);
+    } conn_list_iterate_end;
+
     /* end server if no players for 'srvarg.quitidle' seconds,
      * but only if at least one player has previously connected. */
     if (srvarg.quitidle != 0) {
@@ -1059,6 +1065,8 @@ int server_make_connection(int new_sock, const char *client_addr,
       pconn->server.ignore_list =
           conn_pattern_list_new_full(conn_pattern_destroy);
       pconn->server.is_closing = FALSE;
+      pconn->server.map_sync = -1;
+      conn_delta_cache_set_limit(pconn, game.server.deltacache * 1024);
       pconn->ping_time = -1.0;
       pconn->incoming_packet_notify = NULL;
       pconn->outgoing_packet_notify = NULL;
@@ -699,6 +699,16 @@ static void plrcol_action(const struct setting *pset)
   }
 }
 
+/************************************************************************//**
+  Apply the new delta cache limit to all connections.
+****************************************************************************/
+static void deltacache_action(const struct setting *pset)
+{
+  conn_list_iterate(game.all_connections, pconn) {
+    conn_delta_cache_set_limit(pconn, *pset->integer.pvalue * 1024);
+  } conn_list_iterate_end;
+}
+
 /************************************************************************//**
   Toggle player AI status.
 ****************************************************************************/
@@ -1649,6 +1659,18 @@ static struct setting settings[] = {
              "jungles, and rivers."), NULL, NULL, NULL,
           MAP_MIN_WETNESS, MAP_MAX_WETNESS, MAP_DEFAULT_WETNESS)
 
+  GEN_INT("mapgen_threads", wld.map.server.mapgen_threads,
+          SSET_MAP_GEN, SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
+          N_("Number of threads used by the map generator"),
+          N_("If this is more than one, the smoothing and leveling of the "
+             "height and temperature maps of large maps is split between "
+             "up to this many threads, and the 'FAIR' generator tries "
+             "this many island layouts at once. The generated map is the "
+             "same whatever the number of threads."),
+          NULL, NULL, NULL,
+          MAP_MIN_MAPGEN_THREADS, MAP_MAX_MAPGEN_THREADS,
+          MAP_DEFAULT_MAPGEN_THREADS)
+
   GEN_BOOL("globalwarming", game.info.global_warming,
            SSET_RULES, SSET_GEOLOGY, SSET_VITAL, ALLOW_NONE, ALLOW_BASIC,
            N_("Global warming"),
@@ -2843,6 +2865,19 @@ static struct setting settings[] = {
              "wait at all."), NULL, NULL, NULL,
           GAME_MIN_NETWAIT, GAME_MAX_NETWAIT, GAME_DEFAULT_NETWAIT)
 
+  GEN_INT("deltacache", game.server.deltacache,
+          SSET_META, SSET_NETWORK, SSET_RARE, ALLOW_NONE, ALLOW_BASIC,
+          N_("Max kilobytes of delta state per connection"),
+          N_("The server remembers the last packets it sent to each "
+             "client, so that it only needs to send what changed. This "
+             "limits the memory used for that per connection; the "
+             "least recently used packets are forgotten first, and "
+             "sent in full the next time. Zero means no limit. See "
+             "'list connections' for the current use."),
+          NULL, NULL, deltacache_action,
+          GAME_MIN_DELTACACHE, GAME_MAX_DELTACACHE,
+          GAME_DEFAULT_DELTACACHE)
+
   GEN_INT("pingtime", game.server.pingtime,
           SSET_META, SSET_NETWORK, SSET_RARE, ALLOW_NONE, ALLOW_BASIC,
           N_("Seconds between PINGs"),
@@ -2961,6 +2996,30 @@ static struct setting settings[] = {
               "users are not required to wait for the save to finish."),
            NULL, NULL, GAME_DEFAULT_THREADED_SAVE)
 
+  GEN_INT("mapimg_threads", game.server.mapimg_threads,
+          SSET_META, SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
+          N_("Number of threads used to create map images"),
+          /* TRANS: The string between single quotes is a setting name and
+           * should not be translated. */
+          N_("If this is zero, the map images defined with the 'mapimg' "
+             "command are created when the turn changes while the game "
+             "waits. Otherwise the map data is collected once per turn and "
+             "the images are rendered and saved by up to this many "
+             "threads in the background while the game continues."),
+          NULL, NULL, NULL,
+          GAME_MIN_MAPIMG_THREADS, GAME_MAX_MAPIMG_THREADS,
+          GAME_DEFAULT_MAPIMG_THREADS)
+
+  GEN_INT("citysite_threads", game.server.citysite_threads,
+          SSET_META, SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
+          N_("Number of threads AI uses to evaluate city sites"),
+          N_("If this is non-zero, the AI calculates the tile outputs "
+             "around the candidate sites of new cities in this many "
+             "threads before scoring the sites."),
+          NULL, NULL, NULL,
+          GAME_MIN_CITYSITE_THREADS, GAME_MAX_CITYSITE_THREADS,
+          GAME_DEFAULT_CITYSITE_THREADS)
+
   GEN_INT("compress", game.server.save_compress_level,
           SSET_META, SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
           N_("Savegame compression level"),
@@ -29,6 +29,9 @@
 #ifdef HAVE_SYS_IOCTL_H
 #include <sys/ioctl.h>
 #endif
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
 #ifdef HAVE_SYS_TERMIO_H
 #include <sys/termio.h>
 #endif
@@ -141,6 +144,7 @@
 #include "srv_main.h"
 
 static void end_turn(void);
+static void timings_report_write(int turns, double seconds);
 static void announce_player(struct player *pplayer);
 static void fc_interface_init_server(void);
 
@@ -261,8 +265,10 @@ void srv_init(void)
   srvarg.loglevel = LOG_NORMAL;
 
   srvarg.log_filename = NULL;
+  srvarg.log_queue_kb = 0;
   srvarg.fatal_assertions = -1;
   srvarg.ranklog_filename = NULL;
+  srvarg.timings_filename = NULL;
   srvarg.load_filename[0] = '\0';
   srvarg.script_filename = NULL;
   srvarg.saves_pathname = "";
@@ -678,7 +684,7 @@ void send_all_info(struct conn_list *dest)
     send_research_info(presearch, dest);
   } researches_iterate_end;
   send_map_info(dest);
-  send_all_known_tiles(dest);
+  send_known_tiles_stream(dest);
   send_all_known_cities(dest);
   send_all_known_units(dest);
   send_spaceship_info(NULL, dest);
@@ -1287,7 +1293,9 @@ static void begin_phase(bool is_new_phase)
     } phase_players_iterate_end;
 
     log_debug("Aistartturn");
+    PROF_SCOPE_BEGIN("begin_phase.ai");
     ai_start_phase();
+    PROF_SCOPE_END;
   } else {
     phase_players_iterate(pplayer) {
       if (is_ai(pplayer)) {
@@ -1384,6 +1392,7 @@ static void end_phase(void)
   send_city_suppression(TRUE);
 
   /* AI end of turn activities */
+  PROF_SCOPE_BEGIN("end_phase.ai");
   players_iterate(pplayer) {
     unit_list_iterate(pplayer->units, punit) {
       CALL_PLR_AI_FUNC(unit_turn_end, pplayer, punit);
@@ -1395,6 +1404,7 @@ static void end_phase(void)
       CALL_PLR_AI_FUNC(last_activities, pplayer, pplayer);
     }
   } phase_players_iterate_end;
+  PROF_SCOPE_END;
 
   /* Refresh cities */
   phase_players_iterate(pplayer) {
@@ -1402,7 +1412,9 @@ static void end_phase(void)
     research_get(pplayer)->got_tech_multi = FALSE;
   } phase_players_iterate_end;
 
+  PROF_SCOPE_BEGIN("end_phase.players");
   alive_phase_players_iterate(pplayer) {
+    PROF_COUNT("end_phase.cities", city_list_size(pplayer->cities));
     do_tech_parasite_effect(pplayer);
     player_restore_units(pplayer);
 
@@ -1413,7 +1425,9 @@ static void end_phase(void)
                     _("Automatically placed spaceship parts that were still not placed."));
     }
 
+    tile_knowledge_journal_begin();
     update_city_activities(pplayer);
+    tile_knowledge_journal_end();
     city_thaw_workers_queue();
     pplayer->history += nation_history_gain(pplayer);
     research_get(pplayer)->researching_saved = A_UNKNOWN;
@@ -1422,25 +1436,32 @@ static void end_phase(void)
     update_bulbs(pplayer, -player_tech_upkeep(pplayer), TRUE);
     flush_packets();
   } alive_phase_players_iterate_end;
+  PROF_SCOPE_END;
 
   /* Some player/global effect may have changed cities' vision range */
+  PROF_SCOPE_BEGIN("end_phase.vision");
   phase_players_iterate(pplayer) {
     refresh_player_cities_vision(pplayer);
   } phase_players_iterate_end;
+  PROF_SCOPE_END;
 
   kill_dying_players();
 
   /* Unfreeze sending of cities. */
   send_city_suppression(FALSE);
 
+  PROF_SCOPE_BEGIN("end_phase.send_cities");
   phase_players_iterate(pplayer) {
     send_player_cities(pplayer);
   } phase_players_iterate_end;
   flush_packets();  /* to curb major city spam */
+  PROF_SCOPE_END;
 
+  PROF_SCOPE_BEGIN("end_phase.reveal_contacts");
   do_reveal_effects();
   do_have_contacts_effect();
   do_border_vision_effect();
+  PROF_SCOPE_END;
 
   phase_players_iterate(pplayer) {
     CALL_PLR_AI_FUNC(phase_finished, pplayer, pplayer);
@@ -1557,6 +1578,10 @@ static void end_turn(void)
     player_list_destroy(achievers);
   } achievements_iterate_end;
 
+  /* Climate change and spontaneous extras may change a tile several
+   * times; send each one once. */
+  tile_knowledge_journal_begin();
+
   if (game.info.global_warming) {
     update_environmental_upset(EUT_GLOBAL_WARMING, &game.info.heating,
                                &game.info.globalwarming,
@@ -1577,9 +1602,16 @@ static void end_turn(void)
    * Extra never appears only to disappear at the same turn,
    * but it can disappear and reappear. */
   extra_type_by_rmcause_iterate(ERM_DISAPPEARANCE, pextra) {
-    whole_map_iterate(&(wld.map), ptile) {
+    int i;
+
+    /* Only visit the tiles whose roll succeeds, instead of rolling for
+     * every tile. */
+    for (i = fc_rand_gap(pextra->disappearance_chance, 10000);
+         i < map_num_tiles();
+         i += 1 + fc_rand_gap(pextra->disappearance_chance, 10000)) {
+      struct tile *ptile = index_to_tile(&(wld.map), i);
+
       if (tile_has_extra(ptile, pextra)
-          && fc_rand(10000) < pextra->disappearance_chance
           && can_extra_disappear(pextra, ptile)) {
         tile_extra_rm_apply(ptile, pextra);
 
@@ -1603,13 +1635,18 @@ static void end_turn(void)
           unit_activities_cancel_all_illegal(n_tile);
         } adjc_iterate_end;
       }
-    } whole_map_iterate_end;
+    }
   } extra_type_by_rmcause_iterate_end;
 
   extra_type_by_cause_iterate(EC_APPEARANCE, pextra) {
-    whole_map_iterate(&(wld.map), ptile) {
+    int i;
+
+    for (i = fc_rand_gap(pextra->appearance_chance, 10000);
+         i < map_num_tiles();
+         i += 1 + fc_rand_gap(pextra->appearance_chance, 10000)) {
+      struct tile *ptile = index_to_tile(&(wld.map), i);
+
       if (!tile_has_extra(ptile, pextra)
-          && fc_rand(10000) < pextra->appearance_chance
           && can_extra_appear(pextra, ptile)) {
 
         tile_extra_apply(ptile, pextra);
@@ -1634,9 +1671,11 @@ static void end_turn(void)
           unit_activities_cancel_all_illegal(n_tile);
         } adjc_iterate_end;
       }
-    } whole_map_iterate_end;
+    }
   } extra_type_by_cause_iterate_end;
 
+  tile_knowledge_journal_end();
+
   update_diplomatics();
   make_history_report();
   settings_turn();
@@ -1774,6 +1813,7 @@ void server_quit(void)
   if (eot_timer != NULL) {
     timer_destroy(eot_timer);
   }
+  prof_free();
   set_server_state(S_S_OVER);
   mapimg_free();
   server_game_free();
@@ -2715,11 +2755,13 @@ static void announce_player(struct player *pplayer)
 **************************************************************************/
 static void srv_running(void)
 {
-  int i;
   bool is_new_turn = game.info.is_new_game;
   bool skip_mapimg = !game.info.is_new_game; /* Do not overwrite start-of-turn image */
   bool need_send_pending_events = !game.info.is_new_game;
   int save_counter = game.info.is_new_game ? 1 : 0;
+  int prof_turn;
+  int turns_run = 0;
+  struct timer *run_timer = timer_new(TIMER_USER, TIMER_ACTIVE);
 
   /* We may as well reset is_new_game now. */
   game.info.is_new_game = FALSE;
@@ -2728,6 +2770,7 @@ static void srv_running(void)
   send_server_settings(NULL);
 
   timer_start(eot_timer);
+  timer_start(run_timer);
 
   if (game.server.autosaves & (1 << AS_TIMER)) {
     game.server.save_timer = timer_renew(game.server.save_timer,
@@ -2750,7 +2793,9 @@ static void srv_running(void)
      * We have to initialize data as well as do some actions.  However when
      * loading a game we don't want to do these actions (like AI unit
      * movement and AI diplomacy). */
+    PROF_SCOPE_BEGIN("turn.begin_turn");
     begin_turn(is_new_turn);
+    PROF_SCOPE_END;
 
     if (game.server.num_phases != 1) {
       /* We allow everyone to begin adjusting cities and such
@@ -2763,7 +2808,9 @@ static void srv_running(void)
     for (; game.info.phase < game.server.num_phases; game.info.phase++) {
       log_debug("Starting phase %d/%d.", game.info.phase,
                 game.server.num_phases);
+      PROF_SCOPE_BEGIN("turn.begin_phase");
       begin_phase(is_new_turn);
+      PROF_SCOPE_END;
       if (need_send_pending_events) {
         /* When loading a savegame, we need to send loaded events, after
          * the clients switched to the game page (after the first
@@ -2798,21 +2845,18 @@ static void srv_running(void)
         if (save_counter >= game.server.save_nturns
             && game.server.save_nturns > 0) {
 	  save_counter = 0;
+          PROF_SCOPE_BEGIN("turn.autosave");
 	  save_game_auto("Autosave", AS_TURN);
+          PROF_SCOPE_END;
 	}
 	save_counter++;
 
         if (!skip_mapimg) {
           /* Save map image(s). */
-          for (i = 0; i < mapimg_count(); i++) {
-            struct mapdef *pmapdef = mapimg_isvalid(i);
-            if (pmapdef != NULL) {
-              mapimg_create(pmapdef, FALSE, game.server.save_name,
-                            srvarg.saves_pathname);
-            } else {
-              log_error("%s", mapimg_error());
-            }
-          }
+          PROF_SCOPE_BEGIN("turn.mapimg");
+          mapimg_create_all(game.server.mapimg_threads,
+                            game.server.save_name, srvarg.saves_pathname);
+          PROF_SCOPE_END;
         } else {
           skip_mapimg = FALSE;
         }
@@ -2839,14 +2883,18 @@ static void srv_running(void)
 
       conn_list_do_buffer(game.est_connections);
 
+      PROF_SCOPE_BEGIN("turn.sanity_check");
       sanity_check();
+      PROF_SCOPE_END;
 
       /* 
        * This will freeze the reports and agents at the client.
        */
       lsend_packet_freeze_client(game.est_connections);
 
+      PROF_SCOPE_BEGIN("turn.end_phase");
       end_phase();
+      PROF_SCOPE_END;
 
       conn_list_do_unbuffer(game.est_connections);
 
@@ -2855,7 +2903,12 @@ static void srv_running(void)
       }
       game.server.additional_phase_seconds = 0;
     }
+    prof_turn = game.info.turn;
+    PROF_SCOPE_BEGIN("turn.end_turn");
     end_turn();
+    PROF_SCOPE_END;
+    prof_turn_end(prof_turn);
+    turns_run++;
     log_debug("Sendinfotometaserver");
     (void) send_server_info_to_metaserver(META_REFRESH);
 
@@ -2886,6 +2939,54 @@ static void srv_running(void)
     between_turns = NULL;
   }
   timer_clear(eot_timer);
+
+  if (srvarg.timings_filename != NULL) {
+    timings_report_write(turns_run, timer_read_seconds(run_timer));
+  }
+  timer_destroy(run_timer);
+
+  /* Finish the map images of the last turn before the game is freed. */
+  mapimg_wait();
+}
+
+/**********************************************************************//**
+  Write the machine readable summary requested with --Timings: turns
+  played, wall clock time, peak resident set size (in kilobytes on
+  Linux, -1 if unknown) and the totals of all profiling probes.
+**************************************************************************/
+static void timings_report_write(int turns, double seconds)
+{
+  FILE *f = fc_fopen(srvarg.timings_filename, "w");
+  long peak_rss = -1;
+
+#ifdef HAVE_SYS_RESOURCE_H
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    peak_rss = usage.ru_maxrss;
+  }
+#endif /* HAVE_SYS_RESOURCE_H */
+
+  if (f == NULL) {
+    log_error(_("Could not write timings to '%s'."),
+              srvarg.timings_filename);
+    return;
+  }
+
+  fprintf(f, "{\"turns\":%d,\"last_turn\":%d,\"seconds\":%.3f,"
+          "\"turns_per_second\":%.3f,\"peak_rss\":%ld,\"probes\":",
+          turns, game.info.turn, seconds,
+          seconds > 0.0 ? turns / seconds : 0.0, peak_rss);
+  prof_write_totals(f);
+  fputs("}\n", f);
+
+  if (fclose(f) != 0) {
+    log_error(_("Could not write timings to '%s'."),
+              srvarg.timings_filename);
+  } else {
+    log_normal(_("Timings of %d turns written to '%s'."), turns,
+               srvarg.timings_filename);
+  }
 }
 
 /**********************************************************************//**
@@ -2908,12 +3009,22 @@ static void srv_prepare(void)
 
   fc_init_network();
 
+  if (srvarg.timings_filename != NULL) {
+    prof_set_enabled(TRUE);
+  }
+
   /* must be before con_log_init() */
   init_connections();
   con_log_init(srvarg.log_filename, srvarg.loglevel,
                srvarg.fatal_assertions);
   /* logging available after this point */
 
+  if (srvarg.log_queue_kb > 0
+      && !log_queue_start(srvarg.log_queue_kb * 1024)) {
+    log_normal(_("Log queue not available, writing the logfile "
+                 "directly."));
+  }
+
   server_open_socket();
 
 #if IS_BETA_VERSION
@@ -3327,6 +3438,9 @@ void server_game_init(bool keep_ruleset_value)
 **************************************************************************/
 void server_game_free(void)
 {
+  /* Map images still rendered in the background read the game map. */
+  mapimg_wait();
+
   CALL_FUNC_EACH_AI(game_free);
 
   /* Free all the treaties that were left open when game finished. */
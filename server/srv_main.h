@@ -40,7 +40,9 @@ struct server_arguments {
   enum log_level loglevel;
   /* filenames */
   char *log_filename;
+  int log_queue_kb;
   char *ranklog_filename;
+  char *timings_filename;
   char load_filename[512]; /* FIXME: may not be long enough? use MAX_PATH? */
   char *script_filename;
   char *saves_pathname;
@@ -164,6 +164,9 @@ static bool playernation_command(struct connection *caller,
                                  char *str, bool check);
 static bool mapimg_command(struct connection *caller, char *arg, bool check);
 static const char *mapimg_accessor(int i);
+static bool profile_command(struct connection *caller, char *arg,
+                            bool check);
+static const char *profile_accessor(int i);
 
 static void show_delegations(struct connection *caller);
 
@@ -4557,6 +4560,8 @@ static bool handle_stdin_input_real(struct connection *caller, char *str,
     return fcdb_command(caller, arg, check);
   case CMD_MAPIMG:
     return mapimg_command(caller, arg, check);
+  case CMD_PROFILE:
+    return profile_command(caller, arg, check);
   case CMD_RFCSTYLE:	/* see console.h for an explanation */
     if (!check) {
       con_set_style(!con_get_style());
@@ -5531,6 +5536,7 @@ static const char *mapimg_accessor(int i)
 **************************************************************************/
 static bool mapimg_command(struct connection *caller, char *arg, bool check)
 {
+  char error[MAX_LEN_MAPIMG_ERROR];
   enum m_pre_result result;
   int ind, ntokens, id;
   char *token[2];
@@ -5597,7 +5603,7 @@ static bool mapimg_command(struct connection *caller, char *arg, bool check)
       /* 'mapimg define <mapstr>' */
       if (!mapimg_define(token[1], check)) {
         cmd_reply(CMD_MAPIMG, caller, C_FAIL,
-                  _("Can't use definition: %s."), mapimg_error());
+                  _("Can't use definition: %s."), mapimg_error(error, sizeof(error)));
         ret = FALSE;
       } else if (check) {
         /* Validated OK, bail out now */
@@ -5606,7 +5612,7 @@ static bool mapimg_command(struct connection *caller, char *arg, bool check)
                  && mapimg_isvalid(mapimg_count() - 1) == NULL) {
         /* game was started - error in map image definition check */
         cmd_reply(CMD_MAPIMG, caller, C_FAIL,
-                  _("Can't use definition: %s."), mapimg_error());
+                  _("Can't use definition: %s."), mapimg_error(error, sizeof(error)));
         ret = FALSE;
       } else {
         char str[MAX_LEN_MAPDEF];
@@ -5645,7 +5651,7 @@ static bool mapimg_command(struct connection *caller, char *arg, bool check)
 
       if (!mapimg_delete(id)) {
         cmd_reply(CMD_MAPIMG, caller, C_FAIL,
-                  _("Couldn't delete definition: %s."), mapimg_error());
+                  _("Couldn't delete definition: %s."), mapimg_error(error, sizeof(error)));
         ret = FALSE;
       } else {
         cmd_reply(CMD_MAPIMG, caller, C_OK, _("Map image definition %d "
@@ -5676,7 +5682,7 @@ static bool mapimg_command(struct connection *caller, char *arg, bool check)
         cmd_reply(CMD_MAPIMG, caller, C_OK, "%s", str);
       } else {
         cmd_reply(CMD_MAPIMG, caller, C_FAIL,
-                  _("Couldn't show definition: %s."), mapimg_error());
+                  _("Couldn't show definition: %s."), mapimg_error(error, sizeof(error)));
         ret = FALSE;
       }
     } else {
@@ -5716,7 +5722,7 @@ static bool mapimg_command(struct connection *caller, char *arg, bool check)
             || !mapimg_create(pmapdef, TRUE, game.server.save_name,
                               srvarg.saves_pathname)) {
           cmd_reply(CMD_MAPIMG, caller, C_FAIL,
-                _("Error saving map image %d: %s."), id, mapimg_error());
+                _("Error saving map image %d: %s."), id, mapimg_error(error, sizeof(error)));
           ret = FALSE;
         }
       }
@@ -5733,7 +5739,7 @@ static bool mapimg_command(struct connection *caller, char *arg, bool check)
           || !mapimg_create(pmapdef, TRUE, game.server.save_name,
                             srvarg.saves_pathname)) {
         cmd_reply(CMD_MAPIMG, caller, C_FAIL,
-              _("Error saving map image %d: %s."), id, mapimg_error());
+              _("Error saving map image %d: %s."), id, mapimg_error(error, sizeof(error)));
         ret = FALSE;
       }
     } else {
@@ -5816,6 +5822,171 @@ static bool aicmd_command(struct connection *caller, char *arg, bool check)
   return ret;
 }
 
+/* Define the possible arguments to the profile command */
+#define SPECENUM_NAME profile_args
+#define SPECENUM_VALUE0     PROFILE_ON
+#define SPECENUM_VALUE0NAME "on"
+#define SPECENUM_VALUE1     PROFILE_OFF
+#define SPECENUM_VALUE1NAME "off"
+#define SPECENUM_VALUE2     PROFILE_RESET
+#define SPECENUM_VALUE2NAME "reset"
+#define SPECENUM_VALUE3     PROFILE_SHOW
+#define SPECENUM_VALUE3NAME "show"
+#define SPECENUM_VALUE4     PROFILE_EXPORT
+#define SPECENUM_VALUE4NAME "export"
+#define SPECENUM_COUNT      PROFILE_COUNT
+#include "specenum_gen.h"
+
+/**********************************************************************//**
+  Returns possible parameters for the profile command.
+**************************************************************************/
+static const char *profile_accessor(int i)
+{
+  i = CLIP(0, i, profile_args_max());
+  return profile_args_name((enum profile_args) i);
+}
+
+/**********************************************************************//**
+  Send one line of the profile report to the caller.
+**************************************************************************/
+static void profile_reply(const char *line, void *data)
+{
+  cmd_reply(CMD_PROFILE, (struct connection *) data, C_COMMENT, "%s", line);
+}
+
+/**********************************************************************//**
+  Handle profile command
+**************************************************************************/
+static bool profile_command(struct connection *caller, char *arg,
+                            bool check)
+{
+  enum m_pre_result result;
+  enum prof_export_format format = PROF_EXPORT_CSV;
+  int ind, ntokens;
+  char *token[3];
+  bool ret = TRUE;
+
+  ntokens = get_tokens(arg, token, 3, TOKEN_DELIMITERS);
+
+  if (ntokens > 0) {
+    /* match the argument */
+    result = match_prefix(profile_accessor, PROFILE_COUNT, 0,
+                          fc_strncasecmp, NULL, token[0], &ind);
+
+    switch (result) {
+    case M_PRE_EXACT:
+    case M_PRE_ONLY:
+      /* we have a match */
+      break;
+    case M_PRE_AMBIGUOUS:
+      cmd_reply(CMD_PROFILE, caller, C_FAIL,
+                _("Ambiguous 'profile' command."));
+      ret = FALSE;
+      goto cleanup;
+      break;
+    case M_PRE_EMPTY:
+      /* use 'show' as default */
+      ind = PROFILE_SHOW;
+      break;
+    case M_PRE_LONG:
+    case M_PRE_FAIL:
+    case M_PRE_LAST:
+      {
+        char buf[256] = "";
+        enum profile_args valid_args;
+
+        for (valid_args = profile_args_begin();
+             valid_args != profile_args_end();
+             valid_args = profile_args_next(valid_args)) {
+          cat_snprintf(buf, sizeof(buf), "'%s'",
+                       profile_args_name(valid_args));
+          if (valid_args != profile_args_max()) {
+            cat_snprintf(buf, sizeof(buf), ", ");
+          }
+        }
+
+        cmd_reply(CMD_PROFILE, caller, C_FAIL,
+                  _("The valid arguments are: %s."), buf);
+        ret = FALSE;
+        goto cleanup;
+      }
+      break;
+    }
+  } else {
+    /* use 'show' as default */
+    ind = PROFILE_SHOW;
+  }
+
+  if (ind == PROFILE_EXPORT) {
+    if (ntokens < 2) {
+      cmd_reply(CMD_PROFILE, caller, C_SYNTAX,
+                _("Missing file name for 'profile export'."));
+      ret = FALSE;
+      goto cleanup;
+    }
+    if (is_restricted(caller) && !is_safe_filename(token[1])) {
+      cmd_reply(CMD_PROFILE, caller, C_FAIL,
+                _("Name \"%s\" disallowed for security reasons."),
+                token[1]);
+      ret = FALSE;
+      goto cleanup;
+    }
+    if (ntokens > 2) {
+      if (fc_strcasecmp(token[2], "json") == 0) {
+        format = PROF_EXPORT_JSON;
+      } else if (fc_strcasecmp(token[2], "csv") != 0) {
+        cmd_reply(CMD_PROFILE, caller, C_SYNTAX,
+                  _("Unknown export format '%s'; use 'csv' or 'json'."),
+                  token[2]);
+        ret = FALSE;
+        goto cleanup;
+      }
+    }
+  }
+
+  if (check) {
+    goto cleanup;
+  }
+
+  switch (ind) {
+  case PROFILE_ON:
+    prof_set_enabled(TRUE);
+    cmd_reply(CMD_PROFILE, caller, C_OK, _("Profiling enabled."));
+    break;
+  case PROFILE_OFF:
+    prof_set_enabled(FALSE);
+    cmd_reply(CMD_PROFILE, caller, C_OK, _("Profiling disabled."));
+    break;
+  case PROFILE_RESET:
+    prof_reset();
+    cmd_reply(CMD_PROFILE, caller, C_OK, _("Profiling data cleared."));
+    break;
+  case PROFILE_SHOW:
+    if (!prof_is_enabled()) {
+      cmd_reply(CMD_PROFILE, caller, C_COMMENT,
+                _("Profiling is currently off."));
+    }
+    prof_report(ntokens > 1 ? token[1] : NULL, profile_reply, caller);
+    break;
+  case PROFILE_EXPORT:
+    if (prof_export(token[1], format)) {
+      cmd_reply(CMD_PROFILE, caller, C_OK,
+                _("Profiling data written to '%s'."), token[1]);
+    } else {
+      cmd_reply(CMD_PROFILE, caller, C_FAIL,
+                _("Could not write profiling data to '%s'."), token[1]);
+      ret = FALSE;
+    }
+    break;
+  }
+
+  cleanup:
+
+  free_tokens(token, ntokens);
+
+  return ret;
+}
+
 /* Define the possible arguments to the fcdb command */
 #define SPECENUM_NAME fcdb_args
 #define SPECENUM_VALUE0     FCDB_RELOAD
@@ -6516,6 +6687,11 @@ static void show_connections(struct connection *caller)
         cat_snprintf(buf, sizeof(buf), " command access level %s",
                      cmdlevel_name(pconn->access_level));
       }
+      cat_snprintf(buf, sizeof(buf),
+                   " delta cache %lu kB (%d packets, %d evicted)",
+                   (unsigned long) (conn_delta_cache_bytes(pconn) / 1024),
+                   conn_delta_cache_entries(pconn),
+                   conn_delta_cache_evictions(pconn));
       cmd_reply(CMD_LIST, caller, C_COMMENT, "%s", buf);
     } conn_list_iterate_end;
   }
@@ -7177,6 +7353,15 @@ static char *mapimg_generator(const char *text, int state)
                            mapimg_accessor);
 }
 
+/**********************************************************************//**
+  The valid arguments for the first argument to "profile".
+**************************************************************************/
+static char *profile_generator(const char *text, int state)
+{
+  return generic_generator(text, state, profile_args_max() + 1,
+                           profile_accessor);
+}
+
 /**********************************************************************//**
   The valid arguments for the argument to "fcdb".
 **************************************************************************/
@@ -7558,6 +7743,16 @@ static bool is_mapimg(int start)
                                    FALSE);
 }
 
+/**********************************************************************//**
+  Return whether we are completing first argument for profile command
+**************************************************************************/
+static bool is_profile(int start)
+{
+  return contains_str_before_start(start,
+                                   command_name_by_number(CMD_PROFILE),
+                                   FALSE);
+}
+
 /**********************************************************************//**
   Return whether we are completing argument for fcdb command
 **************************************************************************/
@@ -7638,6 +7833,8 @@ char **freeciv_completion(const char *text, int start, int end)
     matches = rl_completion_matches(text, delegate_generator);
   } else if (is_mapimg(start)) {
     matches = rl_completion_matches(text, mapimg_generator);
+  } else if (is_profile(start)) {
+    matches = rl_completion_matches(text, profile_generator);
   } else if (is_fcdb(start)) {
     matches = rl_completion_matches(text, fcdb_generator);
   } else if (is_lua(start)) {
@@ -648,9 +648,12 @@ static void unit_restore_movepoints(struct player *pplayer, struct unit *punit)
 **************************************************************************/
 void update_unit_activities(struct player *pplayer)
 {
+  /* Several units may work on the same tile. */
+  tile_knowledge_journal_begin();
   unit_list_iterate_safe(pplayer->units, punit) {
     update_unit_activity(punit);
   } unit_list_iterate_safe_end;
+  tile_knowledge_journal_end();
 }
 
 /**********************************************************************//**
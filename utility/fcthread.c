@@ -105,6 +105,39 @@ void fc_release_mutex(fc_mutex *mutex)
   mtx_unlock(mutex);
 }
 
+/*******************************************************************//**
+  Initialize thread local storage key. Every thread initially has NULL
+  value for it.
+***********************************************************************/
+void fc_thread_key_init(fc_thread_key *key)
+{
+  tss_create(key, NULL);
+}
+
+/*******************************************************************//**
+  Destroy thread local storage key
+***********************************************************************/
+void fc_thread_key_destroy(fc_thread_key *key)
+{
+  tss_delete(*key);
+}
+
+/*******************************************************************//**
+  Get the value of the thread local storage key for the calling thread
+***********************************************************************/
+void *fc_thread_key_get(fc_thread_key *key)
+{
+  return tss_get(*key);
+}
+
+/*******************************************************************//**
+  Set the value of the thread local storage key for the calling thread
+***********************************************************************/
+void fc_thread_key_set(fc_thread_key *key, void *value)
+{
+  tss_set(*key, value);
+}
+
 /*******************************************************************//**
   Initialize condition
 ***********************************************************************/
@@ -235,6 +268,39 @@ void fc_release_mutex(fc_mutex *mutex)
   pthread_mutex_unlock(mutex);
 }
 
+/*******************************************************************//**
+  Initialize thread local storage key. Every thread initially has NULL
+  value for it.
+***********************************************************************/
+void fc_thread_key_init(fc_thread_key *key)
+{
+  pthread_key_create(key, NULL);
+}
+
+/*******************************************************************//**
+  Destroy thread local storage key
+***********************************************************************/
+void fc_thread_key_destroy(fc_thread_key *key)
+{
+  pthread_key_delete(*key);
+}
+
+/*******************************************************************//**
+  Get the value of the thread local storage key for the calling thread
+***********************************************************************/
+void *fc_thread_key_get(fc_thread_key *key)
+{
+  return pthread_getspecific(*key);
+}
+
+/*******************************************************************//**
+  Set the value of the thread local storage key for the calling thread
+***********************************************************************/
+void fc_thread_key_set(fc_thread_key *key, void *value)
+{
+  pthread_setspecific(*key, value);
+}
+
 /*******************************************************************//**
   Initialize condition
 ***********************************************************************/
@@ -358,6 +424,39 @@ void fc_release_mutex(fc_mutex *mutex)
   ReleaseMutex(*mutex);
 }
 
+/*******************************************************************//**
+  Initialize thread local storage key. Every thread initially has NULL
+  value for it.
+***********************************************************************/
+void fc_thread_key_init(fc_thread_key *key)
+{
+  *key = TlsAlloc();
+}
+
+/*******************************************************************//**
+  Destroy thread local storage key
+***********************************************************************/
+void fc_thread_key_destroy(fc_thread_key *key)
+{
+  TlsFree(*key);
+}
+
+/*******************************************************************//**
+  Get the value of the thread local storage key for the calling thread
+***********************************************************************/
+void *fc_thread_key_get(fc_thread_key *key)
+{
+  return TlsGetValue(*key);
+}
+
+/*******************************************************************//**
+  Set the value of the thread local storage key for the calling thread
+***********************************************************************/
+void fc_thread_key_set(fc_thread_key *key, void *value)
+{
+  TlsSetValue(*key, value);
+}
+
 /* TODO: Windows thread condition variable support.
  *       Currently related functions are always dummy ones below
  *       (see #ifndef FREECIV_HAVE_THREAD_COND) */
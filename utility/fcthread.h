@@ -39,6 +39,7 @@ extern "C" {
 #define fc_thread      thrd_t
 #define fc_mutex       mtx_t
 #define fc_thread_cond cnd_t
+#define fc_thread_key  tss_t
 
 #elif defined(FREECIV_HAVE_PTHREAD)
 
@@ -47,12 +48,14 @@ extern "C" {
 #define fc_thread      pthread_t
 #define fc_mutex       pthread_mutex_t
 #define fc_thread_cond pthread_cond_t
+#define fc_thread_key  pthread_key_t
 
 #elif defined (FREECIV_HAVE_WINTHREADS)
 
 #include <windows.h>
 #define fc_thread      HANDLE *
 #define fc_mutex       HANDLE *
+#define fc_thread_key  DWORD
 
 #ifndef FREECIV_HAVE_THREAD_COND
 #define fc_thread_cond char
@@ -74,6 +77,11 @@ void fc_destroy_mutex(fc_mutex *mutex);
 void fc_allocate_mutex(fc_mutex *mutex);
 void fc_release_mutex(fc_mutex *mutex);
 
+void fc_thread_key_init(fc_thread_key *key);
+void fc_thread_key_destroy(fc_thread_key *key);
+void *fc_thread_key_get(fc_thread_key *key);
+void fc_thread_key_set(fc_thread_key *key, void *value);
+
 void fc_thread_cond_init(fc_thread_cond *cond);
 void fc_thread_cond_destroy(fc_thread_cond *cond);
 void fc_thread_cond_wait(fc_thread_cond *cond, fc_mutex *mutex);
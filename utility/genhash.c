@@ -53,6 +53,17 @@
    Implementation uses open hashing. Collision resolution is done by
    separate chaining with linked lists. Resize hash table when deemed
    necessary by making and populating a new table.
+
+   Tables which have none of the key functions (integer or pointer keys
+   compared by identity, e.g. the id maps used by idex) rather use open
+   addressing: the keys are stored inline in a flat, power of 2 sized
+   slot array, and collisions are resolved by linear probing with the
+   Robin Hood heuristic and backward shift deletion. This avoids one
+   allocation per entry and a pointer chase per probe. The data
+   functions are still honored for such tables.
+
+   For both implementations, the table must not be modified while being
+   iterated, apart from replacing the data of an existing key.
 ****************************************************************************/
 
 #ifdef HAVE_CONFIG_H
@@ -72,6 +83,10 @@
 #define FULL_RATIO 0.75         /* consider expanding when above this */
 #define MIN_RATIO 0.24          /* shrink when below this */
 
+/* Same as above, for the open addressing tables. */
+#define INLINE_FULL_RATIO 0.8
+#define INLINE_MIN_RATIO 0.2
+
 struct genhash_entry {
   void *key;
   void *data;
@@ -79,9 +94,18 @@ struct genhash_entry {
   struct genhash_entry *next;
 };
 
+/* Slot of the open addressing tables. */
+struct genhash_slot {
+  void *key;
+  void *data;
+  unsigned int dist;            /* Probe distance + 1, 0 if unused. */
+};
+
 /* Contents of the opaque type: */
 struct genhash {
   struct genhash_entry **buckets;
+  struct genhash_slot *slots;   /* Used instead of 'buckets' when the keys
+                                 * are stored inline. */
   genhash_val_fn_t key_val_func;
   genhash_comp_fn_t key_comp_func;
   genhash_copy_fn_t key_copy_func;
@@ -97,6 +121,7 @@ struct genhash_iter {
   struct iterator vtable;
   struct genhash_entry *const *bucket, *const *end;
   const struct genhash_entry *iterator;
+  const struct genhash_slot *slot, *slot_end;
 };
 
 #define GENHASH_ITER(p) ((struct genhash_iter *) (p))
@@ -190,7 +215,37 @@ static size_t genhash_calc_num_buckets(size_t num_entries)
 }
 
 /************************************************************************//**
-  Internal constructor, specifying exact number of buckets.
+  Calculate the number of slots of an open addressing table for a given
+  number of entries. Always a power of 2, leaving at least a factor of 2
+  of breathing room, like genhash_calc_num_buckets() does.
+****************************************************************************/
+#define MIN_SLOTS 32
+static size_t genhash_calc_num_slots(size_t num_entries)
+{
+  size_t num_slots = MIN_SLOTS;
+
+  num_entries <<= 1; /* breathing room */
+  while (num_slots < num_entries) {
+    num_slots <<= 1;
+  }
+  return num_slots;
+}
+
+/************************************************************************//**
+  Returns whether a table with such key functions stores its keys inline,
+  using open addressing.
+****************************************************************************/
+static inline bool genhash_use_inline_keys(genhash_val_fn_t key_val_func,
+                                           genhash_comp_fn_t key_comp_func,
+                                           genhash_copy_fn_t key_copy_func,
+                                           genhash_free_fn_t key_free_func)
+{
+  return (NULL == key_val_func && NULL == key_comp_func
+          && NULL == key_copy_func && NULL == key_free_func);
+}
+
+/************************************************************************//**
+  Internal constructor, specifying expected number of entries.
   Allows to specify functions to free the memory allocated for the key and
   user-data that get called when removing the bucket from the hash table or
   changing key/user-data values.
@@ -199,27 +254,38 @@ static size_t genhash_calc_num_buckets(size_t num_entries)
   this function significantly.
 ****************************************************************************/
 static struct genhash *
-genhash_new_nbuckets(genhash_val_fn_t key_val_func,
-                     genhash_comp_fn_t key_comp_func,
-                     genhash_copy_fn_t key_copy_func,
-                     genhash_free_fn_t key_free_func,
-                     genhash_copy_fn_t data_copy_func,
-                     genhash_free_fn_t data_free_func,
-                     size_t num_buckets)
+genhash_new_real(genhash_val_fn_t key_val_func,
+                 genhash_comp_fn_t key_comp_func,
+                 genhash_copy_fn_t key_copy_func,
+                 genhash_free_fn_t key_free_func,
+                 genhash_copy_fn_t data_copy_func,
+                 genhash_free_fn_t data_free_func,
+                 size_t nentries)
 {
   struct genhash *pgenhash = fc_malloc(sizeof(*pgenhash));
 
-  log_debug("New genhash table with %lu buckets",
-            (long unsigned) num_buckets);
-
-  pgenhash->buckets = fc_calloc(num_buckets, sizeof(*pgenhash->buckets));
+  if (genhash_use_inline_keys(key_val_func, key_comp_func,
+                              key_copy_func, key_free_func)) {
+    pgenhash->num_buckets = genhash_calc_num_slots(nentries);
+    pgenhash->buckets = NULL;
+    pgenhash->slots = fc_calloc(pgenhash->num_buckets,
+                                sizeof(*pgenhash->slots));
+    log_debug("New genhash table with %lu inline slots",
+              (long unsigned) pgenhash->num_buckets);
+  } else {
+    pgenhash->num_buckets = genhash_calc_num_buckets(nentries);
+    pgenhash->buckets = fc_calloc(pgenhash->num_buckets,
+                                  sizeof(*pgenhash->buckets));
+    pgenhash->slots = NULL;
+    log_debug("New genhash table with %lu buckets",
+              (long unsigned) pgenhash->num_buckets);
+  }
   pgenhash->key_val_func = key_val_func;
   pgenhash->key_comp_func = key_comp_func;
   pgenhash->key_copy_func = key_copy_func;
   pgenhash->key_free_func = key_free_func;
   pgenhash->data_copy_func = data_copy_func;
   pgenhash->data_free_func = data_free_func;
-  pgenhash->num_buckets = num_buckets;
   pgenhash->num_entries = 0;
   pgenhash->no_shrink = FALSE;
 
@@ -241,10 +307,9 @@ genhash_new_nentries_full(genhash_val_fn_t key_val_func,
                           genhash_free_fn_t data_free_func,
                           size_t nentries)
 {
-  return genhash_new_nbuckets(key_val_func, key_comp_func,
-                              key_copy_func, key_free_func,
-                              data_copy_func, data_free_func,
-                              genhash_calc_num_buckets(nentries));
+  return genhash_new_real(key_val_func, key_comp_func,
+                          key_copy_func, key_free_func,
+                          data_copy_func, data_free_func, nentries);
 }
 
 /************************************************************************//**
@@ -254,9 +319,8 @@ struct genhash *genhash_new_nentries(genhash_val_fn_t key_val_func,
                                      genhash_comp_fn_t key_comp_func,
                                      size_t nentries)
 {
-  return genhash_new_nbuckets(key_val_func, key_comp_func,
-                              NULL, NULL, NULL, NULL,
-                              genhash_calc_num_buckets(nentries));
+  return genhash_new_real(key_val_func, key_comp_func,
+                          NULL, NULL, NULL, NULL, nentries);
 }
 
 /************************************************************************//**
@@ -272,9 +336,9 @@ struct genhash *genhash_new_full(genhash_val_fn_t key_val_func,
                                  genhash_copy_fn_t data_copy_func,
                                  genhash_free_fn_t data_free_func)
 {
-  return genhash_new_nbuckets(key_val_func, key_comp_func,
-                              key_copy_func, key_free_func,
-                              data_copy_func, data_free_func, MIN_BUCKETS);
+  return genhash_new_real(key_val_func, key_comp_func,
+                          key_copy_func, key_free_func,
+                          data_copy_func, data_free_func, 0);
 }
 
 /************************************************************************//**
@@ -283,8 +347,8 @@ struct genhash *genhash_new_full(genhash_val_fn_t key_val_func,
 struct genhash *genhash_new(genhash_val_fn_t key_val_func,
                             genhash_comp_fn_t key_comp_func)
 {
-  return genhash_new_nbuckets(key_val_func, key_comp_func,
-                              NULL, NULL, NULL, NULL, MIN_BUCKETS);
+  return genhash_new_real(key_val_func, key_comp_func,
+                          NULL, NULL, NULL, NULL, 0);
 }
 
 /************************************************************************//**
@@ -296,6 +360,7 @@ void genhash_destroy(struct genhash *pgenhash)
   pgenhash->no_shrink = TRUE;
   genhash_clear(pgenhash);
   free(pgenhash->buckets);
+  free(pgenhash->slots);
   free(pgenhash);
 }
 
@@ -328,6 +393,152 @@ static void genhash_resize_table(struct genhash *pgenhash,
   pgenhash->num_buckets = new_nbuckets;
 }
 
+/************************************************************************//**
+  Calculate the home slot index of an inline key. The keys are often
+  consecutive integers or aligned pointers, so mix them before masking.
+****************************************************************************/
+static inline size_t genhash_inline_index(const void *key, size_t num_slots)
+{
+  uint64_t hash_val = (uint64_t) (uintptr_t) key
+                      * (uint64_t) 0x9E3779B97F4A7C15ULL;
+
+  return (size_t) (hash_val ^ (hash_val >> 32)) & (num_slots - 1);
+}
+
+/************************************************************************//**
+  Return the slot where the inline key resides, or NULL if the key is not
+  in the table.
+****************************************************************************/
+static inline struct genhash_slot *
+genhash_inline_lookup(const struct genhash *pgenhash, const void *key)
+{
+  size_t mask = pgenhash->num_buckets - 1;
+  size_t i = genhash_inline_index(key, pgenhash->num_buckets);
+  unsigned int dist;
+
+  for (dist = 1; ; dist++, i = (i + 1) & mask) {
+    struct genhash_slot *slot = pgenhash->slots + i;
+
+    if (slot->dist < dist) {
+      /* Empty slot, or an entry nearer its home than the key would be:
+       * the Robin Hood invariant ensures the key is not further. */
+      return NULL;
+    }
+    if (slot->key == key) {
+      return slot;
+    }
+  }
+}
+
+/************************************************************************//**
+  Place a key known to be absent of the table. Doesn't call any copy
+  callbacks nor update the number of entries.
+****************************************************************************/
+static void genhash_inline_place(struct genhash_slot *slots, size_t num_slots,
+                                 void *key, void *data)
+{
+  struct genhash_slot entry, swap;
+  size_t mask = num_slots - 1;
+  size_t i = genhash_inline_index(key, num_slots);
+
+  entry.key = key;
+  entry.data = data;
+  entry.dist = 1;
+  for (;; entry.dist++, i = (i + 1) & mask) {
+    if (0 == slots[i].dist) {
+      slots[i] = entry;
+      return;
+    }
+    if (slots[i].dist < entry.dist) {
+      /* Take the place of the richer entry, and move it further. */
+      swap = slots[i];
+      slots[i] = entry;
+      entry = swap;
+    }
+  }
+}
+
+/************************************************************************//**
+  Empty the slot, shifting back the following entries of the cluster so
+  that no tombstone is needed. Doesn't call any free callbacks nor update
+  the number of entries.
+****************************************************************************/
+static void genhash_inline_unplace(struct genhash *pgenhash,
+                                   struct genhash_slot *slot)
+{
+  size_t mask = pgenhash->num_buckets - 1;
+  size_t i = slot - pgenhash->slots;
+  size_t j = (i + 1) & mask;
+
+  while (1 < pgenhash->slots[j].dist) {
+    pgenhash->slots[i] = pgenhash->slots[j];
+    pgenhash->slots[i].dist--;
+    i = j;
+    j = (j + 1) & mask;
+  }
+  pgenhash->slots[i].dist = 0;
+}
+
+/************************************************************************//**
+  Resize the open addressing table: re-place all entries.
+****************************************************************************/
+static void genhash_inline_resize_table(struct genhash *pgenhash,
+                                        size_t new_nslots)
+{
+  struct genhash_slot *new_slots, *slot, *end;
+
+  fc_assert(new_nslots > pgenhash->num_entries);
+
+  new_slots = fc_calloc(new_nslots, sizeof(*new_slots));
+
+  slot = pgenhash->slots;
+  end = slot + pgenhash->num_buckets;
+  for (; slot < end; slot++) {
+    if (0 != slot->dist) {
+      genhash_inline_place(new_slots, new_nslots, slot->key, slot->data);
+    }
+  }
+
+  free(pgenhash->slots);
+  pgenhash->slots = new_slots;
+  pgenhash->num_buckets = new_nslots;
+}
+
+/************************************************************************//**
+  genhash_maybe_resize() for the open addressing tables. Call it before
+  adding an entry, or after having removed one.
+****************************************************************************/
+static bool genhash_inline_maybe_resize(struct genhash *pgenhash,
+                                        bool expandingp)
+{
+  size_t new_nslots;
+
+  if (expandingp) {
+    if (pgenhash->num_entries + 1
+        <= INLINE_FULL_RATIO * pgenhash->num_buckets) {
+      return FALSE;
+    }
+    new_nslots = genhash_calc_num_slots(pgenhash->num_entries + 1);
+  } else {
+    if (pgenhash->num_buckets <= MIN_SLOTS
+        || pgenhash->num_entries > INLINE_MIN_RATIO * pgenhash->num_buckets) {
+      return FALSE;
+    }
+    new_nslots = genhash_calc_num_slots(pgenhash->num_entries);
+  }
+  if (new_nslots == pgenhash->num_buckets) {
+    return FALSE;
+  }
+
+  log_debug("%s genhash (entries = %lu, slots = %lu, new = %lu)",
+            new_nslots < pgenhash->num_buckets ? "Shrinking" : "Expanding",
+            (long unsigned) pgenhash->num_entries,
+            (long unsigned) pgenhash->num_buckets,
+            (long unsigned) new_nslots);
+  genhash_inline_resize_table(pgenhash, new_nslots);
+  return TRUE;
+}
+
 /************************************************************************//**
   Call this when an entry might be added or deleted: resizes the genhash
   table if seems like a good idea.  Count deleted entries in check
@@ -344,6 +555,9 @@ static bool genhash_maybe_resize(struct genhash *pgenhash, bool expandingp)
   if (!expandingp && pgenhash->no_shrink) {
     return FALSE;
   }
+  if (NULL != pgenhash->slots) {
+    return genhash_inline_maybe_resize(pgenhash, expandingp);
+  }
   if (expandingp) {
     limit = FULL_RATIO * pgenhash->num_buckets;
     if (pgenhash->num_entries < limit) {
@@ -505,6 +719,20 @@ static inline void genhash_slot_set(struct genhash *pgenhash,
                  ? pgenhash->data_copy_func(data) : (void *) data);
 }
 
+/************************************************************************//**
+  Insert an inline key known to be absent of the table, and call the copy
+  callback.
+****************************************************************************/
+static inline void genhash_inline_insert(struct genhash *pgenhash,
+                                         const void *key, const void *data)
+{
+  genhash_maybe_expand(pgenhash);
+  genhash_inline_place(pgenhash->slots, pgenhash->num_buckets, (void *) key,
+                       (NULL != pgenhash->data_copy_func
+                        ? pgenhash->data_copy_func(data) : (void *) data));
+  pgenhash->num_entries++;
+}
+
 /************************************************************************//**
   Prevent or allow the genhash table automatically shrinking. Returns the
   old value of the setting.
@@ -529,7 +757,7 @@ size_t genhash_size(const struct genhash *pgenhash)
 }
 
 /************************************************************************//**
-  Returns the number of buckets in the genhash table.
+  Returns the number of buckets (or slots) in the genhash table.
 ****************************************************************************/
 size_t genhash_capacity(const struct genhash *pgenhash)
 {
@@ -554,6 +782,26 @@ struct genhash *genhash_copy(const struct genhash *pgenhash)
   /* Copy fields. */
   *new_genhash = *pgenhash;
 
+  if (NULL != pgenhash->slots) {
+    /* Inline keys: the slots can be copied as is. */
+    struct genhash_slot *slot, *slot_end;
+
+    new_genhash->slots = fc_malloc(pgenhash->num_buckets
+                                   * sizeof(*new_genhash->slots));
+    memcpy(new_genhash->slots, pgenhash->slots,
+           pgenhash->num_buckets * sizeof(*new_genhash->slots));
+    if (NULL != new_genhash->data_copy_func) {
+      slot = new_genhash->slots;
+      slot_end = slot + new_genhash->num_buckets;
+      for (; slot < slot_end; slot++) {
+        if (0 != slot->dist) {
+          slot->data = new_genhash->data_copy_func(slot->data);
+        }
+      }
+    }
+    return new_genhash;
+  }
+
   /* But make fresh buckets. */
   new_genhash->buckets = fc_calloc(new_genhash->num_buckets,
                                    sizeof(*new_genhash->buckets));
@@ -585,8 +833,23 @@ void genhash_clear(struct genhash *pgenhash)
 
   fc_assert_ret(NULL != pgenhash);
 
+  if (NULL != pgenhash->slots) {
+    struct genhash_slot *slot = pgenhash->slots;
+    struct genhash_slot *slot_end = slot + pgenhash->num_buckets;
+
+    if (NULL != pgenhash->data_free_func) {
+      for (; slot < slot_end; slot++) {
+        if (0 != slot->dist) {
+          pgenhash->data_free_func(slot->data);
+        }
+      }
+    }
+    memset(pgenhash->slots, 0,
+           pgenhash->num_buckets * sizeof(*pgenhash->slots));
+  }
+
   bucket = pgenhash->buckets;
-  end = bucket + pgenhash->num_buckets;
+  end = bucket + (NULL != bucket ? pgenhash->num_buckets : 0);
   for (; bucket < end; bucket++) {
     while (NULL != *bucket) {
       genhash_slot_free(pgenhash, bucket);
@@ -609,6 +872,14 @@ bool genhash_insert(struct genhash *pgenhash, const void *key,
 
   fc_assert_ret_val(NULL != pgenhash, FALSE);
 
+  if (NULL != pgenhash->slots) {
+    if (NULL != genhash_inline_lookup(pgenhash, key)) {
+      return FALSE;
+    }
+    genhash_inline_insert(pgenhash, key, data);
+    return TRUE;
+  }
+
   hash_val = genhash_val_calc(pgenhash, key);
   slot = genhash_slot_lookup(pgenhash, key, hash_val);
   if (NULL != *slot) {
@@ -654,6 +925,29 @@ bool genhash_replace_full(struct genhash *pgenhash, const void *key,
   fc_assert_action(NULL != pgenhash,
                    genhash_default_get(old_pkey, old_pdata); return FALSE);
 
+  if (NULL != pgenhash->slots) {
+    struct genhash_slot *islot = genhash_inline_lookup(pgenhash, key);
+
+    if (NULL != islot) {
+      /* Replace. */
+      if (NULL != old_pkey) {
+        *old_pkey = islot->key;
+      }
+      if (NULL != old_pdata) {
+        *old_pdata = islot->data;
+      }
+      if (NULL != pgenhash->data_free_func) {
+        pgenhash->data_free_func(islot->data);
+      }
+      islot->data = (NULL != pgenhash->data_copy_func
+                     ? pgenhash->data_copy_func(data) : (void *) data);
+      return TRUE;
+    }
+    genhash_default_get(old_pkey, old_pdata);
+    genhash_inline_insert(pgenhash, key, data);
+    return FALSE;
+  }
+
   hash_val = genhash_val_calc(pgenhash, key);
   slot = genhash_slot_lookup(pgenhash, key, hash_val);
   if (NULL != *slot) {
@@ -686,6 +980,19 @@ bool genhash_lookup(const struct genhash *pgenhash, const void *key,
   fc_assert_action(NULL != pgenhash,
                    genhash_default_get(NULL, pdata); return FALSE);
 
+  if (NULL != pgenhash->slots) {
+    const struct genhash_slot *islot = genhash_inline_lookup(pgenhash, key);
+
+    if (NULL != islot) {
+      if (NULL != pdata) {
+        *pdata = islot->data;
+      }
+      return TRUE;
+    }
+    genhash_default_get(NULL, pdata);
+    return FALSE;
+  }
+
   slot = genhash_slot_lookup(pgenhash, key, genhash_val_calc(pgenhash, key));
   if (NULL != *slot) {
     genhash_slot_get(slot, NULL, pdata);
@@ -720,6 +1027,29 @@ bool genhash_remove_full(struct genhash *pgenhash, const void *key,
                    genhash_default_get(deleted_pkey, deleted_pdata);
                    return FALSE);
 
+  if (NULL != pgenhash->slots) {
+    struct genhash_slot *islot = genhash_inline_lookup(pgenhash, key);
+
+    if (NULL == islot) {
+      genhash_default_get(deleted_pkey, deleted_pdata);
+      return FALSE;
+    }
+    if (NULL != deleted_pkey) {
+      *deleted_pkey = islot->key;
+    }
+    if (NULL != deleted_pdata) {
+      *deleted_pdata = islot->data;
+    }
+    if (NULL != pgenhash->data_free_func) {
+      pgenhash->data_free_func(islot->data);
+    }
+    genhash_inline_unplace(pgenhash, islot);
+    fc_assert(0 < pgenhash->num_entries);
+    pgenhash->num_entries--;
+    genhash_maybe_shrink(pgenhash);
+    return TRUE;
+  }
+
   slot = genhash_slot_lookup(pgenhash, key, genhash_val_calc(pgenhash, key));
   if (NULL != *slot) {
     genhash_slot_get(slot, deleted_pkey, deleted_pdata);
@@ -770,6 +1100,26 @@ bool genhashs_are_equal_full(const struct genhash *pgenhash1,
     return FALSE;
   }
 
+  if (NULL != pgenhash1->slots) {
+    const struct genhash_slot *islot1 = pgenhash1->slots;
+    const struct genhash_slot *islot_end = islot1 + pgenhash1->num_buckets;
+    const struct genhash_slot *islot2;
+
+    for (; islot1 < islot_end; islot1++) {
+      if (0 == islot1->dist) {
+        continue;
+      }
+      islot2 = genhash_inline_lookup(pgenhash2, islot1->key);
+      if (NULL == islot2
+          || (islot1->data != islot2->data
+              && (NULL == data_comp_func
+                  || !data_comp_func(islot1->data, islot2->data)))) {
+        return FALSE;
+      }
+    }
+    return TRUE;
+  }
+
   /* Compare buckets. */
   bucket1 = pgenhash1->buckets;
   max1 = bucket1 + pgenhash1->num_buckets;
@@ -803,6 +1153,10 @@ size_t genhash_iter_sizeof(void)
 void *genhash_iter_key(const struct iterator *genhash_iter)
 {
   struct genhash_iter *iter = GENHASH_ITER(genhash_iter);
+
+  if (NULL != iter->slot) {
+    return iter->slot->key;
+  }
   return (void *) iter->iterator->key;
 }
 
@@ -812,6 +1166,10 @@ void *genhash_iter_key(const struct iterator *genhash_iter)
 void *genhash_iter_value(const struct iterator *genhash_iter)
 {
   struct genhash_iter *iter = GENHASH_ITER(genhash_iter);
+
+  if (NULL != iter->slot) {
+    return iter->slot->data;
+  }
   return (void *) iter->iterator->data;
 }
 
@@ -835,6 +1193,31 @@ static void genhash_iter_next(struct iterator *genhash_iter)
   }
 }
 
+/************************************************************************//**
+  Iterator interface 'next' function implementation, for the open
+  addressing tables.
+****************************************************************************/
+static void genhash_inline_iter_next(struct iterator *genhash_iter)
+{
+  struct genhash_iter *iter = GENHASH_ITER(genhash_iter);
+
+  for (iter->slot++; iter->slot < iter->slot_end; iter->slot++) {
+    if (0 != iter->slot->dist) {
+      return;
+    }
+  }
+}
+
+/************************************************************************//**
+  Iterator interface 'valid' function implementation, for the open
+  addressing tables.
+****************************************************************************/
+static bool genhash_inline_iter_valid(const struct iterator *genhash_iter)
+{
+  struct genhash_iter *iter = GENHASH_ITER(genhash_iter);
+  return iter->slot < iter->slot_end;
+}
+
 /************************************************************************//**
   Iterator interface 'get' function implementation. This just returns the
   iterator itself, so you would need to use genhash_iter_get_key/value to
@@ -866,9 +1249,26 @@ genhash_iter_init_common(struct genhash_iter *iter,
     return invalid_iter_init(ITERATOR(iter));
   }
 
-  iter->vtable.next = genhash_iter_next;
   iter->vtable.get = get;
+
+  if (NULL != pgenhash->slots) {
+    iter->vtable.next = genhash_inline_iter_next;
+    iter->vtable.valid = genhash_inline_iter_valid;
+    iter->slot = pgenhash->slots;
+    iter->slot_end = pgenhash->slots + pgenhash->num_buckets;
+
+    /* Seek to the first used slot. */
+    for (; iter->slot < iter->slot_end; iter->slot++) {
+      if (0 != iter->slot->dist) {
+        break;
+      }
+    }
+    return ITERATOR(iter);
+  }
+
+  iter->vtable.next = genhash_iter_next;
   iter->vtable.valid = genhash_iter_valid;
+  iter->slot = NULL;
   iter->bucket = pgenhash->buckets;
   iter->end = pgenhash->buckets + pgenhash->num_buckets;
 
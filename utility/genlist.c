@@ -25,6 +25,9 @@
 
 #include "genlist.h"
 
+/* Maximum number of links a list keeps for reuse. */
+#define GENLIST_MAX_SPARE_LINKS 4
+
 /************************************************************************//**
   Create a new empty genlist.
 ****************************************************************************/
@@ -34,9 +37,10 @@ struct genlist *genlist_new(void)
 }
 
 /************************************************************************//**
-  Create a new empty genlist with a free data function.
+  Create a new empty genlist, with or without mutex.
 ****************************************************************************/
-struct genlist *genlist_new_full(genlist_free_fn_t free_data_func)
+static struct genlist *genlist_new_real(genlist_free_fn_t free_data_func,
+                                        bool has_mutex)
 {
   struct genlist *pgenlist = fc_calloc(1, sizeof(*pgenlist));
 
@@ -44,27 +48,76 @@ struct genlist *genlist_new_full(genlist_free_fn_t free_data_func)
   pgenlist->nelements = 0;
   pgenlist->head_link = NULL;
   pgenlist->tail_link = NULL;
+  pgenlist->spare_links = NULL;
+  pgenlist->nspare_links = 0;
 #endif /* ZERO_VARIABLES_FOR_SEARCHING */
-  fc_init_mutex(&pgenlist->mutex);
+  pgenlist->has_mutex = has_mutex;
+  if (has_mutex) {
+    fc_init_mutex(&pgenlist->mutex);
+  }
   pgenlist->free_data_func = free_data_func;
 
   return pgenlist;
 }
 
+/************************************************************************//**
+  Create a new empty genlist with a free data function.
+****************************************************************************/
+struct genlist *genlist_new_full(genlist_free_fn_t free_data_func)
+{
+  return genlist_new_real(free_data_func, TRUE);
+}
+
+/************************************************************************//**
+  Create a new empty genlist with a free data function but without a
+  mutex. genlist_allocate_mutex() and genlist_release_mutex() must not be
+  used with such a list.
+****************************************************************************/
+struct genlist *genlist_new_unlocked(genlist_free_fn_t free_data_func)
+{
+  return genlist_new_real(free_data_func, FALSE);
+}
+
 /************************************************************************//**
   Destroys the genlist.
 ****************************************************************************/
 void genlist_destroy(struct genlist *pgenlist)
 {
+  struct genlist_link *plink;
+
   if (pgenlist == NULL) {
     return;
   }
 
   genlist_clear(pgenlist);
-  fc_destroy_mutex(&pgenlist->mutex);
+
+  while (NULL != (plink = pgenlist->spare_links)) {
+    pgenlist->spare_links = plink->next;
+    free(plink);
+  }
+
+  if (pgenlist->has_mutex) {
+    fc_destroy_mutex(&pgenlist->mutex);
+  }
   free(pgenlist);
 }
 
+/************************************************************************//**
+  Give a link which is no longer used back to the list. It is kept for
+  reuse if the list has not enough spare links yet.
+****************************************************************************/
+static inline void genlist_link_release(struct genlist *pgenlist,
+                                        struct genlist_link *plink)
+{
+  if (pgenlist->nspare_links < GENLIST_MAX_SPARE_LINKS) {
+    plink->next = pgenlist->spare_links;
+    pgenlist->spare_links = plink;
+    pgenlist->nspare_links++;
+  } else {
+    free(plink);
+  }
+}
+
 /************************************************************************//**
   Create a new link.
 ****************************************************************************/
@@ -72,7 +125,15 @@ static void genlist_link_new(struct genlist *pgenlist, void *dataptr,
                              struct genlist_link *prev,
                              struct genlist_link *next)
 {
-  struct genlist_link *plink = fc_malloc(sizeof(*plink));
+  struct genlist_link *plink;
+
+  if (NULL != pgenlist->spare_links) {
+    plink = pgenlist->spare_links;
+    pgenlist->spare_links = plink->next;
+    pgenlist->nspare_links--;
+  } else {
+    plink = fc_malloc(sizeof(*plink));
+  }
 
   plink->dataptr = dataptr;
   plink->prev = prev;
@@ -115,7 +176,7 @@ static void genlist_link_destroy(struct genlist *pgenlist,
   if (NULL != pgenlist->free_data_func) {
     pgenlist->free_data_func(plink->dataptr);
   }
-  free(plink);
+  genlist_link_release(pgenlist, plink);
 }
 
 /************************************************************************//**
@@ -166,7 +227,9 @@ struct genlist *genlist_copy_full(const struct genlist *pgenlist,
                                   genlist_copy_fn_t copy_data_func,
                                   genlist_free_fn_t free_data_func)
 {
-  struct genlist *pcopy = genlist_new_full(free_data_func);
+  struct genlist *pcopy = genlist_new_real(free_data_func,
+                                           NULL == pgenlist
+                                           || pgenlist->has_mutex);
 
   if (pgenlist) {
     struct genlist_link *plink;
@@ -264,12 +327,12 @@ void genlist_clear(struct genlist *pgenlist)
       do {
         plink2 = plink->next;
         free_data_func(plink->dataptr);
-        free(plink);
+        genlist_link_release(pgenlist, plink);
       } while (NULL != (plink = plink2));
     } else {
       do {
         plink2 = plink->next;
-        free(plink);
+        genlist_link_release(pgenlist, plink);
       } while (NULL != (plink = plink2));
     }
   }
@@ -682,6 +745,7 @@ void genlist_reverse(struct genlist *pgenlist)
 ****************************************************************************/
 void genlist_allocate_mutex(struct genlist *pgenlist)
 {
+  fc_assert_ret(pgenlist->has_mutex);
   fc_allocate_mutex(&pgenlist->mutex);
 }
 
@@ -690,5 +754,6 @@ void genlist_allocate_mutex(struct genlist *pgenlist)
 ****************************************************************************/
 void genlist_release_mutex(struct genlist *pgenlist)
 {
+  fc_assert_ret(pgenlist->has_mutex);
   fc_release_mutex(&pgenlist->mutex);
 }
@@ -37,6 +37,12 @@ extern "C" {
   iterator is active, in particular removing the next element pointed
   to by the iterator (see further comments below).
 
+  Each list keeps a few links of removed elements for reuse, so that
+  lists with frequent insertions and removals (e.g. the units on a tile)
+  do not allocate memory for every insertion. Lists which are never
+  shared between threads can be created with genlist_new_unlocked(); such
+  lists have no mutex, which makes their creation and destruction cheaper.
+
   See also the speclist module.
 ****************************************************************************/
 
@@ -58,15 +64,22 @@ typedef bool (*genlist_comp_fn_t) (const void *, const void *);
  * of the list. */
 struct genlist {
   int nelements;
+  bool has_mutex;
   fc_mutex mutex;
   struct genlist_link *head_link;
   struct genlist_link *tail_link;
   genlist_free_fn_t free_data_func;
+
+  /* Links kept for reuse. */
+  struct genlist_link *spare_links;
+  int nspare_links;
 };
-  
+
 struct genlist *genlist_new(void) fc__warn_unused_result;
 struct genlist *genlist_new_full(genlist_free_fn_t free_data_func)
                 fc__warn_unused_result;
+struct genlist *genlist_new_unlocked(genlist_free_fn_t free_data_func)
+                fc__warn_unused_result;
 void genlist_destroy(struct genlist *pgenlist);
 
 struct genlist *genlist_copy(const struct genlist *pgenlist)
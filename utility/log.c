@@ -33,6 +33,9 @@
 
 #define MAX_LEN_LOG_LINE 5120
 
+/* Smallest accepted size of the log queue; must hold a few full lines. */
+#define LOG_QUEUE_MIN_SIZE (4 * MAX_LEN_LOG_LINE)
+
 static void log_write(FILE *fs, enum log_level level, bool print_from_where,
                       const char *where, const char *message);
 static void log_real(enum log_level level, bool print_from_where,
@@ -45,6 +48,27 @@ static log_prefix_fn log_prefix = NULL;
 
 static fc_mutex logfile_mutex;
 
+/* Queue of formatted logfile lines, written by a background thread.
+ * Loggers only append to 'buf' under 'mutex'; the writer swaps 'buf' with
+ * its 'spare' buffer and does the charset conversion and file I/O without
+ * holding the lock. Memory use is bounded by twice 'size'. When the queue
+ * is full, messages less important than errors are dropped and counted. */
+static struct {
+  bool running;                 /* Protected by logfile_mutex. */
+  bool stopping;
+  bool writing;
+  char *buf;
+  char *spare;
+  size_t size;
+  size_t used;
+  unsigned int dropped;
+  FILE *fs;
+  fc_thread thread;
+  fc_mutex mutex;
+  fc_thread_cond ready;         /* Signalled when lines are queued. */
+  fc_thread_cond done;          /* Signalled when the queue frees space. */
+} log_queue;
+
 #ifdef FREECIV_DEBUG
 static const enum log_level max_level = LOG_DEBUG;
 #else
@@ -270,9 +294,191 @@ void log_init(const char *filename, enum log_level initial_level,
 **************************************************************************/
 void log_close(void)
 {
+  log_queue_stop();
   fc_destroy_mutex(&logfile_mutex);
 }
 
+/**********************************************************************//**
+  Write a batch of queued lines to the logfile.
+**************************************************************************/
+static void log_queue_write(const char *lines, size_t len,
+                            unsigned int dropped)
+{
+  if (len > 0) {
+    char *local = internal_to_local_string_malloc(lines);
+
+    fputs(local, log_queue.fs);
+    free(local);
+  }
+  if (dropped > 0) {
+    fprintf(log_queue.fs, "%d: %u log messages dropped (log queue full)\n",
+            LOG_WARN, dropped);
+  }
+  fflush(log_queue.fs);
+}
+
+/**********************************************************************//**
+  Main function of the logfile writer thread.
+**************************************************************************/
+static void log_queue_writer(void *arg)
+{
+  fc_allocate_mutex(&log_queue.mutex);
+  while (TRUE) {
+    char *lines;
+    size_t len;
+    unsigned int dropped;
+
+    while (0 == log_queue.used && 0 == log_queue.dropped
+           && !log_queue.stopping) {
+      fc_thread_cond_wait(&log_queue.ready, &log_queue.mutex);
+    }
+    if (0 == log_queue.used && 0 == log_queue.dropped) {
+      /* Stopping, and everything is written. */
+      break;
+    }
+
+    /* Take the whole queue at once. */
+    lines = log_queue.buf;
+    len = log_queue.used;
+    dropped = log_queue.dropped;
+    lines[len] = '\0';
+    log_queue.buf = log_queue.spare;
+    log_queue.spare = lines;
+    log_queue.used = 0;
+    log_queue.dropped = 0;
+    log_queue.writing = TRUE;
+    fc_thread_cond_signal(&log_queue.done);
+    fc_release_mutex(&log_queue.mutex);
+
+    log_queue_write(lines, len, dropped);
+
+    fc_allocate_mutex(&log_queue.mutex);
+    log_queue.writing = FALSE;
+    fc_thread_cond_signal(&log_queue.done);
+  }
+  fc_release_mutex(&log_queue.mutex);
+}
+
+/**********************************************************************//**
+  Start writing the logfile from a background thread, queueing at most
+  'size' bytes of log lines. Loggers then no longer wait for the file;
+  the queue is flushed on fatal messages and by log_close().
+  Returns FALSE, and keeps writing synchronously, if there is no logfile
+  or the threading support is missing.
+**************************************************************************/
+bool log_queue_start(size_t size)
+{
+  bool ret = FALSE;
+
+  if (!has_thread_cond_impl()) {
+    return FALSE;
+  }
+
+  fc_allocate_mutex(&logfile_mutex);
+  if (log_filename != NULL && !log_queue.running
+      && (log_queue.fs = fc_fopen(log_filename, "a")) != NULL) {
+    log_queue.size = MAX(size, LOG_QUEUE_MIN_SIZE);
+    /* One extra byte for the terminating nul added by the writer. */
+    log_queue.buf = fc_malloc(log_queue.size + 1);
+    log_queue.spare = fc_malloc(log_queue.size + 1);
+    log_queue.used = 0;
+    log_queue.dropped = 0;
+    log_queue.stopping = FALSE;
+    log_queue.writing = FALSE;
+    fc_init_mutex(&log_queue.mutex);
+    fc_thread_cond_init(&log_queue.ready);
+    fc_thread_cond_init(&log_queue.done);
+
+    if (0 == fc_thread_start(&log_queue.thread, log_queue_writer, NULL)) {
+      log_queue.running = TRUE;
+      ret = TRUE;
+    } else {
+      fc_thread_cond_destroy(&log_queue.done);
+      fc_thread_cond_destroy(&log_queue.ready);
+      fc_destroy_mutex(&log_queue.mutex);
+      FC_FREE(log_queue.buf);
+      FC_FREE(log_queue.spare);
+      fclose(log_queue.fs);
+      log_queue.fs = NULL;
+    }
+  }
+  fc_release_mutex(&logfile_mutex);
+
+  return ret;
+}
+
+/**********************************************************************//**
+  Write out everything queued and go back to writing the logfile
+  synchronously.
+**************************************************************************/
+void log_queue_stop(void)
+{
+  if (!log_queue.running) {
+    return;
+  }
+
+  /* Keep loggers out until the queue is written, so that lines stay in
+   * order. */
+  fc_allocate_mutex(&logfile_mutex);
+  if (log_queue.running) {
+    fc_allocate_mutex(&log_queue.mutex);
+    log_queue.stopping = TRUE;
+    fc_thread_cond_signal(&log_queue.ready);
+    fc_release_mutex(&log_queue.mutex);
+    fc_thread_wait(&log_queue.thread);
+
+    fc_thread_cond_destroy(&log_queue.done);
+    fc_thread_cond_destroy(&log_queue.ready);
+    fc_destroy_mutex(&log_queue.mutex);
+    FC_FREE(log_queue.buf);
+    FC_FREE(log_queue.spare);
+    fclose(log_queue.fs);
+    log_queue.fs = NULL;
+    log_queue.running = FALSE;
+  }
+  fc_release_mutex(&logfile_mutex);
+}
+
+/**********************************************************************//**
+  Wait until the writer thread has written everything queued so far.
+**************************************************************************/
+static void log_queue_flush(void)
+{
+  fc_allocate_mutex(&log_queue.mutex);
+  while (0 < log_queue.used || 0 < log_queue.dropped || log_queue.writing) {
+    fc_thread_cond_wait(&log_queue.done, &log_queue.mutex);
+  }
+  /* Pass the wakeup on to any other waiter. */
+  fc_thread_cond_signal(&log_queue.done);
+  fc_release_mutex(&log_queue.mutex);
+}
+
+/**********************************************************************//**
+  Append a line to the log queue. Errors and fatal messages wait for
+  space; anything less important is dropped when the queue is full.
+**************************************************************************/
+static void log_queue_push(enum log_level level, const char *line)
+{
+  size_t len = strlen(line);
+
+  fc_allocate_mutex(&log_queue.mutex);
+  if (LOG_ERROR >= level) {
+    while (log_queue.used + len > log_queue.size) {
+      fc_thread_cond_wait(&log_queue.done, &log_queue.mutex);
+    }
+    fc_thread_cond_signal(&log_queue.done);
+  }
+
+  if (log_queue.used + len <= log_queue.size) {
+    memcpy(log_queue.buf + log_queue.used, line, len);
+    log_queue.used += len;
+  } else {
+    log_queue.dropped++;
+  }
+  fc_thread_cond_signal(&log_queue.ready);
+  fc_release_mutex(&log_queue.mutex);
+}
+
 /**********************************************************************//**
   Adjust the log preparation callback function.
 **************************************************************************/
@@ -377,12 +583,21 @@ static void log_write(FILE *fs, enum log_level level, bool print_from_where,
       prefix[0] = '\0';
     }
 
-    if (log_filename || (print_from_where && where)) {
-      fc_fprintf(fs, "%d: %s%s%s\n", level, prefix, where, message);
+    if (NULL == fs) {
+      /* Logfile written by the log queue. */
+      char line[MAX_LEN_LOG_LINE + 256];
+
+      fc_snprintf(line, sizeof(line), "%d: %s%s%s\n",
+                  level, prefix, where, message);
+      log_queue_push(level, line);
     } else {
-      fc_fprintf(fs, "%d: %s%s\n", level, prefix, message);
+      if (log_filename || (print_from_where && where)) {
+        fc_fprintf(fs, "%d: %s%s%s\n", level, prefix, where, message);
+      } else {
+        fc_fprintf(fs, "%d: %s%s\n", level, prefix, message);
+      }
+      fflush(fs);
     }
-    fflush(fs);
   }
 
   if (log_callback) {
@@ -442,7 +657,9 @@ static void log_real(enum log_level level, bool print_from_where,
 
   if (log_filename) {
     fc_allocate_mutex(&logfile_mutex);
-    if (!(fs = fc_fopen(log_filename, "a"))) {
+    if (log_queue.running) {
+      fs = NULL;
+    } else if (!(fs = fc_fopen(log_filename, "a"))) {
       fc_fprintf(stderr,
                  _("Couldn't open logfile: %s for appending \"%s\".\n"), 
                  log_filename, msg);
@@ -498,10 +715,21 @@ static void log_real(enum log_level level, bool print_from_where,
   /* Save last message. */
   sz_strlcpy(last_msg, msg);
 
-  fflush(fs);
+  if (NULL != fs) {
+    fflush(fs);
+  }
   if (log_filename) {
-    fclose(fs);
+    bool queued = (NULL == fs);
+
+    if (!queued) {
+      fclose(fs);
+    }
     fc_release_mutex(&logfile_mutex);
+
+    if (queued && LOG_FATAL >= level) {
+      /* The program is about to die; get the message to the file. */
+      log_queue_flush();
+    }
   }
 }
 
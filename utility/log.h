@@ -58,6 +58,8 @@ void log_init(const char *filename, enum log_level initial_level,
               log_callback_fn callback, log_prefix_fn prefix,
               int fatal_assertions);
 void log_close(void);
+bool log_queue_start(size_t size);
+void log_queue_stop(void);
 bool log_parse_level_str(const char *level_str, enum log_level *ret_level);
 
 log_pre_callback_fn log_set_pre_callback(log_pre_callback_fn precallback);
@@ -35,7 +35,11 @@
 #include <fc_config.h>
 #endif
 
+#include <limits.h>
+#include <math.h>
+
 /* utility */
+#include "fcthread.h"
 #include "log.h"
 #include "shared.h"
 #include "support.h"            /* TRUE, FALSE */
@@ -51,9 +55,31 @@
  */
 static RANDOM_STATE rand_state;
 
+/* Thread local random states, used by fc_rand() instead of the global
+ * one in the threads which set one; see fc_rand_set_thread_state(). */
+static fc_thread_key thread_state_key;
+static bool thread_states_init = FALSE;
+
+/*********************************************************************//**
+  Return the random state fc_rand() uses in the calling thread.
+*************************************************************************/
+static inline RANDOM_STATE *fc_rand_current_state(void)
+{
+  if (thread_states_init) {
+    RANDOM_STATE *pstate = fc_thread_key_get(&thread_state_key);
+
+    if (NULL != pstate) {
+      return pstate;
+    }
+  }
+
+  return &rand_state;
+}
+
 /*********************************************************************//**
   Returns a new random value from the sequence, in the interval 0 to
-  (size-1) inclusive, and updates global state for next call.
+  (size-1) inclusive, and updates global state (or the state of the
+  calling thread, see fc_rand_set_thread_state()) for next call.
   This means that if size <= 1 the function will always return 0.
 
   Once we calculate new_rand below uniform (we hope) between 0 and
@@ -81,10 +107,11 @@ static RANDOM_STATE rand_state;
 RANDOM_TYPE fc_rand_debug(RANDOM_TYPE size, const char *called_as,
                           int line, const char *file) 
 {
+  RANDOM_STATE *pstate = fc_rand_current_state();
   RANDOM_TYPE new_rand, divisor, max;
   int bailout = 0;
 
-  fc_assert_ret_val(rand_state.is_init, 0);
+  fc_assert_ret_val(pstate->is_init, 0);
 
   if (size > 1) {
     divisor = MAX_UINT32 / size;
@@ -101,13 +128,13 @@ RANDOM_TYPE fc_rand_debug(RANDOM_TYPE size, const char *called_as,
   }
 
   do {
-    new_rand = (rand_state.v[rand_state.j]
-                + rand_state.v[rand_state.k]) & MAX_UINT32;
+    new_rand = (pstate->v[pstate->j]
+                + pstate->v[pstate->k]) & MAX_UINT32;
 
-    rand_state.x = (rand_state.x +1) % 56;
-    rand_state.j = (rand_state.j +1) % 56;
-    rand_state.k = (rand_state.k +1) % 56;
-    rand_state.v[rand_state.x] = new_rand;
+    pstate->x = (pstate->x +1) % 56;
+    pstate->j = (pstate->j +1) % 56;
+    pstate->k = (pstate->k +1) % 56;
+    pstate->v[pstate->x] = new_rand;
 
     if (++bailout > 10000) {
       log_error("%s(%lu) = %lu bailout at %s:%d", 
@@ -132,6 +159,35 @@ RANDOM_TYPE fc_rand_debug(RANDOM_TYPE size, const char *called_as,
   return new_rand;
 }
 
+/*********************************************************************//**
+  Consider a sequence of independent trials that each succeed when
+  fc_rand(base) < chance. Returns the number of failed trials before the
+  next success, so that callers can jump from one success to the next
+  instead of rolling every trial.
+
+  The result is capped to INT_MAX / 2 (also returned when chance <= 0),
+  so that it can be added to a position without overflowing.
+*************************************************************************/
+int fc_rand_gap_debug(int chance, int base, const char *called_as,
+                      int line, const char *file)
+{
+  const RANDOM_TYPE range = 1U << 30;
+  double u, gap;
+
+  if (chance >= base) {
+    return 0;
+  }
+  if (chance <= 0) {
+    return INT_MAX / 2;
+  }
+
+  /* Uniform in (0, 1]; the gap is geometrically distributed. */
+  u = (fc_rand_debug(range, called_as, line, file) + 1.0) / range;
+  gap = floor(log(u) / log1p(-(double) chance / base));
+
+  return gap < INT_MAX / 2 ? (int) gap : INT_MAX / 2;
+}
+
 /*********************************************************************//**
   Initialize the generator; see comment at top of file.
 *************************************************************************/
@@ -220,6 +276,32 @@ void fc_rand_set_state(RANDOM_STATE state)
   }
 }
 
+/*********************************************************************//**
+  Allow threads to use their own random state. Must be called by the main
+  thread before starting the threads calling fc_rand_set_thread_state().
+*************************************************************************/
+void fc_rand_thread_states_init(void)
+{
+  if (!thread_states_init) {
+    fc_thread_key_init(&thread_state_key);
+    thread_states_init = TRUE;
+  }
+}
+
+/*********************************************************************//**
+  Make fc_rand() use the given state in the calling thread, instead of
+  the global one, or again the global one if 'pstate' is NULL. This
+  allows threads to draw reproducible sequences, independently of each
+  other. The other functions of this file always work on the global
+  state.
+*************************************************************************/
+void fc_rand_set_thread_state(RANDOM_STATE *pstate)
+{
+  fc_assert_ret(thread_states_init);
+
+  fc_thread_key_set(&thread_state_key, pstate);
+}
+
 /*********************************************************************//**
   Test one aspect of randomness, using n numbers.
   Reports results to LOG_TEST; with good randomness, behaviourchange
@@ -37,6 +37,12 @@ typedef struct {
 RANDOM_TYPE fc_rand_debug(RANDOM_TYPE size, const char *called_as,
                           int line, const char *file);
 
+#define fc_rand_gap(_chance, _base) \
+  fc_rand_gap_debug((_chance), (_base), "fc_rand_gap", __FC_LINE__, __FILE__)
+
+int fc_rand_gap_debug(int chance, int base, const char *called_as,
+                      int line, const char *file);
+
 void fc_srand(RANDOM_TYPE seed);
 
 void fc_rand_uninit(void);
@@ -44,6 +50,9 @@ bool fc_rand_is_init(void);
 RANDOM_STATE fc_rand_state(void);
 void fc_rand_set_state(RANDOM_STATE state);
 
+void fc_rand_thread_states_init(void);
+void fc_rand_set_thread_state(RANDOM_STATE *pstate);
+
 void test_random1(int n);
 
 /*===*/
@@ -40,6 +40,9 @@
  *   SPECHASH_IKEY_COMP - The default hash key comparator function.
  *   SPECHASH_IKEY_COPY - The default key copy function.
  *   SPECHASH_IKEY_FREE - The default key free function.
+ *     When none of the key functions are defined (the default for
+ *     SPECHASH_INT_KEY_TYPE and SPECHASH_ENUM_KEY_TYPE), the keys are
+ *     stored inline in an open addressing table (see genhash.c).
  *   SPECHASH_IDATA_COMP - The default data comparator function.
  *   SPECHASH_IDATA_COPY - The default data copy function.
  *   SPECHASH_IDATA_FREE - The default data free function.
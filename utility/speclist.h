@@ -24,6 +24,9 @@
  * You may also define:
  *   SPECLIST_TYPE - the typed genlist will contain pointers to this type;
  * If SPECLIST_TYPE is not defined, then 'struct SPECLIST_TAG' is used.
+ *   SPECLIST_NO_MUTEX - the lists are created without mutex (see
+ * genlist_new_unlocked()); foo_list_allocate_mutex() and
+ * foo_list_release_mutex() must not be used then.
  * At the end of this file, these (and other defines) are undef-ed.
  *
  * Assuming SPECLIST_TAG were 'foo', and SPECLIST_TYPE were 'foo_t',
@@ -167,7 +170,11 @@ fc__warn_unused_result;
 
 static inline SPECLIST_LIST *SPECLIST_FOO(_list_new) (void)
 {
+#ifdef SPECLIST_NO_MUTEX
+  return (SPECLIST_LIST *) genlist_new_unlocked(NULL);
+#else
   return (SPECLIST_LIST *) genlist_new();
+#endif /* SPECLIST_NO_MUTEX */
 }
 
 /****************************************************************************
@@ -180,8 +187,13 @@ fc__warn_unused_result;
 static inline SPECLIST_LIST *
 SPECLIST_FOO(_list_new_full) (SPECLIST_FOO(_list_free_fn_t) free_data_func)
 {
+#ifdef SPECLIST_NO_MUTEX
+  return ((SPECLIST_LIST *)
+          genlist_new_unlocked((genlist_free_fn_t) free_data_func));
+#else
   return ((SPECLIST_LIST *)
           genlist_new_full((genlist_free_fn_t) free_data_func));
+#endif /* SPECLIST_NO_MUTEX */
 }
 
 /****************************************************************************
@@ -546,6 +558,7 @@ SPECLIST_FOO(_list_link_next) (const SPECLIST_LINK *plink)
 
 #undef SPECLIST_TAG
 #undef SPECLIST_TYPE
+#undef SPECLIST_NO_MUTEX
 #undef SPECLIST_PASTE_
 #undef SPECLIST_PASTE
 #undef SPECLIST_LIST
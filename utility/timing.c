@@ -44,6 +44,8 @@
 #include <fc_config.h>
 #endif
 
+#include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 #ifdef HAVE_GETTIMEOFDAY
@@ -73,6 +75,30 @@
 
 #define N_USEC_PER_SEC 1000000L	  /* not 1000! :-) */
 
+struct prof_sample {
+  int count;      /* Scopes timed, or additions to a counter */
+  double value;   /* Seconds spent, or sum of the counter additions */
+  double max;     /* Longest scope, or largest single addition */
+};
+
+struct prof_probe {
+  char *name;
+  enum prof_probe_type type;
+  struct prof_sample current;
+  struct prof_sample history[PROF_HISTORY_SIZE];
+  struct prof_sample total;   /* All turns since the last reset */
+};
+
+static struct {
+  bool enabled;
+  int generation;             /* Invalidates the prof_cache of call sites */
+  struct prof_probe *probes;
+  int num_probes;
+  int turns[PROF_HISTORY_SIZE];
+  int num_turns;              /* Turns in the history, oldest overwritten */
+  int last;                   /* History slot of the latest turn */
+} prof = { FALSE, 1, NULL, 0, { 0 }, 0, PROF_HISTORY_SIZE - 1 };
+
 enum timer_state {
   TIMER_STARTED,
   TIMER_STOPPED
@@ -405,3 +431,356 @@ void timer_usleep_since_start(struct timer *t, long usec)
   fc_usleep(usec);
 #endif
 }
+
+/*******************************************************************//**
+  Return the current wall clock time in seconds, for profiling probes.
+***********************************************************************/
+static double prof_clock(void)
+{
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval tv;
+
+  if (gettimeofday(&tv, NULL) == -1) {
+    return 0.0;
+  }
+
+  return tv.tv_sec + tv.tv_usec / (double)N_USEC_PER_SEC;
+#elif defined HAVE_FTIME
+  struct timeb tp;
+
+  ftime(&tp);
+
+  return tp.time + tp.millitm / 1000.0;
+#else
+  return (double)time(NULL);
+#endif
+}
+
+/*******************************************************************//**
+  Return the index of the probe called 'name', creating it if needed.
+  The result is remembered in 'cache' until the probes are freed.
+***********************************************************************/
+static int prof_probe_index(struct prof_cache *cache, const char *name,
+                            enum prof_probe_type type)
+{
+  int i;
+
+  if (cache->generation == prof.generation) {
+    return cache->index;
+  }
+
+  for (i = 0; i < prof.num_probes; i++) {
+    if (strcmp(prof.probes[i].name, name) == 0) {
+      break;
+    }
+  }
+
+  if (i == prof.num_probes) {
+    prof.probes = fc_realloc(prof.probes,
+                             (prof.num_probes + 1) * sizeof(*prof.probes));
+    memset(&prof.probes[i], 0, sizeof(prof.probes[i]));
+    prof.probes[i].name = fc_strdup(name);
+    prof.probes[i].type = type;
+    prof.num_probes++;
+  }
+
+  cache->generation = prof.generation;
+  cache->index = i;
+
+  return i;
+}
+
+/*******************************************************************//**
+  Add one observation to a sample.
+***********************************************************************/
+static void prof_sample_add(struct prof_sample *sample, double value)
+{
+  sample->count++;
+  sample->value += value;
+  if (value > sample->max) {
+    sample->max = value;
+  }
+}
+
+/*******************************************************************//**
+  Enable or disable the profiling probes.  Values collected so far are
+  kept.
+***********************************************************************/
+void prof_set_enabled(bool enabled)
+{
+  prof.enabled = enabled;
+}
+
+/*******************************************************************//**
+  Return whether the profiling probes are collecting values.
+***********************************************************************/
+bool prof_is_enabled(void)
+{
+  return prof.enabled;
+}
+
+/*******************************************************************//**
+  Forget all values collected by the profiling probes.
+***********************************************************************/
+void prof_reset(void)
+{
+  int i;
+
+  for (i = 0; i < prof.num_probes; i++) {
+    memset(&prof.probes[i].current, 0, sizeof(prof.probes[i].current));
+    memset(prof.probes[i].history, 0, sizeof(prof.probes[i].history));
+    memset(&prof.probes[i].total, 0, sizeof(prof.probes[i].total));
+  }
+  prof.num_turns = 0;
+  prof.last = PROF_HISTORY_SIZE - 1;
+}
+
+/*******************************************************************//**
+  Free all profiling probes.  Call sites look their probe up again on
+  next use.
+***********************************************************************/
+void prof_free(void)
+{
+  int i;
+
+  for (i = 0; i < prof.num_probes; i++) {
+    free(prof.probes[i].name);
+  }
+  free(prof.probes);
+  prof.probes = NULL;
+  prof.num_probes = 0;
+  prof.num_turns = 0;
+  prof.last = PROF_HISTORY_SIZE - 1;
+  prof.generation++;
+}
+
+/*******************************************************************//**
+  Start timing a scope for the timer probe 'name'.  Use
+  PROF_SCOPE_BEGIN() rather than calling this directly.
+***********************************************************************/
+void prof_scope_begin(struct prof_scope *scope, struct prof_cache *cache,
+                      const char *name)
+{
+  if (!prof.enabled) {
+    scope->index = -1;
+    return;
+  }
+
+  scope->generation = prof.generation;
+  scope->index = prof_probe_index(cache, name, PROF_TIMER);
+  scope->start = prof_clock();
+}
+
+/*******************************************************************//**
+  Stop timing a scope started with prof_scope_begin().
+***********************************************************************/
+void prof_scope_end(struct prof_scope *scope)
+{
+  if (scope->index < 0 || scope->generation != prof.generation) {
+    return;
+  }
+
+  prof_sample_add(&prof.probes[scope->index].current,
+                  MAX(prof_clock() - scope->start, 0.0));
+}
+
+/*******************************************************************//**
+  Add 'amount' to the counter probe 'name'.  Use PROF_COUNT() rather
+  than calling this directly.
+***********************************************************************/
+void prof_count_add(struct prof_cache *cache, const char *name, int amount)
+{
+  int index;
+
+  if (!prof.enabled) {
+    return;
+  }
+
+  /* May reallocate prof.probes. */
+  index = prof_probe_index(cache, name, PROF_COUNTER);
+  prof_sample_add(&prof.probes[index].current, amount);
+}
+
+/*******************************************************************//**
+  Close the values collected for 'turn' into the history.
+***********************************************************************/
+void prof_turn_end(int turn)
+{
+  int i;
+
+  if (!prof.enabled) {
+    return;
+  }
+
+  prof.last = (prof.last + 1) % PROF_HISTORY_SIZE;
+  prof.turns[prof.last] = turn;
+  if (prof.num_turns < PROF_HISTORY_SIZE) {
+    prof.num_turns++;
+  }
+
+  for (i = 0; i < prof.num_probes; i++) {
+    struct prof_probe *probe = &prof.probes[i];
+
+    probe->history[prof.last] = probe->current;
+    probe->total.count += probe->current.count;
+    probe->total.value += probe->current.value;
+    probe->total.max = MAX(probe->total.max, probe->current.max);
+    memset(&probe->current, 0, sizeof(probe->current));
+  }
+}
+
+/*******************************************************************//**
+  Return the history slot of the n:th recorded turn, oldest first.
+***********************************************************************/
+static int prof_history_slot(int n)
+{
+  return (prof.last - prof.num_turns + 1 + n + PROF_HISTORY_SIZE)
+         % PROF_HISTORY_SIZE;
+}
+
+/*******************************************************************//**
+  Report the probes whose name starts with 'prefix' (all if NULL), one
+  line at a time, for the latest recorded turn and on average over the
+  recorded turns.  Times are in milliseconds.
+***********************************************************************/
+void prof_report(const char *prefix, prof_output_fn output, void *data)
+{
+  char line[256];
+  int i, n;
+
+  if (prof.num_turns == 0) {
+    output("No turns recorded.", data);
+    return;
+  }
+
+  fc_snprintf(line, sizeof(line), "Last turn %d, %d turns recorded.",
+              prof.turns[prof.last], prof.num_turns);
+  output(line, data);
+  fc_snprintf(line, sizeof(line), "%-32s %8s %10s %10s %10s",
+              "probe", "count", "value", "max", "avg/turn");
+  output(line, data);
+
+  for (i = 0; i < prof.num_probes; i++) {
+    const struct prof_probe *probe = &prof.probes[i];
+    const struct prof_sample *last = &probe->history[prof.last];
+    double scale = (probe->type == PROF_TIMER ? 1000.0 : 1.0);
+    double sum = 0.0;
+
+    if (prefix != NULL
+        && strncmp(probe->name, prefix, strlen(prefix)) != 0) {
+      continue;
+    }
+
+    for (n = 0; n < prof.num_turns; n++) {
+      sum += probe->history[prof_history_slot(n)].value;
+    }
+
+    fc_snprintf(line, sizeof(line), "%-32s %8d %10.2f %10.2f %10.2f%s",
+                probe->name, last->count, last->value * scale,
+                last->max * scale, sum * scale / prof.num_turns,
+                probe->type == PROF_TIMER ? " ms" : "");
+    output(line, data);
+  }
+}
+
+/*******************************************************************//**
+  Write a string quoted for CSV or JSON output.
+***********************************************************************/
+static void prof_write_string(FILE *f, const char *str,
+                              enum prof_export_format format)
+{
+  fputc('"', f);
+  for (; *str != '\0'; str++) {
+    if (*str == '"') {
+      fputs(format == PROF_EXPORT_JSON ? "\\\"" : "\"\"", f);
+    } else if (*str == '\\' && format == PROF_EXPORT_JSON) {
+      fputs("\\\\", f);
+    } else {
+      fputc(*str, f);
+    }
+  }
+  fputc('"', f);
+}
+
+/*******************************************************************//**
+  Write the recorded turns, oldest first, to 'filename'.  Times are in
+  milliseconds.  Returns FALSE if the file could not be written.
+***********************************************************************/
+bool prof_export(const char *filename, enum prof_export_format format)
+{
+  FILE *f = fc_fopen(filename, "w");
+  int i, n;
+
+  if (f == NULL) {
+    return FALSE;
+  }
+
+  if (format == PROF_EXPORT_CSV) {
+    fputs("turn,probe,type,count,value,max\n", f);
+  } else {
+    fputs("{\"turns\":[", f);
+  }
+
+  for (n = 0; n < prof.num_turns; n++) {
+    int slot = prof_history_slot(n);
+
+    if (format == PROF_EXPORT_JSON) {
+      fprintf(f, "%s\n{\"turn\":%d,\"probes\":[", n > 0 ? "," : "",
+              prof.turns[slot]);
+    }
+
+    for (i = 0; i < prof.num_probes; i++) {
+      const struct prof_probe *probe = &prof.probes[i];
+      const struct prof_sample *sample = &probe->history[slot];
+      double scale = (probe->type == PROF_TIMER ? 1000.0 : 1.0);
+      const char *type = (probe->type == PROF_TIMER ? "timer" : "counter");
+
+      if (format == PROF_EXPORT_CSV) {
+        fprintf(f, "%d,", prof.turns[slot]);
+        prof_write_string(f, probe->name, format);
+        fprintf(f, ",%s,%d,%.3f,%.3f\n", type, sample->count,
+                sample->value * scale, sample->max * scale);
+      } else {
+        fputs(i > 0 ? ",{\"name\":" : "{\"name\":", f);
+        prof_write_string(f, probe->name, format);
+        fprintf(f, ",\"type\":\"%s\",\"count\":%d,\"value\":%.3f,"
+                "\"max\":%.3f}", type, sample->count,
+                sample->value * scale, sample->max * scale);
+      }
+    }
+
+    if (format == PROF_EXPORT_JSON) {
+      fputs("]}", f);
+    }
+  }
+
+  if (format == PROF_EXPORT_JSON) {
+    fputs("\n]}\n", f);
+  }
+
+  return fclose(f) == 0;
+}
+
+/*******************************************************************//**
+  Write the totals of all probes over all turns since the last reset
+  as a JSON array to 'f'.  Times are in milliseconds.
+***********************************************************************/
+void prof_write_totals(FILE *f)
+{
+  int i;
+
+  fputc('[', f);
+  for (i = 0; i < prof.num_probes; i++) {
+    const struct prof_probe *probe = &prof.probes[i];
+    double scale = (probe->type == PROF_TIMER ? 1000.0 : 1.0);
+
+    fputs(i > 0 ? ",\n{\"name\":" : "\n{\"name\":", f);
+    prof_write_string(f, probe->name, PROF_EXPORT_JSON);
+    fprintf(f, ",\"type\":\"%s\",\"count\":%d,\"value\":%.3f,"
+            "\"max\":%.3f}",
+            probe->type == PROF_TIMER ? "timer" : "counter",
+            probe->total.count, probe->total.value * scale,
+            probe->total.max * scale);
+  }
+  fputs("\n]", f);
+}
@@ -20,6 +20,8 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#include <stdio.h>
+
 #include "support.h"            /* bool type */
 
 /* Undefine this if you don't want timing measurements to appear in logs.
@@ -84,6 +86,74 @@ double timer_read_seconds(struct timer *t);
 
 void timer_usleep_since_start(struct timer *t, long usec);
 
+/* Named profiling probes.  A probe is either a timer, accumulating the
+ * wall clock time spent in a scope, or a counter.  Probes are looked up
+ * by name on first use and their values are aggregated per turn; the
+ * last PROF_HISTORY_SIZE turns are kept.  When profiling is disabled a
+ * probe costs one function call and a test.  Probes are not thread safe
+ * and must only be used from the main thread. */
+#define PROF_HISTORY_SIZE 64
+
+enum prof_probe_type {
+  PROF_TIMER,
+  PROF_COUNTER
+};
+
+enum prof_export_format {
+  PROF_EXPORT_CSV,
+  PROF_EXPORT_JSON
+};
+
+/* Per call site lookup cache of a probe. */
+struct prof_cache {
+  int generation;
+  int index;
+};
+
+struct prof_scope {
+  int generation;
+  int index;
+  double start;
+};
+
+typedef void (*prof_output_fn)(const char *line, void *data);
+
+void prof_set_enabled(bool enabled);
+bool prof_is_enabled(void);
+void prof_reset(void);
+void prof_free(void);
+
+void prof_scope_begin(struct prof_scope *scope, struct prof_cache *cache,
+                      const char *name);
+void prof_scope_end(struct prof_scope *scope);
+void prof_count_add(struct prof_cache *cache, const char *name, int amount);
+
+void prof_turn_end(int turn);
+void prof_report(const char *prefix, prof_output_fn output, void *data);
+bool prof_export(const char *filename, enum prof_export_format format);
+void prof_write_totals(FILE *f);
+
+/* Time the enclosed block with the timer probe '_name'.  The block must
+ * not be left by return, break or goto. */
+#define PROF_SCOPE_BEGIN(_name)                                             \
+{                                                                           \
+  static struct prof_cache _prof_cache_ = { 0, -1 };                        \
+  struct prof_scope _prof_scope_;                                           \
+                                                                            \
+  prof_scope_begin(&_prof_scope_, &_prof_cache_, _name);
+
+#define PROF_SCOPE_END                                                      \
+  prof_scope_end(&_prof_scope_);                                            \
+}
+
+/* Add '_amount' to the counter probe '_name'. */
+#define PROF_COUNT(_name, _amount)                                          \
+{                                                                           \
+  static struct prof_cache _prof_cache_ = { 0, -1 };                        \
+                                                                            \
+  prof_count_add(&_prof_cache_, _name, _amount);                            \
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */